@@ -0,0 +1,204 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <PipelineBenchmark.hpp>
+#include <OSDBlendBenchmark.hpp>
+
+#include <QMPlay2Core.hpp>
+#include <Settings.hpp>
+#include <Version.hpp>
+
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QApplication>
+#include <QDirIterator>
+#include <QRegularExpression>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+
+#include <algorithm>
+#include <cstdio>
+
+class BenchmarkCore final : public QMPlay2CoreClass
+{
+public:
+    QWidget *getVideoDock() const override
+    {
+        return nullptr;
+    }
+    QWidget *getMainWindow() const override
+    {
+        return nullptr;
+    }
+};
+
+static QStringList getCorpusFiles(const QStringList &paths)
+{
+    QStringList files;
+    for (const QString &path : paths)
+    {
+        const QFileInfo info(path);
+        if (info.isFile())
+        {
+            files += info.absoluteFilePath();
+        }
+        else if (info.isDir())
+        {
+            QStringList dirFiles;
+            QDirIterator it(info.absoluteFilePath(), QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                dirFiles += it.next();
+            std::sort(dirFiles.begin(), dirFiles.end());
+            files += dirFiles;
+        }
+        else
+        {
+            fprintf(stderr, "File not found: %s\n", path.toLocal8Bit().constData());
+        }
+    }
+    return files;
+}
+
+static bool writeJson(const QCommandLineParser &parser, const QJsonObject &json)
+{
+    const QByteArray jsonData = QJsonDocument(json).toJson();
+    if (parser.isSet("output"))
+    {
+        QFile f(parser.value("output"));
+        if (!f.open(QFile::WriteOnly) || f.write(jsonData) != jsonData.size())
+        {
+            fprintf(stderr, "Can't write: %s\n", f.fileName().toLocal8Bit().constData());
+            return false;
+        }
+    }
+    else
+    {
+        fwrite(jsonData.constData(), 1, jsonData.size(), stdout);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // No display is needed
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("QMPlay2Benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures QMPlay2 demuxing, decoding and filtering throughput without audio and video output. Results are printed as JSON.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"profile", "Settings profile used for decoders and filters configuration.", "name", "Benchmark"},
+        {"lib-dir", "Directory which contains QMPlay2 \"modules\" directory.", "path"},
+        {"limit", "Process only first N seconds of every file.", "seconds"},
+        {"output", "Write JSON into the file instead of the standard output.", "file"},
+        {"no-video", "Don't decode video."},
+        {"no-audio", "Don't decode audio."},
+        {"no-filters", "Don't use video and audio filters."},
+        {"osd-blend", "Measure OSD compositing kernels on a frame of given size (e.g. 3840x2160:100) instead of media files.", "WxH:frames"},
+    });
+    parser.addPositionalArgument("files", "Media files or directories with media files.", "<files...>");
+    parser.process(app);
+
+    if (parser.isSet("osd-blend"))
+    {
+        const QStringList args = parser.value("osd-blend").split(QRegularExpression("[x:]"));
+        const int width = args.value(0).toInt();
+        const int height = args.value(1).toInt();
+        const int frames = args.value(2, "100").toInt();
+        if (width < 2 || height < 2 || frames < 1)
+            parser.showHelp(1);
+        return writeJson(parser, OSDBlendBenchmark::run(width, height, frames)) ? 0 : 1;
+    }
+
+    const QStringList files = getCorpusFiles(parser.positionalArguments());
+    if (files.isEmpty())
+        parser.showHelp(1);
+
+    const QString appDir = QCoreApplication::applicationDirPath();
+    QString libPath = parser.value("lib-dir");
+    QString sharePath = appDir + "/../share/qmplay2";
+    bool modulesInSubdirs = false;
+    if (libPath.isEmpty())
+    {
+        if (QDir(appDir).exists("CMakeFiles/QMPlay2Benchmark.dir"))
+        {
+            // CMake non-installed build
+            libPath = appDir + "/..";
+            sharePath = appDir + "/../..";
+            modulesInSubdirs = true;
+        }
+        else
+        {
+            libPath = appDir + "/../lib/qmplay2";
+        }
+    }
+
+    BenchmarkCore core;
+    const QString profile = parser.value("profile");
+
+    // Use the legacy renderer, so GPU is not initialized
+    QMPlay2Core.init(false, modulesInSubdirs, libPath, sharePath, profile);
+    QMPlay2Core.getSettings().set("Renderer", "legacy");
+    QMPlay2Core.quit();
+
+    QMPlay2Core.init(true, modulesInSubdirs, libPath, sharePath, profile);
+
+    PipelineBenchmark::Options options;
+    options.video = !parser.isSet("no-video");
+    options.audio = !parser.isSet("no-audio");
+    options.filters = !parser.isSet("no-filters");
+    options.limit = parser.value("limit").toDouble();
+
+    PipelineBenchmark benchmark(options);
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    QJsonArray results;
+    bool hasErrors = false;
+    for (const QString &file : files)
+    {
+        fprintf(stderr, "%s\n", file.toLocal8Bit().constData());
+        const QJsonObject result = benchmark.run(file);
+        if (result.contains("error"))
+            hasErrors = true;
+        results.append(result);
+    }
+
+    QJsonObject json;
+    json["version"] = QString(Version::get());
+    json["profile"] = profile;
+    json["limit"] = options.limit;
+    json["filters"] = options.filters;
+    json["totalMs"] = totalTimer.nsecsElapsed() / 1e6;
+    json["files"] = results;
+
+    if (!writeJson(parser, json))
+        hasErrors = true;
+
+    QMPlay2Core.quit();
+
+    return hasErrors ? 1 : 0;
+}
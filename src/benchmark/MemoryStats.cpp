@@ -0,0 +1,92 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <MemoryStats.hpp>
+
+#include <QFile>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<quint64> g_allocationsCount {0};
+static std::atomic<quint64> g_allocationsBytes {0};
+
+void *operator new(std::size_t size)
+{
+    g_allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocationsBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+/**/
+
+MemoryStats::Allocations MemoryStats::allocations()
+{
+    Allocations allocations;
+    allocations.count = g_allocationsCount.load(std::memory_order_relaxed);
+    allocations.bytes = g_allocationsBytes.load(std::memory_order_relaxed);
+    return allocations;
+}
+
+qint64 MemoryStats::peakKiB()
+{
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/status");
+    if (f.open(QFile::ReadOnly | QFile::Text))
+    {
+        for (const QByteArray &line : f.readAll().split('\n'))
+        {
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+        }
+    }
+#endif
+    return -1;
+}
+void MemoryStats::resetPeak()
+{
+#ifdef Q_OS_LINUX
+    // Resets "VmHWM" to the current resident set size
+    QFile f("/proc/self/clear_refs");
+    if (f.open(QFile::WriteOnly))
+        f.write("5");
+#endif
+}
@@ -0,0 +1,39 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+// Heap usage of the benchmark process. Allocations are counted by replaced
+// global "operator new", so memory allocated directly by C libraries (e.g.
+// FFmpeg) is not included there, but it's included in the memory peak.
+namespace MemoryStats
+{
+    struct Allocations
+    {
+        quint64 count = 0;
+        quint64 bytes = 0;
+    };
+
+    Allocations allocations();
+
+    // Peak resident set size in KiB, -1 if not supported
+    qint64 peakKiB();
+    void resetPeak();
+}
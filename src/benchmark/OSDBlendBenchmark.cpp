@@ -0,0 +1,146 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <OSDBlendBenchmark.hpp>
+
+#include <OSDBlend.hpp>
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QVector>
+
+#include <algorithm>
+#include <random>
+
+namespace OSDBlendBenchmark {
+
+struct Bitmap
+{
+    int x, y, w, h;
+    quint32 color;
+    QVector<quint8> alpha;
+};
+
+// Glyph-like bitmaps: short opaque runs with antialiased edges, a few lines of text at the bottom
+static QVector<Bitmap> createBitmaps(int width, int height)
+{
+    std::mt19937 rng(0);
+    QVector<Bitmap> bitmaps;
+
+    const int lineH = qMax(height / 14, 8);
+    const int lines = 4;
+    const int lineW = width * 9 / 10;
+    for (int l = 0; l < lines; ++l)
+    {
+        const int y = height - (lines - l) * lineH - lineH / 2;
+        // Outline (shadow) and fill layers like in libass output
+        for (quint32 color : {0xFF000000u, 0xFFFFFFFFu})
+        {
+            Bitmap bitmap {(width - lineW) / 2, y, lineW, lineH, color, {}};
+            bitmap.alpha.resize(bitmap.w * bitmap.h);
+            for (int i = 0; i < bitmap.alpha.size(); ++i)
+            {
+                const quint32 r = rng();
+                bitmap.alpha[i] = (r & 3) ? 0 : ((r & 4) ? 255 : (r >> 8) & 0xFF);
+            }
+            bitmaps.append(std::move(bitmap));
+        }
+    }
+    return bitmaps;
+}
+
+static double expandAlpha(const OSDBlend::Kernels &kernels, const QVector<Bitmap> &bitmaps, QVector<quint32> &osd, int width)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<quint32> rgba;
+    for (const Bitmap &bitmap : bitmaps)
+    {
+        rgba.resize(bitmap.w * bitmap.h);
+        for (int y = 0; y < bitmap.h; ++y)
+            kernels.expandAlpha(rgba.data() + y * bitmap.w, bitmap.alpha.constData() + y * bitmap.w, bitmap.w, bitmap.color);
+
+        // Keep the last layer, it's only the input for blending
+        for (int y = 0; y < bitmap.h; ++y)
+            std::copy_n(rgba.constData() + y * bitmap.w, bitmap.w, osd.data() + (bitmap.y + y) * width + bitmap.x);
+    }
+
+    return timer.nsecsElapsed() / 1e6;
+}
+
+static double blend(const OSDBlend::Kernels &kernels, const QVector<quint32> &osd, QVector<quint8> &frame, int width, int height, int top)
+{
+    quint8 *dataY = frame.data();
+    quint8 *dataV = dataY + width * height;
+    quint8 *dataU = dataV + (width / 2) * (height / 2);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int h = top; h + 1 < height; h += 2)
+    {
+        const quint32 *src0 = osd.constData() + h * width;
+        const quint32 *src1 = src0 + width;
+        kernels.blendLuma(dataY + h * width, src0, width);
+        kernels.blendLuma(dataY + (h + 1) * width, src1, width);
+        kernels.blendChroma(dataU + (h / 2) * (width / 2), dataV + (h / 2) * (width / 2), src0, src1, width / 2);
+    }
+
+    return timer.nsecsElapsed() / 1e6;
+}
+
+QJsonObject run(int width, int height, int frames)
+{
+    width &= ~1;
+    height &= ~1;
+
+    const QVector<Bitmap> bitmaps = createBitmaps(width, height);
+    const int top = bitmaps.constFirst().y & ~1;
+
+    QJsonArray results;
+    for (const OSDBlend::Kernels *kernels : OSDBlend::availableKernels())
+    {
+        QVector<quint32> osd(width * height);
+        QVector<quint8> frame(width * height * 3 / 2, 128);
+
+        double expandMs = 0.0, blendMs = 0.0;
+        for (int i = 0; i < frames; ++i)
+        {
+            expandMs += expandAlpha(*kernels, bitmaps, osd, width);
+            blendMs += blend(*kernels, osd, frame, width, height, top);
+        }
+
+        QJsonObject result;
+        result["kernels"] = QString(kernels->name);
+        result["expandAlphaMs"] = expandMs / frames;
+        result["blendMs"] = blendMs / frames;
+        result["frameMs"] = (expandMs + blendMs) / frames;
+        results.append(result);
+    }
+
+    QJsonObject json;
+    json["width"] = width;
+    json["height"] = height;
+    json["frames"] = frames;
+    json["osdLines"] = height - top;
+    json["kernels"] = results;
+    return json;
+}
+
+}
@@ -0,0 +1,31 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QJsonObject>
+
+/*
+ * Measures OSD compositing kernels used by CPU video outputs: libass bitmaps
+ * expansion and blending into YV12 frame. Every available implementation is
+ * run on the same synthetic frame with dense subtitles.
+ */
+namespace OSDBlendBenchmark
+{
+    QJsonObject run(int width, int height, int frames);
+}
@@ -0,0 +1,402 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <PipelineBenchmark.hpp>
+#include <MemoryStats.hpp>
+
+#include <QMPlay2Core.hpp>
+#include <VideoFilter.hpp>
+#include <AudioFilter.hpp>
+#include <StreamInfo.hpp>
+#include <Functions.hpp>
+#include <Settings.hpp>
+#include <Demuxer.hpp>
+#include <Decoder.hpp>
+#include <Module.hpp>
+#include <Packet.hpp>
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QQueue>
+
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Stage
+{
+    Stage(const QString &name)
+        : name(name)
+    {}
+
+    QJsonObject toJson() const
+    {
+        const double seconds = elapsedNs / 1e9;
+        QJsonObject json;
+        json["name"] = name;
+        json["frames"] = count;
+        json["totalMs"] = elapsedNs / 1e6;
+        json["fps"] = (seconds > 0.0) ? count / seconds : 0.0;
+        json["usPerFrame"] = (count > 0) ? elapsedNs / 1e3 / count : 0.0;
+        return json;
+    }
+
+    QString name;
+    qint64 elapsedNs = 0;
+    qint64 count = 0; // Packets for demuxer, frames for video, decoded chunks for audio
+};
+
+class StageTimer
+{
+public:
+    inline StageTimer(Stage &stage)
+        : m_stage(stage)
+    {
+        m_timer.start();
+    }
+    inline ~StageTimer()
+    {
+        m_stage.elapsedNs += m_timer.nsecsElapsed();
+    }
+
+private:
+    Stage &m_stage;
+    QElapsedTimer m_timer;
+};
+
+struct VideoFilterStage
+{
+    shared_ptr<VideoFilter> filter;
+    Stage stage;
+};
+
+shared_ptr<VideoFilter> createVideoFilter(const QString &filterName, int w, int h, const std::function<void(VideoFilter *)> &setParams = nullptr)
+{
+    for (Module *module : QMPlay2Core.getPluginsInstance())
+    {
+        for (const Module::Info &mod : module->getModulesInfo())
+        {
+            if ((mod.type & 0xF) != Module::VIDEOFILTER || mod.name != filterName)
+                continue;
+            shared_ptr<VideoFilter> filter(reinterpret_cast<VideoFilter *>(module->createInstance(mod.name)));
+            if (!filter)
+                return nullptr;
+            if (setParams)
+                setParams(filter.get());
+            filter->modParam("W", w);
+            filter->modParam("H", h);
+            if (!filter->processParams())
+                return nullptr;
+            return filter;
+        }
+    }
+    return nullptr;
+}
+
+// The same chain as "VideoThr" creates for software decoding
+vector<VideoFilterStage> createVideoFilters(int w, int h)
+{
+    Settings &QMPSettings = QMPlay2Core.getSettings();
+    vector<VideoFilterStage> filters;
+
+    if (QMPSettings.getBool("Deinterlace/ON"))
+    {
+        const bool autoDeint = QMPSettings.getBool("Deinterlace/Auto");
+        const bool doubleFramerate = QMPSettings.getBool("Deinterlace/Doubler");
+        const bool autoParity = QMPSettings.getBool("Deinterlace/AutoParity");
+        const bool topFieldFirst = QMPSettings.getBool("Deinterlace/TFF");
+        const quint8 deintFlags = autoDeint | doubleFramerate << 1 | autoParity << 2 | topFieldFirst << 3;
+        const QString deintFilterName = QMPSettings.getString("Deinterlace/SoftwareMethod");
+        auto deintFilter = createVideoFilter(deintFilterName, w, h, [&](VideoFilter *filter) {
+            filter->modParam("DeinterlaceFlags", deintFlags);
+        });
+        if (deintFilter)
+            filters.push_back({deintFilter, Stage("videoFilter/" + deintFilterName)});
+    }
+
+    for (QString filterName : QMPSettings.getStringList("VideoFilters"))
+    {
+        if (!filterName.left(1).toInt()) // Filter is disabled
+            continue;
+        filterName = filterName.mid(1);
+        if (auto filter = createVideoFilter(filterName, w, h))
+            filters.push_back({filter, Stage("videoFilter/" + filterName)});
+    }
+
+    return filters;
+}
+
+}
+
+/**/
+
+PipelineBenchmark::PipelineBenchmark(const Options &options)
+    : m_options(options)
+{}
+
+QJsonObject PipelineBenchmark::run(const QString &filePath)
+{
+    QJsonObject result;
+    result["file"] = filePath;
+
+    MemoryStats::resetPeak();
+    const MemoryStats::Allocations allocationsBegin = MemoryStats::allocations();
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    IOController<Demuxer> demuxerController;
+    if (!Demuxer::create(Functions::Url(filePath), demuxerController))
+    {
+        result["error"] = "Cannot open file";
+        return result;
+    }
+    Demuxer *demuxer = demuxerController.rawPtr();
+    result["demuxer"] = demuxer->name();
+    result["openMs"] = totalTimer.nsecsElapsed() / 1e6;
+
+    const QList<StreamInfo *> streams = demuxer->streamsInfo();
+    int videoStream = -1, audioStream = -1;
+    for (int i = 0; i < streams.count(); ++i)
+    {
+        const AVMediaType type = streams[i]->params->codec_type;
+        if (type == AVMEDIA_TYPE_VIDEO && videoStream < 0 && m_options.video)
+            videoStream = i;
+        else if (type == AVMEDIA_TYPE_AUDIO && audioStream < 0 && m_options.audio)
+            audioStream = i;
+    }
+
+    const QStringList decoders = QMPlay2Core.getModules("decoders", 7);
+
+    unique_ptr<Decoder> videoDec, audioDec;
+    if (videoStream > -1)
+    {
+        QString decoderName;
+        videoDec.reset(Decoder::create(*streams[videoStream], decoders, &decoderName));
+        if (videoDec)
+        {
+            // 8-bit planar YUV formats which every renderer can display
+            videoDec->setSupportedPixelFormats({
+                AV_PIX_FMT_YUV420P,
+                AV_PIX_FMT_YUVJ420P,
+                AV_PIX_FMT_YUV422P,
+                AV_PIX_FMT_YUVJ422P,
+                AV_PIX_FMT_YUV444P,
+                AV_PIX_FMT_YUVJ444P,
+                AV_PIX_FMT_YUV410P,
+                AV_PIX_FMT_YUV411P,
+                AV_PIX_FMT_YUVJ411P,
+                AV_PIX_FMT_YUV440P,
+                AV_PIX_FMT_YUVJ440P,
+            });
+            result["videoDecoder"] = decoderName;
+            result["videoCodec"] = QString(streams[videoStream]->codec_name);
+        }
+        else
+        {
+            videoStream = -1;
+        }
+    }
+    if (audioStream > -1)
+    {
+        QString decoderName;
+        audioDec.reset(Decoder::create(*streams[audioStream], decoders, &decoderName));
+        if (audioDec)
+        {
+            result["audioDecoder"] = decoderName;
+            result["audioCodec"] = QString(streams[audioStream]->codec_name);
+        }
+        else
+        {
+            audioStream = -1;
+        }
+    }
+
+    Stage demuxStage("demux");
+    Stage videoDecodeStage("videoDecode");
+    Stage audioDecodeStage("audioDecode");
+
+    vector<VideoFilterStage> videoFilters;
+    int videoW = 0, videoH = 0;
+
+    vector<pair<unique_ptr<AudioFilter>, Stage>> audioFilters;
+    quint8 audioChannels = 0;
+    quint32 audioSampleRate = 0;
+    qint64 audioSamples = 0;
+
+    if (audioDec && m_options.filters)
+    {
+        for (AudioFilter *filter : AudioFilter::open())
+            audioFilters.emplace_back(filter, Stage("audioFilter/" + filter->name()));
+    }
+
+    const auto filterVideoFrame = [&](const Frame &decoded) {
+        if (decoded.width() != videoW || decoded.height() != videoH)
+        {
+            videoW = decoded.width();
+            videoH = decoded.height();
+            if (m_options.filters)
+                videoFilters = createVideoFilters(videoW, videoH);
+        }
+        QQueue<Frame> queue;
+        queue.enqueue(decoded);
+        for (VideoFilterStage &videoFilter : videoFilters)
+        {
+            QQueue<Frame> outputQueue;
+            bool pending = false;
+            do
+            {
+                StageTimer timer(videoFilter.stage);
+                pending = videoFilter.filter->filter(queue);
+                if (queue.isEmpty())
+                    pending = false;
+                videoFilter.stage.count += queue.count();
+                outputQueue.append(queue);
+                queue.clear();
+            } while (pending);
+            queue.swap(outputQueue);
+        }
+        // Filtered frames are dropped here
+    };
+    const Packet emptyPacket;
+    // One packet per call like in "VideoThr", frames left in the decoder are taken by the next call.
+    // An empty packet drains the decoder, so it's used only for the final flush.
+    const auto decodeVideo = [&](const Packet &packet) {
+        Frame decoded;
+        AVPixelFormat newPixelFormat = AV_PIX_FMT_NONE;
+        {
+            StageTimer timer(videoDecodeStage);
+            videoDec->decodeVideo(packet, decoded, newPixelFormat, false, 0);
+        }
+        if (decoded.isEmpty())
+            return false;
+        ++videoDecodeStage.count;
+        filterVideoFrame(decoded);
+        return true;
+    };
+    const auto filterAudio = [&](QByteArray &decoded, quint8 channels, quint32 sampleRate) {
+        if (channels && sampleRate && (channels != audioChannels || sampleRate != audioSampleRate))
+        {
+            audioChannels = channels;
+            audioSampleRate = sampleRate;
+            for (auto &&audioFilter : audioFilters)
+                audioFilter.first->setAudioParameters(audioChannels, audioSampleRate);
+        }
+        if (audioChannels > 0)
+            audioSamples += decoded.size() / sizeof(float) / audioChannels;
+        for (auto &&audioFilter : audioFilters)
+        {
+            StageTimer timer(audioFilter.second);
+            audioFilter.first->filter(decoded);
+            ++audioFilter.second.count;
+        }
+        // Filtered samples are dropped here
+    };
+    const auto decodeAudio = [&](const Packet &packet) {
+        bool gotData = false;
+        do
+        {
+            QByteArray decoded;
+            double ts = qQNaN();
+            quint8 channels = 0;
+            quint32 sampleRate = 0;
+            {
+                StageTimer timer(audioDecodeStage);
+                audioDec->decodeAudio(gotData ? emptyPacket : packet, decoded, ts, channels, sampleRate);
+            }
+            gotData = !decoded.isEmpty();
+            if (gotData)
+            {
+                ++audioDecodeStage.count;
+                filterAudio(decoded, channels, sampleRate);
+            }
+        } while (gotData && audioDec->pendingFrames() > 0);
+        return gotData;
+    };
+
+    for (;;)
+    {
+        Packet packet;
+        int streamIdx = -1;
+        bool ok = false;
+        {
+            StageTimer timer(demuxStage);
+            ok = demuxer->read(packet, streamIdx);
+        }
+        if (!ok)
+            break;
+        ++demuxStage.count;
+
+        if (m_options.limit > 0.0 && packet.isTsValid() && packet.ts() > m_options.limit)
+            break;
+
+        if (streamIdx == videoStream && videoStream > -1)
+            decodeVideo(packet);
+        else if (streamIdx == audioStream && audioStream > -1)
+            decodeAudio(packet);
+    }
+
+    // Drain decoders
+    if (videoDec)
+    {
+        for (int i = 0; i < 1000 && decodeVideo(emptyPacket); ++i);
+    }
+    if (audioDec)
+    {
+        for (int i = 0; i < 1000 && decodeAudio(emptyPacket); ++i);
+    }
+
+    const qint64 totalNs = totalTimer.nsecsElapsed();
+    const MemoryStats::Allocations allocationsEnd = MemoryStats::allocations();
+
+    QJsonArray stagesJson;
+    stagesJson.append(demuxStage.toJson());
+    if (videoDec)
+    {
+        stagesJson.append(videoDecodeStage.toJson());
+        for (const VideoFilterStage &videoFilter : videoFilters)
+            stagesJson.append(videoFilter.stage.toJson());
+    }
+    if (audioDec)
+    {
+        stagesJson.append(audioDecodeStage.toJson());
+        for (auto &&audioFilter : audioFilters)
+            stagesJson.append(audioFilter.second.toJson());
+    }
+    result["stages"] = stagesJson;
+
+    if (videoDec)
+        result["videoSize"] = QString("%1x%2").arg(videoW).arg(videoH);
+    if (audioDec)
+    {
+        result["audioChannels"] = audioChannels;
+        result["audioSampleRate"] = static_cast<qint64>(audioSampleRate);
+        result["audioSamples"] = audioSamples;
+    }
+
+    result["totalMs"] = totalNs / 1e6;
+    result["allocations"] = static_cast<qint64>(allocationsEnd.count - allocationsBegin.count);
+    result["allocatedBytes"] = static_cast<qint64>(allocationsEnd.bytes - allocationsBegin.bytes);
+    const qint64 peakKiB = MemoryStats::peakKiB();
+    result["memoryPeakKiB"] = (peakKiB > -1) ? QJsonValue(peakKiB) : QJsonValue();
+
+    return result;
+}
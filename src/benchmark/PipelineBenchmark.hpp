@@ -0,0 +1,46 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+/*
+ * Runs demuxer, decoders and the configured video and audio filters of one
+ * file as fast as possible. Decoded data is dropped, so no writer is needed.
+ */
+class PipelineBenchmark
+{
+public:
+    struct Options
+    {
+        bool video = true;
+        bool audio = true;
+        bool filters = true;
+        double limit = 0.0; // Seconds of media to process, 0 processes the whole file
+    };
+
+public:
+    PipelineBenchmark(const Options &options);
+
+    QJsonObject run(const QString &filePath);
+
+private:
+    const Options m_options;
+};
@@ -82,7 +82,7 @@ void AVThread::stop(bool _terminate)
 
     br = true;
     mutex.unlock();
-    playC.emptyBufferCond.wakeAll();
+    playC.wakeEmptyBuffer();
 
     if (!wait(TERMINATE_TIMEOUT))
         terminate();
@@ -30,6 +30,7 @@
 
 #include <QCoreApplication>
 
+#include <cstring>
 #include <cmath>
 
 AudioThr::AudioThr(PlayClass &playC, const QStringList &pluginsName) :
@@ -73,6 +74,14 @@ void AudioThr::clearVisualizations()
 
 bool AudioThr::setParams(uchar realChn, uint realSRate, uchar chn, uint sRate, bool resamplerFirst)
 {
+    // Nothing changed (e.g. next entry has the same format), so keep the audio output, the resampler and the filters running for gapless transition
+    if (m_paramsOK && realChn == realChannels && realSRate == realSample_rate && chn == m_forcedChannels && sRate == m_forcedSampleRate && resamplerFirst == m_resamplerFirst && writer->readyWrite())
+        return true;
+
+    m_paramsOK = false;
+    m_forcedChannels = chn;
+    m_forcedSampleRate = sRate;
+
     m_resamplerFirst = resamplerFirst;
 
     doSilence = -1.0;
@@ -116,6 +125,9 @@ bool AudioThr::setParams(uchar realChn, uint realSRate, uchar chn, uint sRate, b
         for (AudioFilter *filter : std::as_const(filters))
             filter->setAudioParameters(currentChannels(), currentSampleRate());
 
+        reserveBuffers();
+
+        m_paramsOK = true;
         return true;
     }
 
@@ -171,7 +183,6 @@ void AudioThr::run()
 {
     setPriority(QThread::HighestPriority);
 
-    QMutex emptyBufferMutex;
     bool paused = false;
     bool oneFrame = false;
     tmp_br = tmp_time = 0;
@@ -181,6 +192,8 @@ void AudioThr::run()
         Decoder *last_dec = dec;
         while (!br && dec == last_dec)
         {
+            const quint64 emptyBufferSeq = playC.emptyBufferWakeSeq();
+
             playC.aPackets.lock();
             const bool hasAPackets = playC.aPackets.canFetch();
             bool hasBufferedSamples = false;
@@ -217,11 +230,12 @@ void AudioThr::run()
                 playC.aPackets.unlock();
 
                 if (!playC.paused)
-                    waiting = playC.fillBufferB = true;
+                {
+                    waiting = true;
+                    playC.requestFillBuffer();
+                }
 
-                emptyBufferMutex.lock();
-                playC.emptyBufferCond.wait(&emptyBufferMutex, MUTEXWAIT_TIMEOUT);
-                emptyBufferMutex.unlock();
+                playC.waitForEmptyBufferWake(emptyBufferSeq);
                 continue;
             }
             if (paused)
@@ -247,7 +261,7 @@ void AudioThr::run()
                 oneFrame = playC.paused = true;
             }
 
-            playC.fillBufferB = true;
+            playC.requestFillBuffer();
 
             mutex.lock();
             if (br)
@@ -256,12 +270,12 @@ void AudioThr::run()
                 break;
             }
 
-            QByteArray decoded;
+            m_decoded.resize(0);
             if (!hasBufferedSamples)
             {
                 quint8 newChannels = 0;
                 quint32 newSampleRate = 0;
-                const int bytesConsumed = dec->decodeAudio(packet, decoded, ts, newChannels, newSampleRate, flushAudio);
+                const int bytesConsumed = dec->decodeAudio(packet, m_decoded, ts, newChannels, newSampleRate, flushAudio);
                 tmp_br += bytesConsumed;
                 if (newChannels && newSampleRate && (newChannels != realChannels || newSampleRate != realSample_rate))
                 {
@@ -283,9 +297,8 @@ void AudioThr::run()
 
             if (m_resamplerFirst && sndResampler.isOpen())
             {
-                QByteArray converted;
-                sndResampler.convert(decoded, converted, hasBufferedSamples);
-                decoded = std::move(converted);
+                sndResampler.convert(m_decoded, m_resampled, hasBufferedSamples);
+                m_decoded.swap(m_resampled);
             }
 
             delay = writer->getParam("delay").toDouble() + sndResampler.getDelay();
@@ -293,12 +306,12 @@ void AudioThr::run()
             {
                 if (flushAudio)
                     filter->clearBuffers();
-                delay += filter->filter(decoded, hasBufferedSamples);
+                delay += filter->filter(m_decoded, hasBufferedSamples);
             }
 
-            if (flushAudio)
+            if (flushAudio && !hasBufferedSamples) // The decoder must be flushed, e.g. reused decoder drained at EOF
                 playC.flushAudio = false;
-            int decodedSize = decoded.size();
+            int decodedSize = m_decoded.size();
             int decodedPos = 0;
             while ((decodedSize > 0 || hasBufferedSamplesInResampler) && (!playC.paused || oneFrame) && !br && !br2)
             {
@@ -325,16 +338,16 @@ void AudioThr::run()
 
                 const bool isMuted = qFuzzyIsNull(vol[0]) && qFuzzyIsNull(vol[1]);
 
-                QByteArray decodedChunk;
+                m_chunk.resize(chunk);
                 if (isMuted)
-                    decodedChunk.fill(0, chunk);
+                    memset(m_chunk.data(), 0, chunk);
                 else
-                    decodedChunk = QByteArray::fromRawData((const char *)decoded.constData() + decodedPos, chunk);
+                    memcpy(m_chunk.data(), m_decoded.constData() + decodedPos, chunk);
 
                 decodedPos += chunk;
                 decodedSize -= chunk;
 
-                playC.audio_last_delay = (double)decodedChunk.size() / (double)(sizeof(float) * currentChannels() * currentSampleRate());
+                playC.audio_last_delay = (double)m_chunk.size() / (double)(sizeof(float) * currentChannels() * currentSampleRate());
                 if (!qIsNaN(ts))
                 {
                     audio_pts = playC.audio_current_pts = ts - delay;
@@ -351,7 +364,7 @@ void AudioThr::run()
                     {
                         tmp_br = 0;
                         playC.audioSeekPos = -1.0;
-                        playC.emptyBufferCond.wakeAll();
+                        playC.wakeEmptyBuffer();
                         if (playC.videoSeekPos <= 0.0)
                             cont = false; // Don't play if video is not ready
                     }
@@ -377,20 +390,19 @@ void AudioThr::run()
 
                     if (!isMuted && (!qFuzzyCompare(vol[0], 1.0f) || !qFuzzyCompare(vol[1], 1.0f)))
                     {
-                        const int size = decodedChunk.size() / sizeof(float);
-                        float *data = (float *)decodedChunk.data();
+                        const int size = m_chunk.size() / sizeof(float);
+                        float *data = (float *)m_chunk.data();
                         for (int i = 0; i < size; ++i)
                             data[i] *= vol[i & 1];
                     }
 
                     for (QMPlay2Extensions *vis : std::as_const(visualizations))
-                        vis->sendSoundData(decodedChunk);
+                        vis->sendSoundData(m_chunk);
 
-                    QByteArray dataToWrite;
-                    if (!m_resamplerFirst && sndResampler.isOpen())
-                        sndResampler.convert(decodedChunk, dataToWrite, hasBufferedSamples);
-                    else
-                        dataToWrite = decodedChunk;
+                    const bool resampleChunk = (!m_resamplerFirst && sndResampler.isOpen());
+                    if (resampleChunk)
+                        sndResampler.convert(m_chunk, m_resampled, hasBufferedSamples);
+                    QByteArray &dataToWrite = resampleChunk ? m_resampled : m_chunk;
 
                     if (doSilence >= 0.0)
                     {
@@ -441,6 +453,18 @@ void AudioThr::run()
     writer->modParam("drain", allowAudioDrain);
 }
 
+void AudioThr::reserveBuffers()
+{
+    // Enough for most audio packets, buffers can still grow if needed
+    const double maxPacketDuration = 0.25;
+    const int maxChannels = qMax(realChannels, channels);
+    const int maxSampleRate = ceil(qMax(realSample_rate, sample_rate) * qMax(1.0, m_lastSpeed));
+    const int size = ceil(maxSampleRate * maxPacketDuration) * maxChannels * sizeof(float);
+    m_decoded.reserve(size);
+    m_resampled.reserve(size);
+    m_chunk.reserve(size);
+}
+
 bool AudioThr::createResampler(bool cleanBuffers)
 {
     const double speed = m_lastSpeed > 0.0 ? m_lastSpeed : 1.0;
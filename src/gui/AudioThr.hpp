@@ -51,6 +51,8 @@ private:
 
     bool createResampler(bool cleanBuffers);
 
+    void reserveBuffers();
+
     inline uchar currentChannels() const;
     inline uint currentSampleRate() const;
 
@@ -58,6 +60,9 @@ private:
     uchar realChannels, channels;
     uint  realSample_rate, sample_rate;
     bool m_resamplerFirst;
+    uchar m_forcedChannels = 0;
+    uint m_forcedSampleRate = 0;
+    bool m_paramsOK = false;
     bool m_lastKeepAudioPitch = false;
     double m_lastSpeed;
 
@@ -67,6 +72,9 @@ private:
     QMutex silenceChMutex;
     bool allowAudioDrain = false;
 
+    // Reused for every packet and chunk, so the steady-state playback doesn't allocate
+    QByteArray m_decoded, m_resampled, m_chunk;
+
     QVector<QMPlay2Extensions *> visualizations;
     QVector<AudioFilter *> filters;
 private slots:
@@ -0,0 +1,98 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <DemuxerPreloader.hpp>
+
+#include <DemuxerThr.hpp>
+#include <Demuxer.hpp>
+
+// Enough to start the playback immediately, "DemuxerThr" fills the buffers as usual
+constexpr double g_preRollDuration = 0.5;
+constexpr int g_preRollMaxPackets = 64;
+
+DemuxerPreloader::DemuxerPreloader(const QString &url)
+    : m_url(url)
+{
+    start(QThread::LowPriority);
+}
+DemuxerPreloader::~DemuxerPreloader()
+{
+    abort();
+    wait();
+}
+
+void DemuxerPreloader::abort()
+{
+    QMutexLocker locker(&m_takeMutex);
+    m_demuxer.abort();
+}
+
+void DemuxerPreloader::release(std::unique_ptr<DemuxerPreloader> &preloader)
+{
+    if (!preloader)
+        return;
+
+    auto preloaderPtr = preloader.release();
+    preloaderPtr->abort();
+    connect(preloaderPtr, &QThread::finished, preloaderPtr, &QObject::deleteLater);
+    if (preloaderPtr->isFinished())
+        preloaderPtr->deleteLater();
+}
+
+bool DemuxerPreloader::take(IOController<Demuxer> &demuxer, QStringList &fileSubsList, PreRolledPackets &preRolledPackets)
+{
+    wait();
+
+    QMutexLocker locker(&m_takeMutex);
+    if (!m_demuxer || m_demuxer.isAborted())
+        return false;
+
+    demuxer.swap(m_demuxer);
+    fileSubsList = std::move(m_fileSubsList);
+    preRolledPackets = std::move(m_preRolledPackets);
+    return true;
+}
+
+void DemuxerPreloader::run()
+{
+    if (!Demuxer::create(m_url, m_demuxer) || m_demuxer.isAborted())
+        return;
+
+    m_fileSubsList = DemuxerThr::findFileSubs(m_url, m_demuxer->streamsInfo());
+
+    double minTs = qQNaN(), maxTs = qQNaN();
+    while (m_preRolledPackets.size() < g_preRollMaxPackets && !m_demuxer.isAborted())
+    {
+        Packet packet;
+        int streamIdx = -1;
+        if (!m_demuxer->read(packet, streamIdx))
+            break;
+        if (streamIdx < 0)
+            continue;
+
+        if (packet.isTsValid())
+        {
+            minTs = qIsNaN(minTs) ? packet.ts() : qMin(minTs, packet.ts());
+            maxTs = qIsNaN(maxTs) ? packet.ts() : qMax(maxTs, packet.ts());
+        }
+        m_preRolledPackets.append({streamIdx, packet});
+
+        if (maxTs - minTs >= g_preRollDuration)
+            break;
+    }
+}
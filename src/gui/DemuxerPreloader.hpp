@@ -0,0 +1,67 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <IOController.hpp>
+#include <Packet.hpp>
+
+#include <QStringList>
+#include <QThread>
+#include <QMutex>
+#include <QVector>
+#include <QPair>
+
+#include <memory>
+
+class Demuxer;
+
+/*
+ * Opens the next playlist entry in background while the current one is still playing
+ * and reads its first packets. "DemuxerThr" takes everything over if the entry is played.
+ */
+class DemuxerPreloader final : public QThread
+{
+public:
+    using PreRolledPackets = QVector<QPair<int, Packet>>; // Stream index and packet
+
+    DemuxerPreloader(const QString &url);
+    ~DemuxerPreloader();
+
+    inline QString url() const
+    {
+        return m_url;
+    }
+
+    void abort(); // Thread-safe
+
+    // Aborts the preloader and deletes it when its thread finishes, doesn't block
+    static void release(std::unique_ptr<DemuxerPreloader> &preloader);
+
+    // Waits for the thread, returns "false" if the entry can't be opened
+    bool take(IOController<Demuxer> &demuxer, QStringList &fileSubsList, PreRolledPackets &preRolledPackets);
+
+private:
+    void run() override;
+
+    const QString m_url;
+    QMutex m_takeMutex;
+    IOController<Demuxer> m_demuxer;
+    QStringList m_fileSubsList;
+    PreRolledPackets m_preRolledPackets;
+};
@@ -18,13 +18,15 @@
 
 #include <DemuxerThr.hpp>
 
+#include <DemuxerPreloader.hpp>
 #include <PlayClass.hpp>
 #include <AVThread.hpp>
 #include <Writer.hpp>
 #include <Main.hpp>
 
 #include <Functions.hpp>
-#include <StreamMuxer.hpp>
+#include <AsyncStreamMuxer.hpp>
+#include <TimeshiftFile.hpp>
 #include <SubsDec.hpp>
 #include <Demuxer.hpp>
 #include <Decoder.hpp>
@@ -83,6 +85,48 @@ DemuxerThr::DemuxerThr(PlayClass &playC) :
 DemuxerThr::~DemuxerThr()
 {}
 
+QStringList DemuxerThr::findFileSubs(const QString &url, const QList<StreamInfo *> &streams)
+{
+    QStringList fileSubsList;
+    if (url.startsWith("file://"))
+    {
+        QStringList filter;
+        filter << "*.ass" << "*.ssa";
+        for (const QString &ext : SubsDec::extensions())
+            filter << "*." + ext;
+        for (StreamInfo *streamInfo : streams)
+        {
+            if (streamInfo->params->codec_type == AVMEDIA_TYPE_VIDEO) //napisów szukam tylko wtedy, jeżeli jest strumień wideo
+            {
+                const QString directory = Functions::filePath(url.mid(7));
+
+                const QString fName = Functions::fileName(url, false).replace('_', ' ');
+                auto maybeAppendFiles = [&fileSubsList, filter, fName](const QString  &directory) {
+                    for (const QFileInfo &subsFileInfo : QDir(directory).entryInfoList(filter, QDir::Files))
+                    {
+                        const QString subsFName = Functions::fileName(subsFileInfo.fileName(), false).replace('_', ' ');
+                        if (subsFName.contains(fName, Qt::CaseInsensitive) || fName.contains(subsFName, Qt::CaseInsensitive))
+                        {
+                            const QString fileSubsUrl = Functions::Url(subsFileInfo.filePath());
+                            if (!fileSubsList.contains(fileSubsUrl))
+                                fileSubsList += fileSubsUrl;
+                        }
+                    }
+                };
+
+                maybeAppendFiles(directory);
+
+                const QStringList dirs {"ass", "srt", "sub", "subs", "subtitles"};
+                for (const QFileInfo &dirInfo : QDir(directory).entryInfoList(dirs, QDir::Dirs | QDir::NoDotAndDotDot))
+                    maybeAppendFiles(dirInfo.filePath());
+
+                break;
+            }
+        }
+    }
+    return fileSubsList;
+}
+
 QByteArray DemuxerThr::getCoverFromStream() const
 {
     return demuxer ? demuxer->image(true) : QByteArray();
@@ -165,7 +209,8 @@ void DemuxerThr::seek(bool doDemuxerSeek)
         const bool stepBackwards = (playC.allowAccurateSeek && playC.nextFrameB);
 
         const Qt::CheckState accurateSeek = (Qt::CheckState)QMPlay2Core.getSettings().getInt("AccurateSeek");
-        const bool doAccurateSeek = (accurateSeek == Qt::Checked || (accurateSeek == Qt::PartiallyChecked && (!localStream || playC.allowAccurateSeek)) || stepBackwards);
+        const bool doAccurateSeek = !playC.scrubbing && (accurateSeek == Qt::Checked || (accurateSeek == Qt::PartiallyChecked && (!localStream || playC.allowAccurateSeek)) || stepBackwards || playC.forceAccurateSeek);
+        playC.forceAccurateSeek = false;
 
         const bool backward = doAccurateSeek || repeat || (playC.seekTo < playC.pos);
         bool flush = false, aLocked = false, vLocked = false;
@@ -264,13 +309,14 @@ void DemuxerThr::seek(bool doDemuxerSeek)
             playC.flushVideo = playC.flushAudio = true;
             if (playC.pos < 0.0) //skok po rozpoczęciu odtwarzania po uruchomieniu programu
                 emit playC.updatePos(playC.seekTo); //uaktualnia suwak na pasku do wskazanej pozycji
-            if (repeat || playC.videoSeekPos > -1.0 || playC.audioSeekPos > -1.0)
-                playC.emptyBufferCond.wakeAll(); //Wake AV threads
+            const bool wakeAVThreads = (repeat || playC.videoSeekPos > -1.0 || playC.audioSeekPos > -1.0);
             const double seekPos = (doAccurateSeek && playC.seekTo > 0.0) ? playC.seekTo : -1.0;
             if (vThr)
                 playC.videoSeekPos = seekPos;
             if (aThr)
                 playC.audioSeekPos = seekPos;
+            if (wakeAVThreads)
+                playC.wakeEmptyBuffer(); //Wake AV threads
             if (aLocked)
                 aThr->unlock();
             if (vLocked)
@@ -299,6 +345,8 @@ void DemuxerThr::seek(bool doDemuxerSeek)
 void DemuxerThr::stop()
 {
     ioCtrl.abort();
+    if (m_preloader)
+        m_preloader->abort();
     demuxer.abort();
 }
 void DemuxerThr::end()
@@ -349,13 +397,19 @@ void DemuxerThr::checkReadyWrite(AVThread *avThr)
 void DemuxerThr::startRecording()
 {
     if (isDemuxerReady())
+    {
         m_recording = true;
+        playC.requestFillBuffer();
+    }
     else if (!m_recording)
+    {
         emit recording(false, true);
+    }
 }
 void DemuxerThr::stopRecording()
 {
     m_recording = false;
+    playC.requestFillBuffer();
 }
 
 void DemuxerThr::run()
@@ -379,52 +433,26 @@ void DemuxerThr::run()
         return;
     }
 
-    if (!Demuxer::create(url, demuxer) || demuxer.isAborted())
+    QStringList fileSubsList;
+    DemuxerPreloader::PreRolledPackets preRolledPackets;
+    if (!m_preloader || !m_preloader->take(demuxer, fileSubsList, preRolledPackets))
     {
-        if (!demuxer.isAborted() && !demuxer)
+        if (!Demuxer::create(url, demuxer) || demuxer.isAborted())
         {
-            QMPlay2Core.logError(tr("Cannot open") + ": " + url.remove("file://"));
-            emit playC.updateCurrentEntry(QString(), -1.0);
-            err = true;
-        }
-        return end();
-    }
-
-    if (url.startsWith("file://"))
-    {
-        QStringList filter;
-        filter << "*.ass" << "*.ssa";
-        for (const QString &ext : SubsDec::extensions())
-            filter << "*." + ext;
-        for (StreamInfo *streamInfo : demuxer->streamsInfo())
-        {
-            if (streamInfo->params->codec_type == AVMEDIA_TYPE_VIDEO) //napisów szukam tylko wtedy, jeżeli jest strumień wideo
+            if (!demuxer.isAborted() && !demuxer)
             {
-                const QString directory = Functions::filePath(url.mid(7));
-
-                const QString fName = Functions::fileName(url, false).replace('_', ' ');
-                auto maybeAppendFiles = [this, filter, fName](const QString  &directory) {
-                    for (const QFileInfo &subsFileInfo : QDir(directory).entryInfoList(filter, QDir::Files))
-                    {
-                        const QString subsFName = Functions::fileName(subsFileInfo.fileName(), false).replace('_', ' ');
-                        if (subsFName.contains(fName, Qt::CaseInsensitive) || fName.contains(subsFName, Qt::CaseInsensitive))
-                        {
-                            const QString fileSubsUrl = Functions::Url(subsFileInfo.filePath());
-                            if (!playC.fileSubsList.contains(fileSubsUrl))
-                                playC.fileSubsList += fileSubsUrl;
-                        }
-                    }
-                };
-
-                maybeAppendFiles(directory);
-
-                const QStringList dirs {"ass", "srt", "sub", "subs", "subtitles"};
-                for (const QFileInfo &dirInfo : QDir(directory).entryInfoList(dirs, QDir::Dirs | QDir::NoDotAndDotDot))
-                    maybeAppendFiles(dirInfo.filePath());
-
-                break;
+                QMPlay2Core.logError(tr("Cannot open") + ": " + url.remove("file://"));
+                emit playC.updateCurrentEntry(QString(), -1.0);
+                err = true;
             }
+            return end();
         }
+        fileSubsList = findFileSubs(url, demuxer->streamsInfo());
+    }
+    for (const QString &fileSubsUrl : std::as_const(fileSubsList))
+    {
+        if (!playC.fileSubsList.contains(fileSubsUrl))
+            playC.fileSubsList += fileSubsUrl;
     }
 
     bool stillImage = playC.stillImage = demuxer->isStillImage();
@@ -433,6 +461,17 @@ void DemuxerThr::run()
     if (err || demuxer.isAborted())
         return end();
 
+    for (auto &&[streamIdx, packet] : std::as_const(preRolledPackets))
+    {
+        if (streamIdx == playC.audioStream)
+            playC.aPackets.put(packet);
+        else if (streamIdx == playC.videoStream)
+            playC.vPackets.put(packet);
+        else if (streamIdx == playC.subtitlesStream)
+            playC.sPackets.put(packet);
+    }
+    preRolledPackets.clear();
+
     updatePlayingName = name.isEmpty() ? Functions::fileName(url, false) : name;
 
     if (playC.videoStream > -1)
@@ -517,6 +556,9 @@ void DemuxerThr::run()
     }
     PacketBuffer::setBackwardTime(backwardTime);
 
+    if (!localStream && unknownLength && QMPlay2Core.getSettings().getBool("Timeshift"))
+        m_timeshift = enableTimeshift(forwardTime);
+
     if (!localStream)
         setPriority(QThread::LowPriority); //Network streams should have low priority, because slow single core CPUs have problems with smooth video playing during buffering
 
@@ -592,6 +634,7 @@ void DemuxerThr::run()
                     playC.seekTo = SEEK_REPEAT;
                     continue;
                 }
+                m_reachedEnd = true;
                 break;
             }
             else
@@ -645,7 +688,7 @@ void DemuxerThr::run()
 
             playC.waitForData = false;
             if (!paused)
-                playC.emptyBufferCond.wakeAll();
+                playC.wakeEmptyBuffer();
 
             firstWaitForData = false;
         }
@@ -654,7 +697,9 @@ void DemuxerThr::run()
             canWaitForData = true;
         }
 
-        if (playC.endOfStream || ((minBuffered > 0) ? bufferedAllPackets(vS, aS, minBuffered) : bufferedAllPackets(vT, aT, forwardTime)))
+        // Live stream with timeshift is read all the time, also when paused - packets which
+        // don't fit in memory are moved to disk.
+        if (playC.endOfStream || (!m_timeshift && ((minBuffered > 0) ? bufferedAllPackets(vS, aS, minBuffered) : bufferedAllPackets(vT, aT, forwardTime))))
         {
             if (paused && !demuxerPaused)
             {
@@ -670,7 +715,8 @@ void DemuxerThr::run()
                 continue;
             }
 
-            bool loadError = false, first = true;
+            // Sleep until A/V threads consume packets or playback state changes
+            bool loadError = false;
             while (!playC.fillBufferB)
             {
                 if (mustReloadStreams() && !load())
@@ -680,16 +726,8 @@ void DemuxerThr::run()
                 }
                 if (playC.seekTo == SEEK_STREAM_RELOAD)
                     break;
-                if (!first)
-                {
-                    msleep(15);
-                    handleRecording(false);
-                }
-                else
-                {
-                    msleep(1);
-                    first = false;
-                }
+                handleRecording(false);
+                playC.waitForFillBufferRequest();
             }
             if (loadError)
                 break;
@@ -716,7 +754,8 @@ void DemuxerThr::run()
             if (int recStreamIdx = recStreamsMap.value(streamIdx, -1); recStreamIdx > -1)
             {
                 Q_ASSERT(m_recMuxer);
-                m_recMuxer->write(packet, recStreamIdx);
+                if (!m_recMuxer->write(packet, recStreamIdx))
+                    stopRecordingInternal(recStreamsMap, true);
             }
 
             if (streamIdx == playC.audioStream)
@@ -727,11 +766,13 @@ void DemuxerThr::run()
                 playC.sPackets.put(packet);
 
             if (!paused && !playC.waitForData)
-                playC.emptyBufferCond.wakeAll();
+                playC.wakeEmptyBuffer();
         }
         else if (!skipBufferSeek)
         {
             getAVBuffersSize(vS, aS, vT, aT);
+            if (!playC.endOfStream && localStream && !unknownLength && !stillImage && !playC.doRepeat)
+                emit playC.prepareNext(); // Remaining packets are buffered, so the next entry can be opened now
             playC.endOfStream = true;
             if (vS || aS || !canBreak(aThr, vThr))
             {
@@ -743,11 +784,12 @@ void DemuxerThr::run()
                         playC.videoSeekPos = -1.0;
                     if (!aS)
                         playC.audioSeekPos = -1.0;
-                    playC.emptyBufferCond.wakeAll();
+                    playC.wakeEmptyBuffer();
                 }
             }
             else if (!stillImage && !playC.doRepeat)
             {
+                m_reachedEnd = true;
                 break;
             }
         }
@@ -762,6 +804,9 @@ void DemuxerThr::run()
 
     playC.endOfStream = playC.canUpdatePos = false; //to musi tu być!
     end();
+
+    if (m_timeshift)
+        disableTimeshift();
 }
 
 void DemuxerThr::startRecordingInternal(QHash<int, int> &recStreamsMap)
@@ -785,7 +830,7 @@ void DemuxerThr::startRecordingInternal(QHash<int, int> &recStreamsMap)
 
     const auto dir = QMPlay2Core.getSettings().getString("OutputFilePath");
     const auto fileName = Functions::getSeqFile(dir, "." + ext, "rec");
-    m_recMuxer = std::make_unique<StreamMuxer>(dir + "/" + fileName, recStreamsInfo, fmt, true);
+    m_recMuxer = std::make_unique<AsyncStreamMuxer>(dir + "/" + fileName, recStreamsInfo, fmt, true);
     if (m_recMuxer->isOk())
     {
         emit recording(true, false, fileName);
@@ -828,13 +873,15 @@ void DemuxerThr::startRecordingInternal(QHash<int, int> &recStreamsMap)
     }
     changeStatusText();
 }
-void DemuxerThr::stopRecordingInternal(QHash<int, int> &recStreamsMap)
+void DemuxerThr::stopRecordingInternal(QHash<int, int> &recStreamsMap, bool error)
 {
     Q_ASSERT(m_recMuxer);
+    if (const quint64 droppedPackets = m_recMuxer->droppedPackets())
+        QMPlay2Core.logError(tr("Recording output is too slow, dropped packets: %1").arg(droppedPackets), false);
     m_recording = false;
     m_recMuxer.reset();
     recStreamsMap.clear();
-    emit recording(false, false);
+    emit recording(false, error);
     changeStatusText();
 }
 
@@ -855,7 +902,7 @@ void DemuxerThr::handlePause()
             paused = true;
             changeStatusText();
             emit playC.playStateChanged(false);
-            playC.emptyBufferCond.wakeAll();
+            playC.wakeEmptyBuffer();
         }
     }
     else if (paused)
@@ -863,7 +910,7 @@ void DemuxerThr::handlePause()
         paused = demuxerPaused = false;
         changeStatusText();
         emit playC.playStateChanged(true);
-        playC.emptyBufferCond.wakeAll();
+        playC.wakeEmptyBuffer();
     }
 }
 void DemuxerThr::emitBufferInfo(bool clearBackwards)
@@ -1430,6 +1477,34 @@ void DemuxerThr::clearBuffers()
     playC.clearSubtitlesBuffer();
 }
 
+bool DemuxerThr::enableTimeshift(double forwardTime)
+{
+    const QString dirPath = TimeshiftFile::dirPath();
+    const qint64 size = QMPlay2Core.getSettings().getInt("TimeshiftSize") * 1048576LL;
+
+    // Split the size 64:16:1 - video stream is usually the biggest one, subtitles are very small
+    const qint64 vSize = size / 81 * 64;
+    const qint64 aSize = size / 81 * 16;
+    const bool ok =
+        playC.vPackets.enableTimeshift(dirPath, vSize, forwardTime) &&
+        playC.aPackets.enableTimeshift(dirPath, aSize, forwardTime) &&
+        playC.sPackets.enableTimeshift(dirPath, size - vSize - aSize, forwardTime)
+    ;
+    if (!ok)
+    {
+        QMPlay2Core.logError(tr("Can't create timeshift file in %1").arg(dirPath), false);
+        disableTimeshift();
+    }
+    return ok;
+}
+void DemuxerThr::disableTimeshift()
+{
+    playC.vPackets.disableTimeshift();
+    playC.aPackets.disableTimeshift();
+    playC.sPackets.disableTimeshift();
+    m_timeshift = false;
+}
+
 double DemuxerThr::getFrameDelay() const
 {
     return 1.0 / demuxer->streamsInfo().at(playC.videoStream)->getFPS();
@@ -1451,6 +1526,9 @@ void DemuxerThr::stopVADec()
 {
     clearBuffers();
 
+    if (m_reachedEnd && !err && demuxer)
+        playC.parkDecoders(demuxer->streamsInfo()); // They can be reused by the next entry
+
     playC.stopVDec();
     playC.stopADec();
 
@@ -21,14 +21,16 @@
 #include <IOController.hpp>
 #include <StreamInfo.hpp>
 
+#include <QStringList>
 #include <QString>
 #include <QThread>
 #include <QMutex>
 #include <QTimer>
 
+class DemuxerPreloader;
 class BufferInfo;
 class PlayClass;
-class StreamMuxer;
+class AsyncStreamMuxer;
 class AVThread;
 class Demuxer;
 class BasicIO;
@@ -38,6 +40,10 @@ class DemuxerThr final : public QThread
     friend class DemuxerTimer;
     friend class PlayClass;
     Q_OBJECT
+public:
+    // Subtitles files next to the media file, used only if it has a video stream
+    static QStringList findFileSubs(const QString &url, const QList<StreamInfo *> &streams);
+
 private:
     DemuxerThr(PlayClass &);
     ~DemuxerThr();
@@ -72,7 +78,7 @@ private:
     void run() override;
 
     void startRecordingInternal(QHash<int, int> &recStreamsMap);
-    void stopRecordingInternal(QHash<int, int> &recStreamsMap);
+    void stopRecordingInternal(QHash<int, int> &recStreamsMap, bool error = false);
 
     inline void ensureTrueUpdateBuffered();
     inline bool canUpdateBuffered() const;
@@ -93,6 +99,9 @@ private:
     BufferInfo getBufferInfo(bool clearBackwards);
     void clearBuffers();
 
+    bool enableTimeshift(double forwardTime);
+    void disableTimeshift();
+
     double getFrameDelay() const;
 
     void changeStatusText();
@@ -109,8 +118,11 @@ private:
     IOController<Demuxer> demuxer;
     QString title, artist, album;
     double playIfBuffered, time, updateBufferedTime;
-    std::unique_ptr<StreamMuxer> m_recMuxer;
+    std::unique_ptr<AsyncStreamMuxer> m_recMuxer;
     bool m_recording = false;
+    std::unique_ptr<DemuxerPreloader> m_preloader;
+    bool m_reachedEnd = false;
+    bool m_timeshift = false;
 private slots:
     void stopVADec();
     void updateCover(const QString &title, const QString &artist, const QString &album, const QByteArray &cover);
@@ -139,11 +139,23 @@ void InfoDock::updateBitrateAndFPS(int a, int v, double fps, double realFPS, boo
         videoFPS = -1.0;
         videoRealFPS = -1.0;
         interlacedVideo = false;
+        decodedFrames = decodedFramesCapacity = -1;
     }
 
     if (visibleRegion() != QRegion())
         setLabelValues();
 }
+void InfoDock::updateDecodedFramesQueue(int frames, int capacity)
+{
+    if (!videoPlaying)
+        return;
+
+    decodedFrames = frames;
+    decodedFramesCapacity = capacity;
+
+    if (visibleRegion() != QRegion())
+        setLabelValues();
+}
 void InfoDock::updateBuffered(qint64 backwardBytes, qint64 remainingBytes, double backwardSeconds, double remainingSeconds)
 {
     if (backwardBytes < 0 || remainingBytes < 0)
@@ -173,6 +185,7 @@ void InfoDock::clear()
     videoPlaying = audioPlaying = interlacedVideo = false;
     videoBR = audioBR = -1;
     videoFPS = videoRealFPS = -1.0;
+    decodedFrames = decodedFramesCapacity = -1;
     buffer->clear();
     buffer->close();
     bitrateAndFPS->clear();
@@ -208,6 +221,8 @@ void InfoDock::setLabelValues()
             text += ", " + tr("visible") + ": " + QString::number(videoRealFPS, 'g', 5) + " FPS";
         if (interlacedVideo)
             text += ", " + tr("interlaced");
+        if (decodedFrames > -1 && decodedFramesCapacity > 0)
+            text += ", " + tr("decoded frames queue") + QString(": %1/%2").arg(decodedFrames).arg(decodedFramesCapacity);
     }
     bitrateAndFPS->setText(text);
 }
@@ -43,6 +43,7 @@ public:
 public slots:
     void setInfo(const QString &, bool, bool);
     void updateBitrateAndFPS(int a, int v, double fps, double realFPS, bool interlaced);
+    void updateDecodedFramesQueue(int frames, int capacity);
     void updateBuffered(qint64 backwardBytes, qint64 remainingBytes, double backwardSeconds, double remainingSeconds);
     void clear();
     void visibilityChanged(bool);
@@ -59,6 +60,7 @@ private:
 
     bool videoPlaying, audioPlaying, interlacedVideo;
     int audioBR, videoBR;
+    int decodedFrames = -1, decodedFramesCapacity = -1;
     double videoFPS, videoRealFPS;
     qint64 bytes1, bytes2;
     double seconds1, seconds2;
@@ -25,6 +25,7 @@
 #include <Functions.hpp>
 #include <VideoDock.hpp>
 #include <Settings.hpp>
+#include <TimeshiftFile.hpp>
 #include <Demuxer.hpp>
 #include <Version.hpp>
 #include <Module.hpp>
@@ -960,6 +961,9 @@ int main(int argc, char *argv[])
 
         lastVer.clear();
 
+        // Files used by other running instances stay valid on Unix and can't be removed on Windows
+        TimeshiftFile::removeStaleFiles();
+
         qmplay2Gui.restartApp = qmplay2Gui.removeSettings = qmplay2Gui.noAutoPlay = false;
         qmplay2Gui.startInvisible = startInvisible;
         qmplay2Gui.newProfileName.clear();
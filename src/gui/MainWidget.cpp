@@ -346,6 +346,7 @@ MainWidget::MainWidget(QList<QPair<QString, QString>> &arguments)
     connect(videoDock, SIGNAL(itemDropped(const QString &, bool)), this, SLOT(itemDropped(const QString &, bool)));
 
     connect(playlistDock, SIGNAL(play(const QString &)), &playC, SLOT(play(const QString &)));
+    connect(playlistDock, SIGNAL(preload(const QString &)), &playC, SLOT(preload(const QString &)));
     connect(playlistDock, SIGNAL(repeatEntry(bool)), &playC, SLOT(repeatEntry(bool)));
     connect(playlistDock, SIGNAL(stop()), &playC, SLOT(stop()));
     connect(playlistDock, &PlaylistDock::addAndPlayRestoreWindow, this, [this] {
@@ -353,6 +354,19 @@ MainWidget::MainWidget(QList<QPair<QString, QString>> &arguments)
     });
 
     connect(seekS, SIGNAL(valueChanged(int)), this, SLOT(seek(int)));
+    connect(seekS, &Slider::sliderReleased, this, [this] {
+        if (playC.isScrubbing())
+        {
+            m_scrubTimer.stop();
+            playC.finishScrubbing(seekS->value() / 10.0);
+        }
+    });
+    m_scrubTimer.setSingleShot(true);
+    m_scrubTimer.setInterval(20);
+    connect(&m_scrubTimer, &QTimer::timeout, this, [this] {
+        if (!playC.scrubSeek(m_scrubPos))
+            m_scrubTimer.start();
+    });
     connect(seekS, SIGNAL(mousePosition(int)), this, SLOT(mousePositionOnSlider(int)));
 
     connect(volW, SIGNAL(volumeChanged(int, int)), &playC, SLOT(volume(int, int)));
@@ -375,6 +389,7 @@ MainWidget::MainWidget(QList<QPair<QString, QString>> &arguments)
     connect(&playC, SIGNAL(setInfo(const QString &, bool, bool)), infoDock, SLOT(setInfo(const QString &, bool, bool)));
     connect(&playC, &PlayClass::setStreamsMenu, this, &MainWidget::setStreamsMenu);
     connect(&playC, SIGNAL(updateCurrentEntry(const QString &, double)), playlistDock, SLOT(updateCurrentEntry(const QString &, double)));
+    connect(&playC, SIGNAL(prepareNext()), playlistDock, SLOT(prepareNext()));
     connect(&playC, SIGNAL(playNext(bool)), playlistDock, SLOT(next(bool)));
     connect(&playC, SIGNAL(clearCurrentPlaying()), playlistDock, SLOT(clearCurrentPlaying()));
     connect(&playC, &PlayClass::clearInfo, this, [this] {
@@ -384,6 +399,7 @@ MainWidget::MainWidget(QList<QPair<QString, QString>> &arguments)
     connect(&playC, SIGNAL(quit()), this, SLOT(deleteLater()));
     connect(&playC, SIGNAL(resetARatio()), this, SLOT(resetARatio()));
     connect(&playC, SIGNAL(updateBitrateAndFPS(int, int, double, double, bool)), infoDock, SLOT(updateBitrateAndFPS(int, int, double, double, bool)));
+    connect(&playC, &PlayClass::updateDecodedFramesQueue, infoDock, &InfoDock::updateDecodedFramesQueue);
     connect(&playC, SIGNAL(updateBuffered(qint64, qint64, double, double)), infoDock, SLOT(updateBuffered(qint64, qint64, double, double)));
     connect(&playC, SIGNAL(updateBufferedRange(int, int)), seekS, SLOT(drawRange(int, int)));
     connect(&playC, SIGNAL(updateWindowTitle(const QString &)), this, SLOT(updateWindowTitle(const QString &)));
@@ -514,7 +530,7 @@ MainWidget::MainWidget(QList<QPair<QString, QString>> &arguments)
         }
     });
 
-    playlistDock->load(QMPlay2Core.getSettingsDir() + "Playlist.pls");
+    playlistDock->loadSession();
 
     bool noplay = false;
     for (const auto &argument : std::as_const(arguments))
@@ -745,6 +761,15 @@ void MainWidget::seek(double pos)
     if (!seekS->ignoringValueChanged() && playC.isPlaying())
     {
         auto sender = this->sender();
+        if (sender == seekS && seekS->isSliderDown())
+        {
+            // Dragging - seek to key frames only, seek to the latest position when the previous seek is done
+            playC.startScrubbing();
+            m_scrubPos = pos;
+            if (!m_scrubTimer.isActive())
+                m_scrubTimer.start();
+            return;
+        }
         playC.seek(pos, (!sender || sender == infoDock || qobject_cast<QAction *>(sender)));
     }
 }
@@ -2242,7 +2267,7 @@ void MainWidget::closeEvent(QCloseEvent *e)
     {
         if (settings.getBool("AutoDelNonGroupEntries"))
             playlistDock->delNonGroupEntries(true);
-        playlistDock->save(QMPlay2Core.getSettingsDir() + "Playlist.pls");
+        playlistDock->saveSession();
     }
 
     playC.stop(true);
@@ -230,4 +230,7 @@ private:
     QSize m_winSizeForDocks;
     QTimer m_storeDockSizesTimer;
     std::vector<std::pair<QDockWidget *, QSize>> m_dockSizes;
+
+    QTimer m_scrubTimer; // Coalesces seeks while dragging the seek slider
+    double m_scrubPos = 0.0;
 };
@@ -0,0 +1,185 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <MediaInfoCache.hpp>
+#include <PlaylistSnapshot.hpp>
+
+#include <QMPlay2Core.hpp>
+
+#include <QDataStream>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QFile>
+
+#include <algorithm>
+
+constexpr quint32 g_magic = 0x514D4943; // "QMIC"
+constexpr quint32 g_version = 2;
+constexpr QDataStream::Version g_streamVersion = QDataStream::Qt_5_15;
+
+constexpr int g_maxItems = 20000; // The least recently used entries are dropped above this limit
+
+static bool getFileStamp(const QString &filePath, qint64 &size, qint64 &mTime)
+{
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile())
+        return false;
+    size = fileInfo.size();
+    mTime = fileInfo.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+/**/
+
+MediaInfoCache::~MediaInfoCache()
+{
+    // Cache hits alone don't trigger saving, store their usage time once on exit
+    if (m_lastUsedModified)
+        m_modified = true;
+    save();
+}
+
+void MediaInfoCache::load(const QString &demuxersSignature)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_loaded)
+    {
+        if (m_demuxersSignature != demuxersSignature)
+        {
+            m_items.clear();
+            m_demuxersSignature = demuxersSignature;
+            m_modified = true;
+        }
+        return;
+    }
+
+    m_loaded = true;
+    m_demuxersSignature = demuxersSignature;
+
+    QFile f(fileName());
+    if (!f.open(QFile::ReadOnly))
+        return;
+
+    QDataStream stream(&f);
+    stream.setVersion(g_streamVersion);
+    quint32 magic = 0, version = 0;
+    QString signature;
+    stream >> magic >> version;
+    if (magic != g_magic || version != g_version)
+        return;
+    stream >> signature;
+    if (signature != demuxersSignature)
+        return;
+
+    qint32 count = 0;
+    stream >> count;
+    if (count < 0 || count > f.size())
+        return;
+    m_items.reserve(count);
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString filePath;
+        Item item;
+        stream >> filePath >> item.size >> item.mTime >> item.lastUsed;
+        stream >> item.info.opened >> item.info.tracksOK >> item.info.title >> item.info.length >> item.info.tracks;
+        if (stream.status() == QDataStream::Ok)
+            m_items.insert(filePath, item);
+    }
+    if (stream.status() != QDataStream::Ok)
+        m_items.clear();
+}
+void MediaInfoCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_modified)
+        return;
+
+    if (m_items.size() > g_maxItems)
+    {
+        QVector<qint64> lastUsed;
+        lastUsed.reserve(m_items.size());
+        for (auto &&item : std::as_const(m_items))
+            lastUsed.append(item.lastUsed);
+        const auto nth = lastUsed.begin() + (m_items.size() - g_maxItems);
+        std::nth_element(lastUsed.begin(), nth, lastUsed.end());
+        const qint64 minLastUsed = *nth;
+        for (auto it = m_items.begin(); it != m_items.end();)
+        {
+            if (it->lastUsed < minLastUsed)
+                it = m_items.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    QSaveFile f(fileName());
+    if (!f.open(QFile::WriteOnly))
+        return;
+
+    QDataStream stream(&f);
+    stream.setVersion(g_streamVersion);
+    stream << g_magic << g_version << m_demuxersSignature << static_cast<qint32>(m_items.size());
+    for (auto it = m_items.cbegin(), itEnd = m_items.cend(); it != itEnd; ++it)
+    {
+        const Item &item = it.value();
+        stream << it.key() << item.size << item.mTime << item.lastUsed;
+        stream << item.info.opened << item.info.tracksOK << item.info.title << item.info.length << item.info.tracks;
+    }
+
+    if (f.commit())
+    {
+        m_modified = false;
+        m_lastUsedModified = false;
+    }
+}
+
+bool MediaInfoCache::get(const QString &filePath, Info &info)
+{
+    qint64 size = 0, mTime = 0;
+    if (!getFileStamp(filePath, size, mTime))
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_items.find(filePath);
+    if (it == m_items.end() || it->size != size || it->mTime != mTime)
+        return false;
+    info = it->info;
+    it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    m_lastUsedModified = true;
+    return true;
+}
+void MediaInfoCache::put(const QString &filePath, const Info &info)
+{
+    Item item;
+    if (!getFileStamp(filePath, item.size, item.mTime))
+        return;
+    item.info = info;
+    item.lastUsed = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    m_items.insert(filePath, item);
+    m_modified = true;
+}
+
+QString MediaInfoCache::fileName() const
+{
+    return QMPlay2Core.getSettingsDir() + "MediaInfoCache.bin";
+}
@@ -0,0 +1,73 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <Playlist.hpp>
+
+#include <QMutex>
+#include <QHash>
+
+/*
+ * Persistent cache of probed local files for adding them to the playlist.
+ * Entries are valid as long as the file size and modification time match.
+ */
+class MediaInfoCache
+{
+    Q_DISABLE_COPY(MediaInfoCache)
+
+public:
+    struct Info
+    {
+        bool opened = false; // "Demuxer::create()" result
+        bool tracksOK = true;
+        QString title;
+        double length = -1.0;
+        Playlist::Entries tracks;
+    };
+
+public:
+    MediaInfoCache() = default;
+    ~MediaInfoCache();
+
+    // Loads the cache if it's not loaded yet, entries are dropped when demuxers list changes
+    void load(const QString &demuxersSignature);
+    void save();
+
+    // Thread-safe
+    bool get(const QString &filePath, Info &info);
+    void put(const QString &filePath, const Info &info);
+
+private:
+    QString fileName() const;
+
+    struct Item
+    {
+        qint64 size = -1;
+        qint64 mTime = 0;
+        qint64 lastUsed = 0;
+        Info info;
+    };
+
+    QMutex m_mutex;
+    QHash<QString, Item> m_items;
+    QString m_demuxersSignature;
+    bool m_loaded = false;
+    bool m_modified = false;
+    bool m_lastUsedModified = false;
+};
@@ -19,6 +19,7 @@
 #include <PlayClass.hpp>
 
 #include <QMPlay2OSD.hpp>
+#include <DemuxerPreloader.hpp>
 #include <VideoThr.hpp>
 #include <AudioThr.hpp>
 #include <DemuxerThr.hpp>
@@ -37,10 +38,12 @@
 #include <QGuiApplication>
 #include <QVarLengthArray>
 #include <QMessageBox>
+#include <QDataStream>
 #include <QRawFont>
 #include <QAction>
 #include <QDir>
 
+#include <functional>
 #include <cmath>
 
 PlayClass::PlayClass() :
@@ -115,6 +118,9 @@ void PlayClass::play(const QString &_url)
 
             url = _url;
             demuxThr = new DemuxerThr(*this);
+            if (m_preloader && m_preloader->url() == url)
+                demuxThr->m_preloader = std::move(m_preloader);
+            DemuxerPreloader::release(m_preloader);
             demuxThr->minBuffSizeLocal = QMPlay2Core.getSettings().getInt("AVBufferLocal");
             demuxThr->m_minBuffTimeNetwork = QMPlay2Core.getSettings().getDouble("AVBufferTimeNetwork");
             demuxThr->m_minBuffTimeNetworkLive = QMPlay2Core.getSettings().getDouble("AVBufferTimeNetworkLive");
@@ -197,6 +203,17 @@ void PlayClass::play(const QString &_url)
         stop();
     }
 }
+void PlayClass::preload(const QString &url)
+{
+    // Only local files, other entries may need network access or user interaction
+    if (!demuxThr || url == this->url || !url.startsWith("file://") || Functions::isResourcePlaylist(url) || !QMPlay2Core.getSettings().getBool("GaplessPlayback"))
+        return;
+    if (!m_preloader || m_preloader->url() != url)
+    {
+        DemuxerPreloader::release(m_preloader);
+        m_preloader = std::make_unique<DemuxerPreloader>(url);
+    }
+}
 void PlayClass::stop(bool _quitApp)
 {
     emit continuePos(0.0, false);
@@ -211,7 +228,7 @@ void PlayClass::stop(bool _quitApp)
             {
                 timTerminate.start(TERMINATE_TIMEOUT * 5 / 3);
                 demuxThr->stop();
-                fillBufferB = true;
+                requestFillBuffer();
             }
         }
         else
@@ -255,7 +272,13 @@ void PlayClass::togglePause()
         if (aThr && !paused)
             aThr->silence(false, true);
         paused = !paused;
-        fillBufferB = true;
+        if (!paused && vThr)
+        {
+            if (vThr->isShowingFrameFromHistory())
+                seek(frame_last_pts); // Continue from the frame shown from history instead of the newest decoded frame
+            vThr->stopFrameStepping();
+        }
+        requestFillBuffer();
         if (aThr && !paused)
             aThr->silence(true, true);
         stopPauseMutex.unlock();
@@ -286,10 +309,56 @@ void PlayClass::seek(double pos, bool allowAccurate)
         demuxThr->seekMutex.unlock();
     }
     emit QMPlay2Core.seeked(pos); //Signal for MPRIS2
-    fillBufferB = true;
+    requestFillBuffer();
     if (aThr && paused)
         aThr->silence(true, true);
 }
+void PlayClass::startScrubbing()
+{
+    if (scrubbing || !isPlaying())
+        return;
+    pausedBeforeScrubbing = paused;
+    if (!paused)
+        togglePause(); // Also silences audio
+    scrubbing = true;
+    scrubSeekTimer.invalidate();
+}
+bool PlayClass::scrubSeek(double pos)
+{
+    if (!scrubbing)
+        return true;
+
+    // Wait until the previous key frame is shown, but don't wait forever if there is no frame
+    const bool busy = (seekTo >= 0.0 || (nextFrameB && videoStream > -1));
+    if (busy && scrubSeekTimer.isValid() && scrubSeekTimer.elapsed() < 250)
+        return false;
+
+    if (videoStream > -1)
+        nextFrameB = true; // Show one frame and pause
+    seek(pos, false);
+    scrubSeekTimer.start();
+    return true;
+}
+void PlayClass::finishScrubbing(double pos)
+{
+    if (!scrubbing)
+        return;
+    scrubbing = false;
+    forceAccurateSeek = true;
+    lastSeekTo = SEEK_NOWHERE; // Always seek, even if it's the last scrub position
+    if (pausedBeforeScrubbing)
+    {
+        if (videoStream > -1)
+            nextFrameB = true;
+        seek(pos, false);
+    }
+    else
+    {
+        nextFrameB = false;
+        seek(pos, false);
+        togglePause();
+    }
+}
 void PlayClass::chStream(const QString &s)
 {
     if (s.startsWith("audio"))
@@ -336,6 +405,7 @@ void PlayClass::chStream(const QString &s)
             }
         }
     }
+    requestFillBuffer(); // Wake the demuxer to reload streams
 }
 void PlayClass::setSpeed(double spd)
 {
@@ -480,6 +550,36 @@ void PlayClass::setRecording(bool checked)
         demuxThr->stopRecording();
 }
 
+void PlayClass::requestFillBuffer()
+{
+    if (fillBufferB.exchange(true))
+        return;
+
+    // Locking ensures that the demuxer is either before the flag check or already waiting
+    QMutexLocker locker(&fillBufferMutex);
+    fillBufferCond.wakeAll();
+}
+void PlayClass::waitForFillBufferRequest()
+{
+    // Every state change which the demuxer waits for is followed by "requestFillBuffer()"
+    QMutexLocker locker(&fillBufferMutex);
+    while (!fillBufferB)
+        fillBufferCond.wait(&fillBufferMutex);
+}
+
+void PlayClass::waitForEmptyBufferWake(quint64 seq)
+{
+    QMutexLocker locker(&emptyBufferMutex);
+    while (emptyBufferSeq == seq)
+        emptyBufferCond.wait(&emptyBufferMutex);
+}
+void PlayClass::wakeEmptyBuffer()
+{
+    QMutexLocker locker(&emptyBufferMutex);
+    ++emptyBufferSeq;
+    emptyBufferCond.wakeAll();
+}
+
 void PlayClass::setIntegerScaling(bool integerScaling)
 {
     m_integerScaling = integerScaling;
@@ -611,8 +711,11 @@ void PlayClass::stopVDec()
     frame_last_pts = frame_last_delay = 0.0;
     subtitlesStream = -1;
     nextFrameB = false;
-    delete ass; //wywołuje też closeASS(), sMutex nie potrzebny, bo vThr jest zablokowany (mutex przed sMutex)
+    scrubbing = false;
+    subsMutex.lock(); // Subtitles renderer thread can use "ass"
+    delete ass; // Calls "closeASS()"
     ass = nullptr;
+    subsMutex.unlock();
     fps = 0.0;
 }
 void PlayClass::stopADec()
@@ -631,6 +734,62 @@ void PlayClass::stopADec()
     nextFrameB = false;
 }
 
+static QByteArray getDecoderSignature(const StreamInfo &streamInfo)
+{
+    const AVCodecParameters *params = streamInfo.params;
+    QByteArray signature;
+    QDataStream stream(&signature, QIODevice::WriteOnly);
+    stream << streamInfo.codec_name << static_cast<qint32>(params->codec_type) << static_cast<qint32>(params->codec_id)
+           << params->codec_tag << params->format << params->profile << params->level
+           << params->sample_rate << params->CODECPAR_NB_CHANNELS << params->width << params->height
+           << streamInfo.time_base.num << streamInfo.time_base.den << streamInfo.getExtraData();
+    return signature;
+}
+
+void PlayClass::parkDecoders(const QList<StreamInfo *> &streams)
+{
+    releaseParkedDecoders();
+
+    // Hardware decoders are bound to the video output, so they are not kept. A/V threads stay locked like in "stopVDec()" and "stopADec()".
+    if (vThr && vThr->dec && !vThr->dec->hasHWDecContext() && videoStream > -1 && videoStream < streams.count() && vThr->lock())
+    {
+        m_parkedVideoDec.dec.reset(vThr->dec);
+        m_parkedVideoDec.modName = videoDecoderModuleName;
+        m_parkedVideoDec.signature = getDecoderSignature(*streams[videoStream]);
+        vThr->dec = nullptr;
+        vThr->destroySubtitlesDecoder();
+        videoDecoderModuleName.clear();
+    }
+    if (aThr && aThr->dec && audioStream > -1 && audioStream < streams.count() && aThr->lock())
+    {
+        m_parkedAudioDec.dec.reset(aThr->dec);
+        m_parkedAudioDec.signature = getDecoderSignature(*streams[audioStream]);
+        aThr->dec = nullptr;
+    }
+}
+Decoder *PlayClass::takeParkedDecoder(ParkedDecoder &parked, const StreamInfo &streamInfo, QString *modNameOutput)
+{
+    if (!parked.dec || parked.signature != getDecoderSignature(streamInfo))
+        return nullptr;
+
+    // Don't output frames left from the previous entry and reset the decoder which can be drained at EOF
+    if (streamInfo.params->codec_type == AVMEDIA_TYPE_VIDEO)
+        flushVideo = true;
+    else
+        flushAudio = true;
+
+    if (modNameOutput)
+        *modNameOutput = parked.modName;
+    parked.modName.clear();
+    parked.signature.clear();
+    return parked.dec.release();
+}
+void PlayClass::releaseParkedDecoders()
+{
+    m_parkedVideoDec = {};
+    m_parkedAudioDec = {};
+}
+
 void PlayClass::setFlip()
 {
     if (vThr && vThr->setFlip() && !spherical)
@@ -1262,7 +1421,10 @@ void PlayClass::toggleAVS(bool b)
             messageAndOSD(tr("Subtitles off"));
     }
     if (isPlaying())
+    {
         reload = true;
+        requestFillBuffer();
+    }
 }
 void PlayClass::setSpherical(bool b)
 {
@@ -1327,15 +1489,18 @@ void PlayClass::screenShot()
     if (vThr)
     {
         vThr->setDoScreenshot();
-        emptyBufferCond.wakeAll();
+        wakeEmptyBuffer();
     }
 }
 void PlayClass::prevFrame()
 {
     if (videoStream > -1 && videoSeekPos <= 0.0 && stopPauseMutex.tryLock())
     {
-        nextFrameB = true;
-        seek(frame_last_pts - frame_last_delay * 1.5);
+        if (!vThr || !vThr->showFrameFromHistory(true))
+        {
+            nextFrameB = true;
+            seek(frame_last_pts - frame_last_delay * 1.5);
+        }
         stopPauseMutex.unlock();
     }
 }
@@ -1343,8 +1508,12 @@ void PlayClass::nextFrame()
 {
     if (stopPauseMutex.tryLock())
     {
-        paused = false;
-        nextFrameB = fillBufferB = true;
+        if (!vThr || !vThr->showFrameFromHistory(false))
+        {
+            paused = false;
+            nextFrameB = true;
+            requestFillBuffer();
+        }
         stopPauseMutex.unlock();
     }
 }
@@ -1480,6 +1649,13 @@ void PlayClass::demuxThrFinished()
             stopAVThr();
     }
 
+    if (!demuxThr)
+    {
+        // Nothing is played next
+        DemuxerPreloader::release(m_preloader);
+        releaseParkedDecoders();
+    }
+
     if (clr)
         clearPlayInfo();
     else
@@ -1523,7 +1699,8 @@ static Decoder *loadStream(
     const QString &lang,
     const QSet<QString> &blacklist,
     QString *modNameOutput,
-    const QSet<int> &preferredStreams = {})
+    const QSet<int> &preferredStreams = {},
+    const std::function<Decoder *(const StreamInfo &, QString *)> &takeParkedDecoder = nullptr)
 {
     QStringList decoders = QMPlay2Core.getModules("decoders", 7);
     const bool decodersListEmpty = decoders.isEmpty();
@@ -1534,10 +1711,18 @@ static Decoder *loadStream(
 
     Decoder *dec = nullptr;
     const bool subtitles = (type == AVMEDIA_TYPE_SUBTITLE);
+    const auto createDecoder = [&](StreamInfo &streamInfo) {
+        if (takeParkedDecoder)
+        {
+            if (Decoder *parkedDec = takeParkedDecoder(streamInfo, modNameOutput))
+                return parkedDec;
+        }
+        return Decoder::create(streamInfo, decoders, modNameOutput);
+    };
     if (chosenStream >= 0 && chosenStream < streams.count() && streams[chosenStream]->params->codec_type == type)
     {
         if (streams[chosenStream]->must_decode || !subtitles)
-            dec = Decoder::create(*streams[chosenStream], decoders, modNameOutput);
+            dec = createDecoder(*streams[chosenStream]);
         if (dec || subtitles)
             stream = chosenStream;
     }
@@ -1651,7 +1836,7 @@ static Decoder *loadStream(
                 if (streamInfo.params->codec_type == type && ((defaultStream == -1 && !streamInfo.skip_auto_select) || i == defaultStream))
                 {
                     if (streamInfo.must_decode || !subtitles)
-                        dec = Decoder::create(streamInfo, decoders, modNameOutput);
+                        dec = createDecoder(streamInfo);
                     if (dec || subtitles)
                     {
                         stream = i;
@@ -1685,7 +1870,11 @@ void PlayClass::load(Demuxer *demuxer)
                 AVMEDIA_TYPE_VIDEO,
                 QString(),
                 videoDecodersError,
-                &videoDecoderModuleName
+                &videoDecoderModuleName,
+                {},
+                [this](const StreamInfo &streamInfo, QString *modNameOutput) {
+                    return takeParkedDecoder(m_parkedVideoDec, streamInfo, modNameOutput);
+                }
             );
         }
         else
@@ -1815,9 +2004,15 @@ void PlayClass::load(Demuxer *demuxer)
         aPackets.clear();
         stopADec(); //lock
         if (audioEnabled)
-            dec = loadStream(streams, chosenAudioStream, audioStream, AVMEDIA_TYPE_AUDIO, chosenAudioLang, {}, nullptr, preferredStreams);
+        {
+            dec = loadStream(streams, chosenAudioStream, audioStream, AVMEDIA_TYPE_AUDIO, chosenAudioLang, {}, nullptr, preferredStreams, [this](const StreamInfo &streamInfo, QString *modNameOutput) {
+                return takeParkedDecoder(m_parkedAudioDec, streamInfo, modNameOutput);
+            });
+        }
         else
+        {
             dec = nullptr;
+        }
         if (dec)
         {
             if (!aThr)
@@ -1925,6 +2120,8 @@ void PlayClass::load(Demuxer *demuxer)
         }
     }
 
+    releaseParkedDecoders();
+
     reload = videoDecErrorLoad = false;
     loadMutex.unlock();
 }
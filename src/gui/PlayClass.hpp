@@ -27,17 +27,20 @@
 #include <QImage>
 #include <QObject>
 #include <QStringList>
+#include <QElapsedTimer>
 #include <QWaitCondition>
 
 #include <atomic>
 #include <memory>
 
+class DemuxerPreloader;
 class StreamInfo;
 class QMPlay2OSD;
 class DemuxerThr;
 class VideoThr;
 class AudioThr;
 class Demuxer;
+class Decoder;
 class Slider;
 class LibASS;
 
@@ -57,6 +60,7 @@ public:
     ~PlayClass();
 
     Q_SLOT void play(const QString &);
+    Q_SLOT void preload(const QString &url); // Opens the next entry in background for gapless transition
     Q_SLOT void stop(bool quitApp = false);
     void restart();
 
@@ -69,6 +73,15 @@ public:
 
     void togglePause();
     void seek(double pos, bool allowAccurate = true);
+
+    // Scrubbing pauses playback and decodes only key frames until it's finished
+    inline bool isScrubbing() const
+    {
+        return scrubbing;
+    }
+    void startScrubbing();
+    bool scrubSeek(double pos); // Returns "false" if the previous scrub seek is still in progress
+    void finishScrubbing(double pos);
     Q_SLOT void chStream(const QString &s);
     void setSpeed(double);
 
@@ -126,6 +139,16 @@ private:
     void stopVDec();
     void stopADec();
 
+    struct ParkedDecoder
+    {
+        std::unique_ptr<Decoder> dec;
+        QString modName;
+        QByteArray signature;
+    };
+    void parkDecoders(const QList<StreamInfo *> &streams);
+    Decoder *takeParkedDecoder(ParkedDecoder &parked, const StreamInfo &streamInfo, QString *modNameOutput);
+    void releaseParkedDecoders();
+
     void setFlip();
     void flipRotMsg();
 
@@ -147,15 +170,34 @@ private:
     VideoThr *vThr;
     AudioThr *aThr;
 
+    void requestFillBuffer();
+    void waitForFillBufferRequest();
+
+    // A/V threads take the sequence before checking the playback state and wait until it changes,
+    // so a wake-up which comes before waiting is not lost. State must be changed before waking.
+    inline quint64 emptyBufferWakeSeq() const
+    {
+        return emptyBufferSeq;
+    }
+    void waitForEmptyBufferWake(quint64 seq);
+    void wakeEmptyBuffer();
+
+    QMutex emptyBufferMutex;
     QWaitCondition emptyBufferCond;
+    std::atomic<quint64> emptyBufferSeq = 0;
     std::atomic_bool fillBufferB, doSilenceBreak;
     QMutex loadMutex, stopPauseMutex;
+    QWaitCondition fillBufferCond;
+    QMutex fillBufferMutex;
 
     PacketBuffer aPackets, vPackets, sPackets;
 
     double frame_last_pts, frame_last_delay, audio_current_pts, audio_last_delay;
     bool doSilenceOnStart, canUpdatePos, paused, waitForData, flushVideo, flushAudio, muted, reload, nextFrameB, endOfStream, ignorePlaybackError, videoDecErrorLoad, pauseAfterFirstFrame = false, keepAudioPitch = false, dontResetContinuePlayback = false;
     double seekTo, lastSeekTo, restartSeekTo, seekA, seekB, videoSeekPos, audioSeekPos;
+    std::atomic_bool scrubbing = false;
+    bool forceAccurateSeek = false, pausedBeforeScrubbing = false;
+    QElapsedTimer scrubSeekTimer;
     double vol[2], replayGain, zoom, pos, skipAudioFrame, videoSync, speed, subtitlesSync, subtitlesScale;
     int flip;
     bool rotate90, spherical, stillImage;
@@ -187,6 +229,9 @@ private:
     bool m_integerScaling = false;
     bool m_preciseZoom = false;
 
+    std::unique_ptr<DemuxerPreloader> m_preloader;
+    ParkedDecoder m_parkedVideoDec, m_parkedAudioDec; // Decoders of the finished entry, kept until the next one is loaded
+
 private slots:
     void suspendWhenFinished(bool b);
     void repeatEntry(bool b);
@@ -256,12 +301,14 @@ signals:
     void setInfo(const QString &, bool, bool);
     void setStreamsMenu(const QStringList &videoStreams, const QStringList &audioStreams, const QStringList &subsStreams, const QStringList &chapters, const QStringList &programs);
     void updateCurrentEntry(const QString &, double);
+    void prepareNext();
     void playNext(bool playingError);
     void clearCurrentPlaying();
     void clearInfo();
     void quit();
     void resetARatio();
     void updateBitrateAndFPS(int a, int v, double fps = -1.0, double realFPS = -1.0, bool interlaced = false);
+    void updateDecodedFramesQueue(int frames, int capacity);
     void updateBuffered(qint64 backwardBytes, qint64 remainingBytes, double backwardSeconds, double remainingSeconds);
     void updateBufferedRange(int, int);
     void updateWindowTitle(const QString &t = QString());
@@ -0,0 +1,200 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <PlaylistDirWatcher.hpp>
+
+#include <QStorageInfo>
+#include <QFileInfo>
+#include <QDir>
+
+constexpr int g_changesDelayMs = 500;
+
+PlaylistDirWatcher::PlaylistDirWatcher(QObject *parent)
+    : QObject(parent)
+{
+    m_pendingTimer.setSingleShot(true);
+    m_pendingTimer.setInterval(g_changesDelayMs);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &PlaylistDirWatcher::watcherDirectoryChanged);
+    connect(&m_pendingTimer, &QTimer::timeout, this, &PlaylistDirWatcher::emitPending);
+}
+
+bool PlaylistDirWatcher::canWatch(const QString &dirPath)
+{
+    const QByteArray fsType = QStorageInfo(dirPath).fileSystemType().toLower();
+    return !(
+        fsType.startsWith("nfs") ||
+        fsType.startsWith("cifs") ||
+        fsType.startsWith("smb") ||
+        fsType.startsWith("fuse.sshfs") ||
+        fsType == "9p"
+    );
+}
+
+bool PlaylistDirWatcher::watch(const QString &dirPath)
+{
+    if (m_snapshots.contains(dirPath))
+        return true;
+
+    // Add the path before listing the directory, so no change can be missed
+    if (!m_watcher.addPath(dirPath))
+        return false;
+
+    Snapshot snapshot;
+    if (!listDir(dirPath, snapshot))
+    {
+        m_watcher.removePath(dirPath);
+        return false;
+    }
+    m_snapshots.insert(dirPath, snapshot);
+    return true;
+}
+void PlaylistDirWatcher::unwatch(const QString &dirPath, bool recursive)
+{
+    QStringList toRemove;
+    for (auto it = m_snapshots.cbegin(), itEnd = m_snapshots.cend(); it != itEnd; ++it)
+    {
+        if (it.key() == dirPath || (recursive && it.key().startsWith(dirPath)))
+            toRemove += it.key();
+    }
+    for (const QString &pth : std::as_const(toRemove))
+    {
+        m_snapshots.remove(pth);
+        m_pending.remove(pth);
+    }
+    if (!toRemove.isEmpty())
+        m_watcher.removePaths(toRemove);
+}
+bool PlaylistDirWatcher::isWatched(const QString &dirPath) const
+{
+    return m_snapshots.contains(dirPath);
+}
+
+PlaylistDirWatcher::Delta PlaylistDirWatcher::takeDelta(const QString &dirPath)
+{
+    Delta delta;
+
+    auto snapshotIt = m_snapshots.find(dirPath);
+    if (snapshotIt == m_snapshots.end())
+        return delta;
+
+    Snapshot &oldSnapshot = snapshotIt.value();
+    Snapshot newSnapshot;
+    if (!listDir(dirPath, newSnapshot))
+    {
+        delta.removed = oldSnapshot.keys();
+        delta.lost = true;
+        unwatch(dirPath, true);
+        return delta;
+    }
+
+    QStringList removedDirs, createdDirs;
+    for (auto it = oldSnapshot.cbegin(), itEnd = oldSnapshot.cend(); it != itEnd; ++it)
+    {
+        const auto newIt = newSnapshot.constFind(it.key());
+        if (newIt != newSnapshot.cend() && newIt.value() == it.value())
+            continue;
+        if (it.value())
+            removedDirs += it.key();
+        else
+            delta.removed += it.key();
+    }
+    for (auto it = newSnapshot.cbegin(), itEnd = newSnapshot.cend(); it != itEnd; ++it)
+    {
+        const auto oldIt = oldSnapshot.constFind(it.key());
+        if (oldIt != oldSnapshot.cend() && oldIt.value() == it.value())
+            continue;
+        if (it.value())
+            createdDirs += it.key();
+        else
+            delta.created += it.key();
+    }
+
+    // There is no rename information from the file system watcher, but a single
+    // directory which disappeared while another one appeared with the same content
+    // is most likely renamed. Renaming a group is much cheaper than adding the whole
+    // directory tree again.
+    if (removedDirs.count() == 1 && createdDirs.count() == 1 && isRenamed(dirPath + removedDirs.at(0) + "/", dirPath + createdDirs.at(0) + "/"))
+    {
+        delta.renamed.append({removedDirs.at(0), createdDirs.at(0)});
+    }
+    else
+    {
+        delta.removed += removedDirs;
+        delta.created += createdDirs;
+    }
+
+    oldSnapshot = std::move(newSnapshot); // Must be done before modifying the hash table
+
+    for (const QString &dirName : std::as_const(removedDirs))
+        unwatch(dirPath + dirName + "/", true);
+
+    return delta;
+}
+
+void PlaylistDirWatcher::postpone(const QString &dirPath)
+{
+    if (!m_snapshots.contains(dirPath))
+        return;
+    m_pending.insert(dirPath);
+    m_pendingTimer.start();
+}
+
+bool PlaylistDirWatcher::isRenamed(const QString &oldDirPath, const QString &newDirPath) const
+{
+    // Direct children must be the same, otherwise e.g. a deleted directory and a copied one are
+    // mixed up. Files in the subtree of the old directory are reused without checking them.
+    const auto oldSnapshotIt = m_snapshots.constFind(oldDirPath);
+    if (oldSnapshotIt == m_snapshots.cend())
+        return false;
+
+    Snapshot newSnapshot;
+    if (!listDir(newDirPath, newSnapshot))
+        return false;
+
+    return newSnapshot == oldSnapshotIt.value();
+}
+
+bool PlaylistDirWatcher::listDir(const QString &dirPath, Snapshot &snapshot)
+{
+    const QDir dir(dirPath);
+    if (!dir.exists())
+        return false;
+    const auto entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    snapshot.reserve(entries.size());
+    for (const QFileInfo &entry : entries)
+        snapshot.insert(entry.fileName(), entry.isDir());
+    return true;
+}
+
+void PlaylistDirWatcher::watcherDirectoryChanged(const QString &path)
+{
+    QString dirPath = QDir::fromNativeSeparators(path);
+    if (!dirPath.endsWith('/'))
+        dirPath += '/';
+    postpone(dirPath);
+}
+void PlaylistDirWatcher::emitPending()
+{
+    const auto pending = m_pending;
+    m_pending.clear();
+    for (const QString &dirPath : pending)
+    {
+        if (m_snapshots.contains(dirPath)) // Can be removed by previous signal
+            emit directoryChanged(dirPath);
+    }
+}
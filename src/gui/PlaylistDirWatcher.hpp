@@ -0,0 +1,86 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QStringList>
+#include <QVector>
+#include <QTimer>
+#include <QPair>
+#include <QHash>
+#include <QSet>
+
+/*
+ * Keeps a snapshot of every watched directory of "always synced" playlist
+ * groups. When a directory changes only this directory is listed again and
+ * the differences against the snapshot are returned, so the playlist doesn't
+ * have to rescan the whole tree.
+ */
+class PlaylistDirWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Delta
+    {
+        QStringList created, removed; // File names
+        QVector<QPair<QString, QString>> renamed; // Directories only: old name, new name
+        bool lost = false; // Directory doesn't exist anymore
+
+        inline bool isEmpty() const
+        {
+            return created.isEmpty() && removed.isEmpty() && renamed.isEmpty() && !lost;
+        }
+    };
+
+public:
+    PlaylistDirWatcher(QObject *parent = nullptr);
+
+    // Returns "false" for file systems which don't report remote changes (network shares)
+    static bool canWatch(const QString &dirPath);
+
+    // Directory path must end with '/'
+    bool watch(const QString &dirPath);
+    void unwatch(const QString &dirPath, bool recursive);
+    bool isWatched(const QString &dirPath) const;
+
+    // Lists the directory again, updates the snapshot and returns changes
+    Delta takeDelta(const QString &dirPath);
+
+    // Changes can't be applied now, try again later
+    void postpone(const QString &dirPath);
+
+signals:
+    void directoryChanged(const QString &dirPath);
+
+private:
+    using Snapshot = QHash<QString, bool>; // File name, is directory
+
+    static bool listDir(const QString &dirPath, Snapshot &snapshot);
+    bool isRenamed(const QString &oldDirPath, const QString &newDirPath) const;
+
+    void watcherDirectoryChanged(const QString &path);
+    void emitPending();
+
+private:
+    QFileSystemWatcher m_watcher;
+    QHash<QString, Snapshot> m_snapshots;
+    QSet<QString> m_pending;
+    QTimer m_pendingTimer;
+};
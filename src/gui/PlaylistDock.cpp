@@ -19,6 +19,8 @@
 #include <PlaylistDock.hpp>
 #include <PlaylistWidget.hpp>
 
+#include <PlaylistDirWatcher.hpp>
+#include <PlaylistSnapshot.hpp>
 #include <EntryProperties.hpp>
 #include <LineEdit.hpp>
 #include <Settings.hpp>
@@ -37,6 +39,8 @@
 #include <QMessageBox>
 #include <QRandomGenerator>
 
+#include <algorithm>
+
 static bool urlMatchesWithItem(QTreeWidgetItem *item, const QString &url)
 {
     QString itemUrl = item->data(0, Qt::UserRole).toString();
@@ -57,6 +61,7 @@ PlaylistDock::PlaylistDock() :
     findE = new LineEdit;
     findE->setToolTip(tr("Filter entries"));
     statusL = new QLabel;
+    m_dirWatcher = new PlaylistDirWatcher(this);
 
     setMode();
 
@@ -71,6 +76,7 @@ PlaylistDock::PlaylistDock() :
     connect(list, SIGNAL(returnItem(QTreeWidgetItem *)), this, SLOT(addAndPlay(QTreeWidgetItem *)));
     connect(list, &PlaylistWidget::itemExpanded, this, &PlaylistDock::maybeDoQuickSync, Qt::QueuedConnection); // Must be queued to not crash at startup in some cases
     connect(list, SIGNAL(visibleItemsCount(int)), this, SLOT(visibleItemsCount(int)));
+    connect(m_dirWatcher, &PlaylistDirWatcher::directoryChanged, this, &PlaylistDock::watchedDirChanged);
     connect(list, SIGNAL(addStatus(bool)), findE, SLOT(setDisabled(bool)));
     connect(findE, SIGNAL(textChanged(const QString &)), this, SLOT(findItems(const QString &)));
     connect(findE, SIGNAL(returnPressed()), this, SLOT(findNext()));
@@ -106,16 +112,46 @@ void PlaylistDock::load(const QString &url)
 }
 bool PlaylistDock::save(const QString &_url, bool saveCurrentGroup)
 {
-    const QString url = Functions::Url(_url);
-    QList<QTreeWidgetItem *> parents;
+    return Playlist::write(getEntries(saveCurrentGroup), Functions::Url(_url));
+}
+
+void PlaylistDock::loadSession()
+{
+    Playlist::Entries entries;
+    if (PlaylistSnapshot::read(getSessionFilePath(), entries) && list->setEntries(entries))
+        return;
+
+    // Text playlist from older versions, it's removed when the session is saved
+    const QString oldSessionFilePath = QMPlay2Core.getSettingsDir() + "Playlist.pls";
+    if (QFileInfo::exists(oldSessionFilePath))
+        load(oldSessionFilePath);
+}
+bool PlaylistDock::saveSession()
+{
+    if (!PlaylistSnapshot::write(getSessionFilePath(), getEntries(false)))
+        return false;
+    QFile::remove(QMPlay2Core.getSettingsDir() + "Playlist.pls"); // Don't load the stale playlist if the session file is invalid
+    return true;
+}
+
+QString PlaylistDock::getSessionFilePath()
+{
+    return QMPlay2Core.getSettingsDir() + "Playlist.bin";
+}
+
+Playlist::Entries PlaylistDock::getEntries(bool currentGroup) const
+{
+    const QList<QTreeWidgetItem *> items = list->getChildren(PlaylistWidget::ALL_CHILDREN, currentGroup ? list->currentItem() : nullptr);
+    QHash<const QTreeWidgetItem *, qint32> parents;
     Playlist::Entries entries;
-    for (QTreeWidgetItem *tWI : list->getChildren(PlaylistWidget::ALL_CHILDREN, saveCurrentGroup ? list->currentItem() : nullptr))
+    entries.reserve(items.size());
+    for (QTreeWidgetItem *tWI : items)
     {
         Playlist::Entry entry;
         if (PlaylistWidget::isGroup(tWI))
         {
-            parents += tWI;
-            entry.GID = parents.size();
+            entry.GID = parents.size() + 1;
+            parents.insert(tWI, entry.GID);
         }
         else
         {
@@ -125,14 +161,14 @@ bool PlaylistDock::save(const QString &_url, bool saveCurrentGroup)
         entry.url = tWI->data(0, Qt::UserRole).toString();
         entry.name = tWI->text(0);
         if (tWI->parent())
-            entry.parent = parents.indexOf(tWI->parent()) + 1;
+            entry.parent = parents.value(tWI->parent());
         if (tWI == list->currentItem())
             entry.flags |= Playlist::Entry::Selected;
         entry.flags |= PlaylistWidget::getFlags(tWI); //Additional flags
         entry.params = tWI->data(0, Qt::UserRole + 3).value<QHash<QByteArray, QByteArray>>();
         entries += entry;
     }
-    return Playlist::write(entries, url);
+    return entries;
 }
 
 void PlaylistDock::add(const QStringList &urls)
@@ -268,6 +304,81 @@ inline bool PlaylistDock::isRandomPlayback() const
     return (repeatMode == RandomMode || repeatMode == RandomGroupMode || repeatMode == RepeatRandom || repeatMode == RepeatRandomGroup);
 }
 
+QTreeWidgetItem *PlaylistDock::predictNext() const
+{
+    // Like "next()" when called after the end of playback, but without side effects. Random
+    // playback is not predictable. Wrong prediction just discards the preloaded entry.
+    if (repeatMode == RepeatStopAfter || isRandomPlayback())
+        return nullptr;
+
+    const QList<QTreeWidgetItem *> &l = list->nonGroupItems();
+    QTreeWidgetItem *last = list->containsNonGroupItem(lastPlaying) ? lastPlaying : nullptr;
+    if (PlaylistWidget::getFlags(last) & Playlist::Entry::StopAfter)
+        return nullptr;
+    if (repeatMode == RepeatEntry)
+        return last ? last : list->currentItem();
+    if (!list->queue.isEmpty())
+        return list->queue.first();
+
+    QTreeWidgetItem *curr = list->currentPlaying ? list->currentPlaying : list->currentItem();
+    const int currIdx = list->indexOfNonGroupItem(curr);
+    if (currIdx < 0)
+        return nullptr;
+
+    QTreeWidgetItem *P = curr->parent();
+    for (int i = currIdx + 1; i < l.count(); ++i)
+    {
+        QTreeWidgetItem *tWI = l.at(i);
+        if (repeatMode == RepeatGroup && P && tWI->parent() != P) //loop group
+            break;
+        if (tWI->isHidden() || (PlaylistWidget::getFlags(tWI) & Playlist::Entry::Skip))
+            continue;
+        return tWI;
+    }
+    if (repeatMode == RepeatGroup && P)
+    {
+        const QList<QTreeWidgetItem *> l2 = list->getChildren(PlaylistWidget::ONLY_NON_GROUPS, P);
+        return l2.value(0);
+    }
+    if (repeatMode == RepeatList || repeatMode == RepeatGroup) //loop list
+        return l.value(0);
+    return nullptr;
+}
+
+QTreeWidgetItem *PlaylistDock::nextShuffledItem(const QList<QTreeWidgetItem *> &l)
+{
+    // Items are picked in order of a random permutation, so every item is checked at most once per round
+    auto shuffle = [this] {
+        std::shuffle(m_shuffledItems.begin(), m_shuffledItems.end(), *QRandomGenerator::global());
+        m_shufflePos = 0;
+    };
+    if (m_shuffleSource != l)
+    {
+        m_shuffleSource = l;
+        m_shuffledItems = l;
+        shuffle();
+    }
+
+    // Two rounds at most, because the permutation can be reshuffled in the middle
+    for (int i = 0; i < m_shuffledItems.count() * 2; ++i)
+    {
+        if (m_shufflePos >= m_shuffledItems.count())
+            shuffle();
+        QTreeWidgetItem *tWI = m_shuffledItems.at(m_shufflePos++);
+        if (PlaylistWidget::getFlags(tWI) & Playlist::Entry::Skip)
+        {
+            //Don't play skipped item.
+            randomPlayedItems.insert(tWI);
+            if (randomPlayedItems.count() == l.count())
+                break; //Stop playback if played everything ignoring skipped entries
+            continue;
+        }
+        if (tWI != lastPlaying && !randomPlayedItems.contains(tWI))
+            return tWI;
+    }
+    return nullptr;
+}
+
 void PlaylistDock::doGroupSync(bool quick, QTreeWidgetItem *tWI, bool quickRecursive)
 {
     if (!tWI || !PlaylistWidget::isGroup(tWI))
@@ -294,16 +405,36 @@ void PlaylistDock::doGroupSync(bool quick, QTreeWidgetItem *tWI, bool quickRecur
     }
     else if (pthInfo.isDir())
     {
+        // Directory watcher applies changes as they happen, so expanding a watched group doesn't need a rescan
+        if (!quickRecursive && m_dirWatcher->isWatched(pth))
+            return;
+        const bool canWatch = list->canModify() && PlaylistWidget::isAlwaysSynced(tWI) && PlaylistDirWatcher::canWatch(pth);
         findE->clear();
         list->quickSync(pth, tWI, quickRecursive, lastPlaying);
+        if (canWatch)
+            m_dirWatcher->watch(pth);
     }
 }
+QTreeWidgetItem *PlaylistDock::findSyncedGroup(const QString &dirPath)
+{
+    for (QTreeWidgetItem *tWI : list->getChildren(PlaylistWidget::ONLY_GROUPS))
+    {
+        QString pth = tWI->data(0, Qt::UserRole).toString();
+        if (pth.startsWith("file://"))
+            pth.remove(0, 7);
+        if (!pth.endsWith("/"))
+            pth += "/";
+        if (pth == dirPath && PlaylistWidget::isAlwaysSynced(tWI))
+            return tWI;
+    }
+    return nullptr;
+}
 
 bool PlaylistDock::maybeDeleteTreeWidgetItem(QTreeWidgetItem *tWI)
 {
     if (PlaylistWidget::getFlags(tWI) & Playlist::Entry::Locked)
         return false;
-    randomPlayedItems.removeOne(tWI);
+    randomPlayedItems.remove(tWI);
     if (lastPlaying == tWI)
         lastPlaying = nullptr;
     delete tWI;
@@ -350,8 +481,8 @@ void PlaylistDock::itemDoubleClicked(QTreeWidgetItem *tWI)
     if (!list->currentPlaying || list->currentItem() == list->currentPlaying)
         list->setCurrentItem(tWI);
 
-    if (isRandomPlayback() && !randomPlayedItems.contains(tWI))
-        randomPlayedItems.append(tWI);
+    if (isRandomPlayback())
+        randomPlayedItems.insert(tWI);
 
     lastPlaying = tWI;
 
@@ -405,14 +536,36 @@ void PlaylistDock::maybeDoQuickSync(QTreeWidgetItem *item)
         doGroupSync(true, item, false);
 }
 
+void PlaylistDock::watchedDirChanged(const QString &dirPath)
+{
+    if (!list->canModify())
+    {
+        m_dirWatcher->postpone(dirPath);
+        return;
+    }
+
+    QTreeWidgetItem *tWI = findSyncedGroup(dirPath);
+    if (!tWI)
+    {
+        // Group has been removed or it's not synchronized anymore
+        m_dirWatcher->unwatch(dirPath, true);
+        return;
+    }
+
+    const PlaylistDirWatcher::Delta delta = m_dirWatcher->takeDelta(dirPath);
+    if (delta.lost || delta.isEmpty())
+        return; // Removed directory is handled by its parent group or by the next synchronization
+    list->quickSyncApply(dirPath, tWI, delta, lastPlaying);
+}
+
 void PlaylistDock::stopLoading()
 {
     list->addThr.stop();
 }
 void PlaylistDock::next(bool playingError)
 {
-    QList<QTreeWidgetItem *> l = list->getChildren(PlaylistWidget::ONLY_NON_GROUPS);
-    if (lastPlaying && !l.contains(lastPlaying))
+    QList<QTreeWidgetItem *> l = list->nonGroupItems();
+    if (lastPlaying && !list->containsNonGroupItem(lastPlaying))
         lastPlaying = nullptr;
     if (repeatMode == RepeatStopAfter)
     {
@@ -429,7 +582,7 @@ void PlaylistDock::next(bool playingError)
                 QTreeWidgetItem *P = list->currentPlaying ? list->currentPlaying->parent() : (list->currentItem() ? list->currentItem()->parent() : nullptr);
                 expandTree(P);
                 l = P ? list->getChildren(PlaylistWidget::ONLY_NON_GROUPS, P) : list->topLevelNonGroupsItems();
-                if (l.isEmpty() || (!randomPlayedItems.isEmpty() && randomPlayedItems.at(0)->parent() != P))
+                if (l.isEmpty() || (!randomPlayedItems.isEmpty() && (*randomPlayedItems.cbegin())->parent() != P))
                     randomPlayedItems.clear();
             }
             const bool playedEverything = (randomPlayedItems.count() == l.count());
@@ -439,22 +592,8 @@ void PlaylistDock::next(bool playingError)
             {
                 if (l.count() == 1)
                     tWI = l.at(0);
-                else do
-                {
-                    tWI = l.at(QRandomGenerator::global()->bounded(l.count()));
-                    if (PlaylistWidget::getFlags(tWI) & Playlist::Entry::Skip)
-                    {
-                        //Don't play skipped item.
-                        if (!randomPlayedItems.contains(tWI))
-                            randomPlayedItems.append(tWI);
-                        if (randomPlayedItems.count() == l.count())
-                        {
-                            //Break and stop playback if played everything ignoring skipped entries
-                            tWI = nullptr;
-                            break;
-                        }
-                    }
-                } while (lastPlaying == tWI || randomPlayedItems.contains(tWI));
+                else
+                    tWI = nextShuffledItem(l);
             }
         }
         else
@@ -510,12 +649,17 @@ void PlaylistDock::next(bool playingError)
     if (playingError && tWI == list->currentItem()) //don't play the same song if playback error occurred
     {
         if (isRandomPlayback())
-            randomPlayedItems.append(tWI);
+            randomPlayedItems.insert(tWI);
         emit stop();
     }
     else
         itemDoubleClicked(tWI);
 }
+void PlaylistDock::prepareNext()
+{
+    if (QTreeWidgetItem *tWI = predictNext())
+        emit preload(tWI->data(0, Qt::UserRole).toString());
+}
 void PlaylistDock::prev()
 {
     QTreeWidgetItem *tWI = nullptr;
@@ -764,7 +908,7 @@ void PlaylistDock::queue()
 }
 void PlaylistDock::findItems(const QString &txt)
 {
-    QList<QTreeWidgetItem *> itemsToShow = list->findItems(txt, Qt::MatchContains | Qt::MatchRecursive);
+    const QSet<QTreeWidgetItem *> itemsToShow = list->filterItems(txt);
     list->processItems(&itemsToShow, !txt.isEmpty());
     if (txt.isEmpty())
     {
@@ -838,7 +982,7 @@ void PlaylistDock::repeat()
             if (list->currentPlaying && isRandomPlayback())
             {
                 Q_ASSERT(randomPlayedItems.isEmpty());
-                randomPlayedItems.append(list->currentPlaying);
+                randomPlayedItems.insert(list->currentPlaying);
             }
             emit QMPlay2Core.statusBarMessage(act->text().remove('&'), 1500);
         }
@@ -20,7 +20,11 @@
 
 #include <DockWidget.hpp>
 #include <RepeatMode.hpp>
+#include <Playlist.hpp>
 
+#include <QSet>
+
+class PlaylistDirWatcher;
 class QTreeWidgetItem;
 class PlaylistWidget;
 class LineEdit;
@@ -40,6 +44,10 @@ public:
     void load(const QString &);
     bool save(const QString &, bool saveCurrentGroup = false);
 
+    // Session playlist restored on startup
+    void loadSession();
+    bool saveSession();
+
     void add(const QStringList &);
     void addAndPlay(const QStringList &);
     void add(const QString &);
@@ -61,13 +69,21 @@ private:
     void showEvent(QShowEvent *e) override;
 
 private:
+    static QString getSessionFilePath();
+
+    Playlist::Entries getEntries(bool currentGroup) const;
+
     void expandTree(QTreeWidgetItem *);
 
     void toggleEntryFlag(const int flag);
 
     inline bool isRandomPlayback() const;
 
+    QTreeWidgetItem *predictNext() const;
+    QTreeWidgetItem *nextShuffledItem(const QList<QTreeWidgetItem *> &l);
+
     void doGroupSync(bool quick, QTreeWidgetItem *tWI, bool quickRecursive = true);
+    QTreeWidgetItem *findSyncedGroup(const QString &dirPath);
 
     bool maybeDeleteTreeWidgetItem(QTreeWidgetItem *tWI);
 
@@ -78,19 +94,24 @@ private:
     PlaylistWidget *list;
     QLabel *statusL;
     LineEdit *findE;
+    PlaylistDirWatcher *m_dirWatcher;
 
     RepeatMode repeatMode;
 
     bool playAfterAdd;
     QTreeWidgetItem *lastPlaying;
-    QList<QTreeWidgetItem *> randomPlayedItems;
+    QSet<QTreeWidgetItem *> randomPlayedItems;
+    QList<QTreeWidgetItem *> m_shuffleSource, m_shuffledItems;
+    int m_shufflePos = 0;
 private slots:
     void itemDoubleClicked(QTreeWidgetItem *);
     void addAndPlay(QTreeWidgetItem *);
     void maybeDoQuickSync(QTreeWidgetItem *item);
+    void watchedDirChanged(const QString &dirPath);
 public slots:
     void stopLoading();
     void next(bool playingError = false);
+    void prepareNext();
     void prev();
     void skip();
     void stopAfter();
@@ -126,6 +147,7 @@ public slots:
     void updateCurrentEntry(const QString &, double);
 signals:
     void play(const QString &);
+    void preload(const QString &);
     void repeatEntry(bool b);
     void stop();
     void addAndPlayRestoreWindow();
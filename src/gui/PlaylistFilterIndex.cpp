@@ -0,0 +1,140 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <PlaylistFilterIndex.hpp>
+
+#include <QTreeWidgetItem>
+
+#include <algorithm>
+
+static inline quint64 trigramAt(const QString &text, int idx)
+{
+    return (static_cast<quint64>(text.at(idx).unicode()) << 32)
+         | (static_cast<quint64>(text.at(idx + 1).unicode()) << 16)
+         | (static_cast<quint64>(text.at(idx + 2).unicode()))
+    ;
+}
+
+static QVector<quint64> getTrigrams(const QString &text)
+{
+    QVector<quint64> trigrams;
+    if (text.size() < 3)
+        return trigrams;
+    trigrams.reserve(text.size() - 2);
+    for (int i = 0; i < text.size() - 2; ++i)
+        trigrams.append(trigramAt(text, i));
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+/**/
+
+void PlaylistFilterIndex::build(const QList<QTreeWidgetItem *> &items)
+{
+    invalidate();
+
+    m_items.reserve(items.size());
+    m_texts.reserve(items.size());
+    for (QTreeWidgetItem *tWI : items)
+    {
+        const int idx = m_items.size();
+        const QString text = (tWI->text(0) + '\n' + tWI->data(0, Qt::UserRole).toString()).toCaseFolded();
+        for (const quint64 trigram : getTrigrams(text))
+            m_trigrams[trigram].append(idx); // Sorted, because items are added in order
+        m_items.append(tWI);
+        m_texts.append(text);
+    }
+
+    m_valid = true;
+}
+void PlaylistFilterIndex::invalidate()
+{
+    m_items.clear();
+    m_texts.clear();
+    m_trigrams.clear();
+    m_valid = false;
+
+    m_lastText.clear();
+    m_lastMatches.clear();
+}
+
+QSet<QTreeWidgetItem *> PlaylistFilterIndex::find(const QString &text)
+{
+    const QString needle = text.toCaseFolded();
+
+    QSet<QTreeWidgetItem *> result;
+
+    if (needle.isEmpty())
+    {
+        m_lastText.clear();
+        m_lastMatches.clear();
+        result.reserve(m_items.size());
+        for (QTreeWidgetItem *tWI : std::as_const(m_items))
+            result.insert(tWI);
+        return result;
+    }
+
+    QVector<int> matches;
+    auto check = [&](int idx) {
+        if (m_texts.at(idx).contains(needle))
+            matches.append(idx);
+    };
+
+    if (!m_lastText.isEmpty() && needle.contains(m_lastText))
+    {
+        // Every item which matches the new text also matches the previous text
+        for (const int idx : std::as_const(m_lastMatches))
+            check(idx);
+    }
+    else if (needle.size() >= 3)
+    {
+        // Verify items from the shortest posting list
+        const QVector<int> *candidates = nullptr;
+        for (const quint64 trigram : getTrigrams(needle))
+        {
+            const auto it = m_trigrams.constFind(trigram);
+            if (it == m_trigrams.cend())
+            {
+                candidates = nullptr;
+                break;
+            }
+            if (!candidates || it->size() < candidates->size())
+                candidates = &it.value();
+        }
+        if (candidates)
+        {
+            for (const int idx : *candidates)
+                check(idx);
+        }
+    }
+    else
+    {
+        for (int idx = 0; idx < m_texts.size(); ++idx)
+            check(idx);
+    }
+
+    result.reserve(matches.size());
+    for (const int idx : std::as_const(matches))
+        result.insert(m_items.at(idx));
+
+    m_lastText = needle;
+    m_lastMatches = std::move(matches);
+
+    return result;
+}
@@ -0,0 +1,59 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QVector>
+#include <QString>
+#include <QHash>
+#include <QSet>
+
+class QTreeWidgetItem;
+
+/*
+ * Trigram index of playlist entry names and URLs used by the playlist filter.
+ * Typing more characters narrows down the previous result instead of scanning
+ * the whole playlist again.
+ */
+class PlaylistFilterIndex
+{
+    Q_DISABLE_COPY(PlaylistFilterIndex)
+
+public:
+    PlaylistFilterIndex() = default;
+
+    inline bool isValid() const
+    {
+        return m_valid;
+    }
+
+    void build(const QList<QTreeWidgetItem *> &items);
+    void invalidate();
+
+    // Case insensitive, returns all items for empty text
+    QSet<QTreeWidgetItem *> find(const QString &text);
+
+private:
+    QVector<QTreeWidgetItem *> m_items;
+    QVector<QString> m_texts;
+    QHash<quint64, QVector<int>> m_trigrams;
+    bool m_valid = false;
+
+    QString m_lastText;
+    QVector<int> m_lastMatches;
+};
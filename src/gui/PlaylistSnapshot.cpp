@@ -0,0 +1,103 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <PlaylistSnapshot.hpp>
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+
+#include <cstring>
+
+constexpr quint32 g_magic = 0x514D5053; // "QMPS"
+constexpr quint32 g_version = 1;
+constexpr QDataStream::Version g_streamVersion = QDataStream::Qt_5_15;
+
+QDataStream &operator <<(QDataStream &stream, const Playlist::Entry &entry)
+{
+    return stream << entry.name << entry.url << entry.params << entry.length << entry.flags << entry.queue << entry.GID << entry.parent;
+}
+QDataStream &operator >>(QDataStream &stream, Playlist::Entry &entry)
+{
+    return stream >> entry.name >> entry.url >> entry.params >> entry.length >> entry.flags >> entry.queue >> entry.GID >> entry.parent;
+}
+
+/**/
+
+bool PlaylistSnapshot::read(const QString &filePath, Playlist::Entries &entries)
+{
+    QFile f(filePath);
+    if (!f.open(QFile::ReadOnly) || f.size() <= 0)
+        return false;
+
+    const uchar *fileData = f.map(0, f.size());
+    if (!fileData)
+        return false;
+
+    // Doesn't copy the mapped data
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(fileData), f.size());
+    QDataStream stream(data);
+    stream.setVersion(g_streamVersion);
+
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    stream >> magic >> version;
+    if (magic != g_magic || version != g_version)
+        return false;
+
+    stream >> count;
+    if (stream.status() != QDataStream::Ok || count < 0 || count > data.size())
+        return false;
+
+    Playlist::Entries tmpEntries(count);
+    for (Playlist::Entry &entry : tmpEntries)
+    {
+        stream >> entry;
+        if (stream.status() != QDataStream::Ok)
+            return false;
+    }
+
+    entries = std::move(tmpEntries);
+    return true;
+}
+
+bool PlaylistSnapshot::write(const QString &filePath, const Playlist::Entries &entries)
+{
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(g_streamVersion);
+        stream << g_magic << g_version << static_cast<qint32>(entries.size());
+        for (const Playlist::Entry &entry : entries)
+            stream << entry;
+    }
+
+    QFile currentFile(filePath);
+    if (currentFile.open(QFile::ReadOnly) && currentFile.size() == data.size())
+    {
+        const uchar *currentData = currentFile.map(0, currentFile.size());
+        if (currentData && memcmp(currentData, data.constData(), data.size()) == 0)
+            return true;
+    }
+    currentFile.close();
+
+    QSaveFile f(filePath);
+    if (!f.open(QFile::WriteOnly) || f.write(data) != data.size())
+        return false;
+    return f.commit();
+}
@@ -0,0 +1,39 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <Playlist.hpp>
+
+class QDataStream;
+
+QDataStream &operator <<(QDataStream &stream, const Playlist::Entry &entry);
+QDataStream &operator >>(QDataStream &stream, Playlist::Entry &entry);
+
+/*
+ * Binary snapshot of the session playlist. It's much faster to read and write
+ * than text playlist formats, so it's used for the playlist restored on startup.
+ */
+namespace PlaylistSnapshot
+{
+    // Returns "false" if the file doesn't exist or it's not a valid snapshot
+    bool read(const QString &filePath, Playlist::Entries &entries);
+
+    // Atomic, the file is not rewritten if the snapshot is unchanged
+    bool write(const QString &filePath, const Playlist::Entries &entries);
+}
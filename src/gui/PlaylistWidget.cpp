@@ -26,7 +26,9 @@
 #include <Main.hpp>
 
 #include <QResizeEvent>
+#include <QStorageInfo>
 #include <QHeaderView>
+#include <QThreadPool>
 #include <QFileInfo>
 #include <QMimeData>
 #include <QPainter>
@@ -34,7 +36,12 @@
 #include <QMenu>
 #include <QDir>
 
-static inline QStringList getDirEntries(const QString &pth)
+#include <atomic>
+#include <deque>
+
+constexpr int g_maxProbesPerDevice = 4;
+
+static inline QStringList getDirEntries(const QString &pth, int *dirsCount = nullptr)
 {
     auto entries = QDir(pth).entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
 
@@ -49,6 +56,8 @@ static inline QStringList getDirEntries(const QString &pth)
         if (entry.isDir())
             dirEntries.push_back(entry.fileName());
     }
+    if (dirsCount)
+        *dirsCount = dirEntries.size();
     for (auto &&entry : entries)
     {
         if (!entry.isDir())
@@ -63,9 +72,14 @@ static inline void prependPath(QStringList &dirEntries, const QString &pth)
         dirEntries[i].prepend(pth);
 }
 
-static void entryCreated(const QString &url, int insertChildAt, QStringList &existingEntries)
+// Directories in existing entries end with '/', so the quick sync doesn't have to check the file system
+static inline QString existingEntryName(const QString &fileName, bool isDir)
+{
+    return isDir ? fileName + '/' : fileName;
+}
+static void entryCreated(const QString &url, bool isDir, int insertChildAt, QStringList &existingEntries)
 {
-    const QString fileName = Functions::fileName(url);
+    const QString fileName = existingEntryName(Functions::fileName(url), isDir);
     if (insertChildAt < 0 || insertChildAt >= existingEntries.count())
         existingEntries.append(fileName);
     else
@@ -119,7 +133,7 @@ UpdateEntryThr::UpdateEntryThr(PlaylistWidget &pLW) :
 
 void UpdateEntryThr::updateEntry(QTreeWidgetItem *item, const QString &name, double length)
 {
-    if (!item || !pLW.getChildren(PlaylistWidget::ONLY_NON_GROUPS).contains(item))
+    if (!item || !pLW.containsNonGroupItem(item))
         return;
     mutex.lock();
     itemsToUpdate += {item, pLW.getUrl(item), item->data(2, Qt::UserRole).toDouble(), name, length};
@@ -310,6 +324,11 @@ void AddThr::stop()
         pLW.enqueuedAddData.clear();
     }
     ioCtrl.abort();
+    {
+        QMutexLocker locker(&probeCtrlsMutex);
+        for (IOController<Demuxer> *probeCtrl : std::as_const(probeCtrls))
+            probeCtrl->abort();
+    }
     wait(TERMINATE_TIMEOUT);
     if (isRunning())
     {
@@ -337,11 +356,14 @@ void AddThr::deleteTreeWidgetItem(QTreeWidgetItem *tWI)
 
 void AddThr::run()
 {
-    Functions::DemuxersInfo demuxersInfo;
-    for (Module *module : QMPlay2Core.getPluginsInstance())
-        for (const Module::Info &mod : module->getModulesInfo())
-            if (mod.type == Module::DEMUXER)
-                demuxersInfo += {mod.name, mod.icon.isNull() ? module->icon() : mod.icon, mod.extensions};
+    const Functions::DemuxersInfo demuxersInfo = PlaylistWidget::getDemuxersInfo();
+    if (!loadList)
+    {
+        QStringList demuxersSignature;
+        for (const Functions::DemuxerInfo &demuxerInfo : std::as_const(demuxersInfo))
+            demuxersSignature += demuxerInfo.name + ":" + demuxerInfo.extensions.join(",");
+        mediaInfoCache.load(demuxersSignature.join(";"));
+    }
     add(urls, par, demuxersInfo, existingEntries.isEmpty() ? nullptr : &existingEntries, loadList);
     if (currentThread() == pLW.thread()) //jeżeli funkcja działa w głównym wątku
         finished();
@@ -368,6 +390,10 @@ bool AddThr::add(const QStringList &urls, QTreeWidgetItem *parent, const Functio
             playlistIndexesToSkip.clear();
     }
 
+    QHash<QString, MediaInfoCache::Info> probedFiles;
+    if (!loadList)
+        probedFiles = probeLocalFiles(urls, playlistIndexesToSkip);
+
     for (int i = 0; i < urls.size(); ++i)
     {
         if (ioCtrl.isAborted())
@@ -386,14 +412,14 @@ bool AddThr::add(const QStringList &urls, QTreeWidgetItem *parent, const Functio
             //For quick group sync only - find where to place the new item
             const QString newUrl = url.startsWith("file://") ? url.mid(7) : url;
             const QString newFileName = Functions::fileName(newUrl);
-            const QString filePath = Functions::filePath(newUrl);
             const bool newIsDir = QFileInfo(newUrl).isDir();
             insertChildAt = existingEntries->count();
             for (int i = 0; i < insertChildAt; ++i)
             {
-                const QString fileName = existingEntries->at(i);
-                const bool isDir = QFileInfo(filePath + fileName).isDir();
-                if ((newIsDir && !isDir) || (newIsDir == isDir && fileName > newFileName))
+                const QString &existingEntry = existingEntries->at(i);
+                const bool isDir = existingEntry.endsWith('/');
+                const QStringView fileName = isDir ? QStringView(existingEntry).chopped(1) : QStringView(existingEntry);
+                if ((newIsDir && !isDir) || (newIsDir == isDir && fileName.compare(newFileName) > 0))
                 {
                     insertChildAt = i;
                     break;
@@ -438,7 +464,7 @@ bool AddThr::add(const QStringList &urls, QTreeWidgetItem *parent, const Functio
                 if (!dirEntries.isEmpty())
                 {
                     url = Functions::cleanPath(url);
-                    QTreeWidgetItem *p = pLW.newGroup(Functions::fileName(url), url, currentItem, insertChildAt, existingEntries);
+                    QTreeWidgetItem *p = pLW.newGroup(Functions::fileName(url), url, currentItem, insertChildAt, existingEntries, true);
                     for (int j = dirEntries.size() - 1; j >= 0; j--)
                     {
                         dirEntries[j].prepend(url);
@@ -451,7 +477,7 @@ bool AddThr::add(const QStringList &urls, QTreeWidgetItem *parent, const Functio
                     else
                     {
                         if (existingEntries)
-                            existingEntries->removeOne(p->text(0));
+                            existingEntries->removeOne(existingEntryName(p->text(0), true));
                         QMetaObject::invokeMethod(this, "deleteTreeWidgetItem", Q_ARG(QTreeWidgetItem *, p));
                     }
                 }
@@ -476,33 +502,41 @@ bool AddThr::add(const QStringList &urls, QTreeWidgetItem *parent, const Functio
                         continue;
                     }
                 }
-                IOController<Demuxer> &demuxer = ioCtrl.toRef<Demuxer>();
-                Demuxer::FetchTracks fetchTracks(pLW.dontUpdateAfterAdd);
-                if (Demuxer::create(url, demuxer, &fetchTracks))
+                MediaInfoCache::Info info;
+                const auto probedIt = probedFiles.constFind(url);
+                if (probedIt != probedFiles.cend())
+                    info = probedIt.value();
+                else
+                {
+                    info = probeFile(url, ioCtrl.toRef<Demuxer>(), pLW.dontUpdateAfterAdd);
+                    if (!ioCtrl.isAborted() && canUseMediaInfoCache(url))
+                        mediaInfoCache.put(url.mid(7), info);
+                }
+
+                if (info.opened)
                 {
-                    if (sync == FILE_SYNC && fetchTracks.tracks.count() <= 1)
+                    if (sync == FILE_SYNC && info.tracks.count() <= 1)
                         hasOneEntry = false; //Don't allow adding single file when syncing a file group
-                    else if (fetchTracks.tracks.isEmpty())
+                    else if (info.tracks.isEmpty())
                     {
                         if (!displayOnlyFileName && entry.name.isEmpty())
-                            entry.name = demuxer->title();
-                        entry.length = demuxer->length();
+                            entry.name = info.title;
+                        entry.length = info.length;
                         hasOneEntry = true;
                     }
                     else
                     {
-                        QTreeWidgetItem *tmpFirstItem = insertPlaylistEntries(fetchTracks.tracks, currentItem, demuxersInfo, insertChildAt, existingEntries);
+                        QTreeWidgetItem *tmpFirstItem = insertPlaylistEntries(info.tracks, currentItem, demuxersInfo, insertChildAt, existingEntries);
                         if (!firstItem)
                             firstItem = tmpFirstItem;
                         hasOneEntry = false;
                         tracksAdded = true;
                     }
-                    demuxer.reset();
                 }
-                else if (!fetchTracks.isOK)
+                else if (!info.tracksOK)
                     hasOneEntry = false; //Don't add entry to list if error occured
 
-                if (sync == FILE_SYNC && (!fetchTracks.isOK || fetchTracks.tracks.count() <= 1))
+                if (sync == FILE_SYNC && (!info.tracksOK || info.tracks.count() <= 1))
                 {
                      //Change group name to "url" if error or only single file for file sync
                     QString groupName = url;
@@ -601,10 +635,129 @@ QTreeWidgetItem *AddThr::insertPlaylistEntries(const Playlist::Entries &entries,
     return firstItem;
 }
 
+bool AddThr::canUseMediaInfoCache(const QString &url) const
+{
+    if (pLW.dontUpdateAfterAdd || sync == FILE_SYNC || !url.startsWith("file://"))
+        return false;
+    return QFileInfo(url.mid(7)).isFile();
+}
+QHash<QString, MediaInfoCache::Info> AddThr::probeLocalFiles(const QStringList &urls, const QSet<int> &indexesToSkip)
+{
+    struct DeviceQueue
+    {
+        QStringList urls;
+        std::atomic_int next = 0;
+    };
+
+    QHash<QString, MediaInfoCache::Info> probedFiles;
+    QMutex probedFilesMutex;
+
+    const auto playlistExtensions = Playlist::extensions();
+    QHash<QString, QByteArray> dirDevices;
+    QHash<QByteArray, int> deviceQueueIdx;
+    std::deque<DeviceQueue> deviceQueues;
+    int filesToProbe = 0;
+
+    for (int i = 0; i < urls.size(); ++i)
+    {
+        if (indexesToSkip.contains(i))
+            continue;
+
+        const QString url = Functions::Url(urls.at(i));
+        if (!canUseMediaInfoCache(url) || playlistExtensions.contains(Functions::fileExt(url).toLower()))
+            continue;
+
+        const QString filePath = url.mid(7);
+
+        MediaInfoCache::Info info;
+        if (mediaInfoCache.get(filePath, info))
+        {
+            probedFiles.insert(url, info);
+            continue;
+        }
+
+        // Files on the same device are probed by a limited number of threads, so HDDs don't seek too much
+        const QString dir = Functions::filePath(filePath);
+        auto dirIt = dirDevices.find(dir);
+        if (dirIt == dirDevices.end())
+            dirIt = dirDevices.insert(dir, QStorageInfo(dir).device());
+
+        auto queueIt = deviceQueueIdx.constFind(dirIt.value());
+        if (queueIt == deviceQueueIdx.cend())
+        {
+            queueIt = deviceQueueIdx.insert(dirIt.value(), deviceQueues.size());
+            deviceQueues.emplace_back();
+        }
+        deviceQueues[queueIt.value()].urls += url;
+        ++filesToProbe;
+    }
+
+    if (filesToProbe < 2)
+        return probedFiles; // Single file will be probed in "add()"
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(qMin(filesToProbe, static_cast<int>(deviceQueues.size()) * g_maxProbesPerDevice));
+
+    for (DeviceQueue &deviceQueue : deviceQueues)
+    {
+        const int threads = qMin<int>(deviceQueue.urls.size(), g_maxProbesPerDevice);
+        for (int t = 0; t < threads; ++t)
+        {
+            threadPool.start([&] {
+                IOController<Demuxer> demuxer;
+                {
+                    QMutexLocker locker(&probeCtrlsMutex);
+                    probeCtrls.append(&demuxer);
+                    if (ioCtrl.isAborted())
+                        demuxer.abort();
+                }
+                for (;;)
+                {
+                    const int idx = deviceQueue.next++;
+                    if (idx >= deviceQueue.urls.size() || demuxer.isAborted())
+                        break;
+
+                    const QString &url = deviceQueue.urls.at(idx);
+                    const MediaInfoCache::Info info = probeFile(url, demuxer, false);
+                    if (demuxer.isAborted())
+                        break;
+
+                    mediaInfoCache.put(url.mid(7), info);
+
+                    QMutexLocker locker(&probedFilesMutex);
+                    probedFiles.insert(url, info);
+                }
+                QMutexLocker locker(&probeCtrlsMutex);
+                probeCtrls.removeOne(&demuxer);
+            });
+        }
+    }
+
+    threadPool.waitForDone();
+
+    return probedFiles;
+}
+MediaInfoCache::Info AddThr::probeFile(const QString &url, IOController<Demuxer> &demuxer, bool onlyTracks)
+{
+    MediaInfoCache::Info info;
+    Demuxer::FetchTracks fetchTracks(onlyTracks);
+    info.opened = Demuxer::create(url, demuxer, &fetchTracks);
+    info.tracksOK = fetchTracks.isOK;
+    info.tracks = std::move(fetchTracks.tracks);
+    if (info.opened && info.tracks.isEmpty())
+    {
+        info.title = demuxer->title();
+        info.length = demuxer->length();
+    }
+    demuxer.reset();
+    return info;
+}
+
 void AddThr::finished()
 {
     if (pLW.addTimer.isActive())
         return; //Don't finish, because this thread will be started soon again
+    mediaInfoCache.save();
     if (!pLW.currPthToSave.isNull())
     {
         QMPlay2GUI.setCurrentPth(pLW.currPthToSave);
@@ -670,6 +823,23 @@ PlaylistWidget::PlaylistWidget() :
     connect(&addTimer, SIGNAL(timeout()), this, SLOT(addTimerElapsed()));
     connect(&addThr, SIGNAL(status(bool)), this, SIGNAL(addStatus(bool)));
     connect(playlistMenu(), &MenuBar::Playlist::aboutToShow, this, &PlaylistWidget::createExtensionsMenu);
+
+    connect(model(), &QAbstractItemModel::rowsInserted, this, &PlaylistWidget::invalidateItemsIndex);
+    connect(model(), &QAbstractItemModel::rowsRemoved, this, &PlaylistWidget::invalidateItemsIndex);
+    connect(model(), &QAbstractItemModel::rowsMoved, this, &PlaylistWidget::invalidateItemsIndex);
+    connect(model(), &QAbstractItemModel::layoutChanged, this, &PlaylistWidget::invalidateItemsIndex);
+    connect(model(), &QAbstractItemModel::modelReset, this, &PlaylistWidget::invalidateItemsIndex);
+    connect(model(), &QAbstractItemModel::dataChanged, this, &PlaylistWidget::itemsDataChanged);
+}
+
+Functions::DemuxersInfo PlaylistWidget::getDemuxersInfo()
+{
+    Functions::DemuxersInfo demuxersInfo;
+    for (Module *module : QMPlay2Core.getPluginsInstance())
+        for (const Module::Info &mod : module->getModulesInfo())
+            if (mod.type == Module::DEMUXER)
+                demuxersInfo += {mod.name, mod.icon.isNull() ? module->icon() : mod.icon, mod.extensions};
+    return demuxersInfo;
 }
 
 QString PlaylistWidget::getUrl(QTreeWidgetItem *tWI) const
@@ -831,6 +1001,32 @@ QList <QTreeWidgetItem * > PlaylistWidget::getChildren(CHILDREN children, const
     return list;
 }
 
+const QList<QTreeWidgetItem *> &PlaylistWidget::nonGroupItems()
+{
+    if (!m_itemsIndexValid)
+    {
+        m_nonGroupItems = getChildren(ONLY_NON_GROUPS);
+        m_nonGroupIndexes.clear();
+        m_nonGroupIndexes.reserve(m_nonGroupItems.size());
+        for (int i = 0; i < m_nonGroupItems.size(); ++i)
+            m_nonGroupIndexes.insert(m_nonGroupItems.at(i), i);
+        m_itemsIndexValid = true;
+    }
+    return m_nonGroupItems;
+}
+int PlaylistWidget::indexOfNonGroupItem(QTreeWidgetItem *tWI)
+{
+    nonGroupItems();
+    return m_nonGroupIndexes.value(tWI, -1);
+}
+
+QSet<QTreeWidgetItem *> PlaylistWidget::filterItems(const QString &text)
+{
+    if (!m_filterIndex.isValid())
+        m_filterIndex.build(getChildren(ALL_CHILDREN));
+    return m_filterIndex.find(text);
+}
+
 bool PlaylistWidget::canModify(bool all) const
 {
     if (addThr.running)
@@ -869,12 +1065,11 @@ void PlaylistWidget::enqueue()
 }
 void PlaylistWidget::refresh(REFRESH Refresh)
 {
-    const QList<QTreeWidgetItem *> items = getChildren(ONLY_NON_GROUPS);
     if (Refresh & REFRESH_QUEUE)
     {
         for (int i = 0; i < queue.size(); i++)
         {
-            if (!items.contains(queue.at(i)))
+            if (!containsNonGroupItem(queue.at(i)))
                 queue.removeAt(i--);
             else
                 queue.at(i)->setText(1, QString::number(i + 1));
@@ -883,44 +1078,54 @@ void PlaylistWidget::refresh(REFRESH Refresh)
     }
     if (Refresh & REFRESH_GROUPS_TIME)
     {
+        // Sum lengths of direct children, nested groups are computed before their parents
+        QHash<QTreeWidgetItem *, double> lengths;
+        for (QTreeWidgetItem *tWI : nonGroupItems())
+        {
+            const double l = tWI->data(2, Qt::UserRole).toDouble();
+            if (l > 0.0 && tWI->parent())
+                lengths[tWI->parent()] += l;
+        }
         const QList<QTreeWidgetItem *> groups = getChildren(ONLY_GROUPS);
         for (int i = groups.size() - 1; i >= 0; i--)
         {
-            double length = 0.0;
-            for (QTreeWidgetItem *tWI : getChildren(ALL_CHILDREN, groups.at(i)))
-            {
-                if (tWI->parent() != groups.at(i))
-                    continue;
-                const double l = tWI->data(2, Qt::UserRole).toDouble();
-                if (l > 0.0)
-                    length += l;
-            }
+            QTreeWidgetItem *group = groups.at(i);
+            const double length = lengths.value(group);
             const bool hasLength = !qFuzzyIsNull(length);
-            groups.at(i)->setText(2, hasLength ? Functions::timeToStr(length) : QString());
-            groups.at(i)->setData(2, Qt::UserRole, hasLength ? length : QVariant());
+            group->setText(2, hasLength ? Functions::timeToStr(length) : QString());
+            group->setData(2, Qt::UserRole, hasLength ? length : QVariant());
+            if (length > 0.0 && group->parent())
+                lengths[group->parent()] += length;
         }
     }
-    if ((Refresh & REFRESH_CURRPLAYING) && !items.contains(currentPlaying))
+    if ((Refresh & REFRESH_CURRPLAYING) && !containsNonGroupItem(currentPlaying))
         clearCurrentPlaying(false);
 }
 
-void PlaylistWidget::processItems(QList<QTreeWidgetItem *> *itemsToShow, bool hideGroups)
+void PlaylistWidget::processItems(const QSet<QTreeWidgetItem *> *itemsToShow, bool hideGroups)
 {
+    QSet<QTreeWidgetItem *> visibleGroups;
+    const auto showParents = [&](QTreeWidgetItem *tWI) {
+        for (QTreeWidgetItem *parent = tWI->parent(); parent && !visibleGroups.contains(parent); parent = parent->parent())
+            visibleGroups.insert(parent);
+    };
+
     int count = 0;
     hasHiddenItems = false;
-    for (QTreeWidgetItem *tWI : getChildren(PlaylistWidget::ONLY_NON_GROUPS))
+    for (QTreeWidgetItem *tWI : nonGroupItems())
     {
         if (itemsToShow)
-        {
-            const int idx = itemsToShow->indexOf(tWI);
-            tWI->setHidden(idx < 0);
-            if (idx > -1)
-                itemsToShow->removeAt(idx);
-        }
+            tWI->setHidden(!itemsToShow->contains(tWI));
         if (tWI->isHidden())
+        {
             hasHiddenItems = true;
+        }
         else
+        {
+            if (itemsToShow && hideGroups)
+                showParents(tWI);
             count++;
+        }
     }
     emit visibleItemsCount(count);
 
@@ -929,27 +1134,16 @@ void PlaylistWidget::processItems(QList<QTreeWidgetItem *> *itemsToShow, bool hi
 
     // Hide empty groups which doesn't exist in "itemsToShow" list
     const QList<QTreeWidgetItem *> groups = getChildren(ONLY_GROUPS);
-    for (int i = groups.size() - 1; i >= 0; i--)
+    if (hideGroups)
     {
-        QTreeWidgetItem *group = groups.at(i);
-        if (hideGroups && !itemsToShow->contains(group))
-        {
-            bool hasVisibleItems = false;
-            for (QTreeWidgetItem *tWI : getChildren(ALL_CHILDREN, group))
-            {
-                if (!tWI->isHidden())
-                {
-                    hasVisibleItems = true;
-                    break;
-                }
-            }
-            group->setHidden(!hasVisibleItems);
-        }
-        else
+        for (QTreeWidgetItem *group : groups)
         {
-            group->setHidden(false);
+            if (itemsToShow->contains(group))
+                showParents(group);
         }
     }
+    for (QTreeWidgetItem *group : groups)
+        group->setHidden(hideGroups && !itemsToShow->contains(group) && !visibleGroups.contains(group));
 }
 
 bool PlaylistWidget::isAlwaysSynced(QTreeWidgetItem *tWI, bool parentOnly)
@@ -974,16 +1168,32 @@ void PlaylistWidget::setEntryFont(QTreeWidgetItem *tWI, const int flags)
     tWI->setFont(0, font);
 }
 
-QTreeWidgetItem *PlaylistWidget::newGroup(const QString &name, const QString &url, QTreeWidgetItem *parent, int insertChildAt, QStringList *existingEntries)
+QTreeWidgetItem *PlaylistWidget::createGroupItem(const QString &name, const QString &url)
 {
     QTreeWidgetItem *tWI = new PlaylistItem;
-
     tWI->setFlags(tWI->flags() | Qt::ItemIsEditable);
     tWI->setText(0, name);
     tWI->setData(0, Qt::UserRole, url);
+    return tWI;
+}
+QTreeWidgetItem *PlaylistWidget::createEntryItem(const Playlist::Entry &entry)
+{
+    QTreeWidgetItem *tWI = new PlaylistItem;
+    tWI->setFlags(tWI->flags() &~ Qt::ItemIsDropEnabled);
+    tWI->setText(0, entry.name);
+    tWI->setData(0, Qt::UserRole, entry.url);
+    tWI->setData(0, Qt::UserRole + 3, QVariant::fromValue(entry.params));
+    tWI->setText(2, Functions::timeToStr(entry.length));
+    tWI->setData(2, Qt::UserRole, entry.length);
+    return tWI;
+}
+
+QTreeWidgetItem *PlaylistWidget::newGroup(const QString &name, const QString &url, QTreeWidgetItem *parent, int insertChildAt, QStringList *existingEntries, bool isDir)
+{
+    QTreeWidgetItem *tWI = createGroupItem(name, url);
 
     if (existingEntries)
-        entryCreated(url, insertChildAt, *existingEntries);
+        entryCreated(url, isDir, insertChildAt, *existingEntries);
 
     QMetaObject::invokeMethod(this, [this, tWI, url, parent, insertChildAt] {
         QMPlay2GUI.setTreeWidgetItemIcon(tWI, url.isEmpty() ? *QMPlay2GUI.groupIcon : *QMPlay2GUI.folderIcon, 0, this);
@@ -994,20 +1204,13 @@ QTreeWidgetItem *PlaylistWidget::newGroup(const QString &name, const QString &ur
 }
 QTreeWidgetItem *PlaylistWidget::newEntry(const Playlist::Entry &entry, QTreeWidgetItem *parent, const Functions::DemuxersInfo &demuxersInfo, int insertChildAt, QStringList *existingEntries)
 {
-    QTreeWidgetItem *tWI = new PlaylistItem;
+    QTreeWidgetItem *tWI = createEntryItem(entry);
 
     QIcon icon;
     Functions::getDataIfHasPluginPrefix(entry.url, nullptr, nullptr, &icon, nullptr, demuxersInfo);
 
-    tWI->setFlags(tWI->flags() &~ Qt::ItemIsDropEnabled);
-    tWI->setText(0, entry.name);
-    tWI->setData(0, Qt::UserRole, entry.url);
-    tWI->setData(0, Qt::UserRole + 3, QVariant::fromValue(entry.params));
-    tWI->setText(2, Functions::timeToStr(entry.length));
-    tWI->setData(2, Qt::UserRole, entry.length);
-
     if (existingEntries)
-        entryCreated(entry.url, insertChildAt, *existingEntries);
+        entryCreated(entry.url, false, insertChildAt, *existingEntries);
 
     QMetaObject::invokeMethod(this, [this, tWI, icon, parent, insertChildAt] {
         setEntryIcon(icon, tWI);
@@ -1017,6 +1220,85 @@ QTreeWidgetItem *PlaylistWidget::newEntry(const Playlist::Entry &entry, QTreeWid
     return tWI;
 }
 
+bool PlaylistWidget::setEntries(const Playlist::Entries &entries)
+{
+    if (!canModify() || !enqueuedAddData.isEmpty())
+        return false;
+
+    const Functions::DemuxersInfo demuxersInfo = getDemuxersInfo();
+
+    clear();
+
+    // Items are created outside the tree and inserted at once, so the view is not
+    // updated for every item. Icons are shared between items with the same icon.
+    QHash<qint64, QVariant> decorations;
+    auto setIcon = [&](QTreeWidgetItem *tWI, const QIcon &icon) {
+        const auto it = decorations.constFind(icon.cacheKey());
+        if (it != decorations.cend())
+        {
+            tWI->setData(0, Qt::DecorationRole, it.value());
+            return;
+        }
+        QMPlay2GUI.setTreeWidgetItemIcon(tWI, icon, 0, this);
+        decorations.insert(icon.cacheKey(), tWI->data(0, Qt::DecorationRole));
+    };
+
+    QList<QTreeWidgetItem *> topLevelItems, groupList;
+    QTreeWidgetItem *firstItem = nullptr;
+    for (const Playlist::Entry &entry : entries)
+    {
+        QTreeWidgetItem *tWI;
+        if (entry.GID)
+        {
+            tWI = createGroupItem(entry.name, entry.url);
+            setIcon(tWI, entry.url.isEmpty() ? *QMPlay2GUI.groupIcon : *QMPlay2GUI.folderIcon);
+            groupList += tWI;
+        }
+        else
+        {
+            tWI = createEntryItem(entry);
+
+            QIcon icon;
+            Functions::getDataIfHasPluginPrefix(entry.url, nullptr, nullptr, &icon, nullptr, demuxersInfo);
+            setIcon(tWI, icon.isNull() ? *QMPlay2GUI.mediaIcon : icon);
+
+            if (entry.queue) //Rebuild queue
+            {
+                while (queue.size() < entry.queue)
+                    queue += nullptr;
+                queue[entry.queue - 1] = tWI;
+            }
+            if (!firstItem)
+                firstItem = tWI;
+        }
+
+        if (const int flags = (entry.flags &~ Playlist::Entry::Selected))
+        {
+            setEntryFont(tWI, flags);
+            tWI->setData(0, Qt::UserRole + 1, flags);
+        }
+        if (entry.flags & Playlist::Entry::Selected)
+            firstItem = tWI;
+
+        const int idx = entry.parent - 1;
+        if (idx >= 0 && idx < groupList.size())
+            groupList.at(idx)->addChild(tWI);
+        else
+            topLevelItems += tWI;
+    }
+    queue.removeAll(nullptr);
+
+    setItemsResizeToContents(false);
+    addTopLevelItems(topLevelItems);
+    refresh();
+    setItemsResizeToContents(true);
+    if (firstItem)
+        setCurrentItem(firstItem);
+    processItems();
+
+    return true;
+}
+
 void PlaylistWidget::setEntryIcon(const QIcon &icon, QTreeWidgetItem *tWI)
 {
     Q_ASSERT(QThread::currentThread() == thread());
@@ -1038,28 +1320,30 @@ void PlaylistWidget::setEntryIcon(const QIcon &icon, QTreeWidgetItem *tWI)
 
 void PlaylistWidget::quickSyncScanDirs(const QString &pth, QTreeWidgetItem *par, bool &mustRefresh, bool recursive, QTreeWidgetItem *&itemToNull)
 {
-    QStringList dirEntries = getDirEntries(pth);
+    int dirsCount = 0;
+    QStringList dirEntries = getDirEntries(pth, &dirsCount);
     QStringList existingEntries;
 
+    QHash<QString, int> dirEntriesIndexes;
+    dirEntriesIndexes.reserve(dirEntries.size());
+    for (int i = 0; i < dirEntries.size(); ++i)
+        dirEntriesIndexes.insert(dirEntries.at(i), i);
+    QVector<bool> dirEntriesExisting(dirEntries.size());
+
     for (int i = par->childCount() - 1; i >= 0; --i)
     {
         QTreeWidgetItem *item = par->child(i);
 
         const QString itemFileName = Functions::fileName(item->data(0, Qt::UserRole).toString());
         const bool isGroup = PlaylistWidget::isGroup(item);
-        const int urlIdx = dirEntries.indexOf(itemFileName);
-        QString fullPth = urlIdx > -1 ? pth + dirEntries.at(urlIdx) : QString();
+        const int urlIdx = dirEntriesIndexes.value(itemFileName, -1);
 
-        if (urlIdx > -1 && isGroup == QFileInfo(fullPth).isDir())
+        if (urlIdx > -1 && !dirEntriesExisting.at(urlIdx) && isGroup == (urlIdx < dirsCount))
         {
-            existingEntries.prepend(itemFileName);
-            dirEntries.removeAt(urlIdx);
+            existingEntries.prepend(existingEntryName(itemFileName, isGroup));
+            dirEntriesExisting[urlIdx] = true;
             if (isGroup && recursive)
-            {
-                if (!fullPth.endsWith('/'))
-                    fullPth.append('/');
-                quickSyncScanDirs(fullPth, item, mustRefresh, recursive, itemToNull);
-            }
+                quickSyncScanDirs(pth + dirEntries.at(urlIdx) + '/', item, mustRefresh, recursive, itemToNull);
         }
         else
         {
@@ -1070,13 +1354,96 @@ void PlaylistWidget::quickSyncScanDirs(const QString &pth, QTreeWidgetItem *par,
         }
     }
 
-    if (!dirEntries.isEmpty())
+    QStringList newEntries;
+    for (int i = 0; i < dirEntries.size(); ++i)
     {
-        prependPath(dirEntries, pth);
-        add(dirEntries, par, existingEntries, false, true);
+        if (!dirEntriesExisting.at(i))
+            newEntries += pth + dirEntries.at(i);
+    }
+    if (!newEntries.isEmpty())
+    {
+        add(newEntries, par, existingEntries, false, true);
         mustRefresh = false;
     }
 }
+void PlaylistWidget::quickSyncApply(const QString &pth, QTreeWidgetItem *par, const PlaylistDirWatcher::Delta &delta, QTreeWidgetItem *&itemToNull)
+{
+    QHash<QString, QTreeWidgetItem *> children;
+    children.reserve(par->childCount());
+    for (int i = 0; i < par->childCount(); ++i)
+    {
+        QTreeWidgetItem *item = par->child(i);
+        children.insert(Functions::fileName(item->data(0, Qt::UserRole).toString()), item);
+    }
+
+    bool mustRefresh = false;
+
+    for (const QString &fileName : delta.removed)
+    {
+        QTreeWidgetItem *item = children.take(fileName);
+        if (!item)
+            continue;
+        if (itemToNull == item)
+            itemToNull = nullptr;
+        delete item;
+        mustRefresh = true;
+    }
+
+    QStringList created;
+    for (const QString &fileName : delta.created)
+    {
+        if (!children.contains(fileName))
+            created += pth + fileName;
+    }
+
+    for (auto &&renamed : delta.renamed)
+    {
+        QTreeWidgetItem *item = children.take(renamed.first);
+        if (!item || !isGroup(item))
+        {
+            created += pth + renamed.second;
+            continue;
+        }
+
+        // Replace the directory prefix in the whole subtree instead of adding it again
+        const QString oldUrl = item->data(0, Qt::UserRole).toString();
+        const QString newUrl = oldUrl.left(oldUrl.length() - renamed.first.length()) + renamed.second;
+        QVector<QTreeWidgetItem *> items {item};
+        while (!items.isEmpty())
+        {
+            QTreeWidgetItem *tWI = items.takeLast();
+            const QString url = tWI->data(0, Qt::UserRole).toString();
+            if (url == oldUrl || url.startsWith(oldUrl + '/'))
+                tWI->setData(0, Qt::UserRole, newUrl + url.mid(oldUrl.length()));
+            for (int i = 0; i < tWI->childCount(); ++i)
+                items.append(tWI->child(i));
+        }
+        if (item->text(0) == renamed.first)
+            item->setText(0, renamed.second);
+        children.insert(renamed.second, item);
+        mustRefresh = true;
+    }
+
+    if (!created.isEmpty())
+    {
+        // Existing entries must be in the same order as children
+        QStringList existingEntries;
+        existingEntries.reserve(par->childCount());
+        for (int i = 0; i < par->childCount(); ++i)
+        {
+            QTreeWidgetItem *item = par->child(i);
+            existingEntries += existingEntryName(Functions::fileName(item->data(0, Qt::UserRole).toString()), isGroup(item));
+        }
+        add(created, par, existingEntries, false, true);
+        mustRefresh = false;
+    }
+
+    if (mustRefresh && canModify())
+    {
+        refresh();
+        processItems();
+    }
+}
 
 void PlaylistWidget::createExtensionsMenu()
 {
@@ -1232,6 +1599,21 @@ void PlaylistWidget::insertItem(QTreeWidgetItem *tWI, QTreeWidgetItem *parent, i
         addTopLevelItem(tWI);
     }
 }
+void PlaylistWidget::invalidateItemsIndex()
+{
+    m_itemsIndexValid = false;
+    m_nonGroupItems.clear();
+    m_nonGroupIndexes.clear();
+    m_filterIndex.invalidate();
+}
+void PlaylistWidget::itemsDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    Q_UNUSED(bottomRight)
+    // Only names and URLs are indexed for filtering
+    if (topLeft.column() == 0 && (roles.isEmpty() || roles.contains(Qt::DisplayRole) || roles.contains(Qt::EditRole) || roles.contains(Qt::UserRole)))
+        m_filterIndex.invalidate();
+}
+
 void PlaylistWidget::popupContextMenu(const QPoint &p)
 {
     playlistMenu()->popup(mapToGlobal(p));
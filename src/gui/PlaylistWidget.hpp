@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <PlaylistFilterIndex.hpp>
+#include <PlaylistDirWatcher.hpp>
+#include <MediaInfoCache.hpp>
 #include <IOController.hpp>
 #include <Functions.hpp>
 #include <Playlist.hpp>
@@ -28,6 +31,7 @@
 #include <QQueue>
 #include <QMutex>
 #include <QTimer>
+#include <QSet>
 #include <QUrl>
 
 class QTreeWidgetItem;
@@ -106,12 +110,19 @@ private:
     bool add(const QStringList &urls, QTreeWidgetItem *parent, const Functions::DemuxersInfo &demuxersInfo, QStringList *existingEntries = nullptr, bool loadList = false);
     QTreeWidgetItem *insertPlaylistEntries(const Playlist::Entries &entries, QTreeWidgetItem *parent, const Functions::DemuxersInfo &demuxersInfo, int insertChildAt, QStringList *existingEntries);
 
+    bool canUseMediaInfoCache(const QString &url) const;
+    QHash<QString, MediaInfoCache::Info> probeLocalFiles(const QStringList &urls, const QSet<int> &indexesToSkip);
+    static MediaInfoCache::Info probeFile(const QString &url, IOController<Demuxer> &demuxer, bool onlyTracks);
+
     PlaylistWidget &pLW;
     QStringList urls, existingEntries;
     QTreeWidgetItem *par;
     bool loadList;
     SYNC sync;
     IOController<> ioCtrl;
+    QMutex probeCtrlsMutex;
+    QList<IOController<Demuxer> *> probeCtrls; // Parallel probes, aborted in "stop()"
+    MediaInfoCache mediaInfoCache;
     QTreeWidgetItem *firstItem, *lastItem;
     bool inProgress;
 public:
@@ -133,6 +144,8 @@ public:
 
     PlaylistWidget();
 
+    static Functions::DemuxersInfo getDemuxersInfo();
+
     QString getUrl(QTreeWidgetItem *tWI = nullptr) const;
 
     void setItemsResizeToContents(bool);
@@ -141,8 +154,10 @@ public:
 
     bool add(const QStringList &, QTreeWidgetItem *par, const QStringList &existingEntries = {}, bool loadList = false, bool forceEnqueue = false);
     bool add(const QStringList &, bool atEndOfList = false);
+    bool setEntries(const Playlist::Entries &entries); // Replaces the whole list at once
     void sync(const QString &pth, QTreeWidgetItem *par, bool notDir);
     void quickSync(const QString &pth, QTreeWidgetItem *par, bool recursive, QTreeWidgetItem *&itemToNull);
+    void quickSyncApply(const QString &pth, QTreeWidgetItem *par, const PlaylistDirWatcher::Delta &delta, QTreeWidgetItem *&itemToNull);
 
     void setCurrentPlaying(QTreeWidgetItem *tWI);
 
@@ -158,12 +173,22 @@ public:
 
     QList<QTreeWidgetItem *> getChildren(CHILDREN children = ALL_CHILDREN, const QTreeWidgetItem *parent = nullptr) const;
 
+    // All non-group items in tree order, cached until the tree is modified
+    const QList<QTreeWidgetItem *> &nonGroupItems();
+    int indexOfNonGroupItem(QTreeWidgetItem *tWI);
+    inline bool containsNonGroupItem(QTreeWidgetItem *tWI)
+    {
+        return indexOfNonGroupItem(tWI) > -1;
+    }
+
+    QSet<QTreeWidgetItem *> filterItems(const QString &text);
+
     bool canModify(bool all = true) const;
 
     void enqueue();
     void refresh(REFRESH Refresh = REFRESH_ALL);
 
-    void processItems(QList<QTreeWidgetItem *> *itemsToShow = nullptr, bool hideGroups = false);
+    void processItems(const QSet<QTreeWidgetItem *> *itemsToShow = nullptr, bool hideGroups = false);
 
     QString currentPlayingUrl;
     QTreeWidgetItem *currentPlaying;
@@ -189,7 +214,10 @@ public:
 
     static void setEntryFont(QTreeWidgetItem *tWI, const int flags);
 private:
-    QTreeWidgetItem *newGroup(const QString &name, const QString &url, QTreeWidgetItem *parent, int insertChildAt, QStringList *existingEntries);
+    static QTreeWidgetItem *createGroupItem(const QString &name, const QString &url);
+    static QTreeWidgetItem *createEntryItem(const Playlist::Entry &entry);
+
+    QTreeWidgetItem *newGroup(const QString &name, const QString &url, QTreeWidgetItem *parent, int insertChildAt, QStringList *existingEntries, bool isDir = false);
     QTreeWidgetItem *newEntry(const Playlist::Entry &entry, QTreeWidgetItem *parent, const Functions::DemuxersInfo &demuxersInfo, int insertChildAt, QStringList *existingEntries);
 
     void setEntryIcon(const QIcon &icon, QTreeWidgetItem *);
@@ -220,7 +248,13 @@ private:
     QTimer animationTimer, addTimer;
     bool repaintAll;
     int rotation;
+    QList<QTreeWidgetItem *> m_nonGroupItems;
+    QHash<QTreeWidgetItem *, int> m_nonGroupIndexes;
+    bool m_itemsIndexValid = false;
+    PlaylistFilterIndex m_filterIndex;
 private slots:
+    void invalidateItemsIndex();
+    void itemsDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
     void insertItem(QTreeWidgetItem *, QTreeWidgetItem *, int insertChildAt);
     void popupContextMenu(const QPoint &);
     void animationUpdate();
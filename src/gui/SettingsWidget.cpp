@@ -231,6 +231,8 @@ void SettingsWidget::InitSettings()
     QMPSettings.init("BackwardBuffer", 1);
     QMPSettings.init("AVBufferTimeNetworkLive", 5.0);
     QMPSettings.init("PlayIfBuffered", 1.75);
+    QMPSettings.init("Timeshift", false);
+    QMPSettings.init("TimeshiftSize", 1024);
     QMPSettings.init("MaxVol", 100);
     QMPSettings.init("VolumeL", 100);
     QMPSettings.init("VolumeR", 100);
@@ -249,6 +251,7 @@ void SettingsWidget::InitSettings()
     QMPSettings.init("LeftMouseTogglePlay", static_cast<int>(0));
     QMPSettings.init("MiddleMouseToggleFullscreen", false);
     QMPSettings.init("AccurateSeek", Qt::Checked);
+    QMPSettings.init("FrameHistoryMemory", 256); // MiB of decoded frames kept for stepping backwards, filled only when paused or frame stepping
     QMPSettings.init("UnpauseWhenSeeking", false);
     QMPSettings.init("RestoreAVSState", false);
     QMPSettings.init("DisableSubtitlesAtStartup", false);
@@ -265,6 +268,7 @@ void SettingsWidget::InitSettings()
     QMPSettings.init("Silence", true);
     QMPSettings.init("RestoreVideoEqualizer", false);
     QMPSettings.init("IgnorePlaybackError", false);
+    QMPSettings.init("GaplessPlayback", true);
     QMPSettings.init("ApplyToASS/ColorsAndBorders", true);
     QMPSettings.init("ApplyToASS/MarginsAndAlignment", false);
     QMPSettings.init("ApplyToASS/FontsAndSpacing", false);
@@ -590,6 +594,11 @@ SettingsWidget::SettingsWidget(int page, const QString &moduleName, QWidget *vid
         m_playIfBufferedB->setValue(QMPSettings.getDouble("PlayIfBuffered"));
         m_maxVolB->setValue(QMPSettings.getInt("MaxVol"));
 
+        m_timeshift->setChecked(QMPSettings.getBool("Timeshift"));
+        m_timeshiftSizeB->setValue(QMPSettings.getInt("TimeshiftSize"));
+        connect(m_timeshift, SIGNAL(toggled(bool)), m_timeshiftSizeB, SLOT(setEnabled(bool)));
+        m_timeshiftSizeB->setEnabled(m_timeshift->isChecked());
+
         m_forceSamplerate->setChecked(QMPSettings.getBool("ForceSamplerate"));
         m_samplerateB->setValue(QMPSettings.getInt("Samplerate"));
         connect(m_forceSamplerate, SIGNAL(toggled(bool)), m_samplerateB, SLOT(setEnabled(bool)));
@@ -650,6 +659,7 @@ SettingsWidget::SettingsWidget(int page, const QString &moduleName, QWidget *vid
         m_silence->setChecked(QMPSettings.getBool("Silence"));
         m_restoreVideoEq->setChecked(QMPSettings.getBool("RestoreVideoEqualizer"));
         m_ignorePlaybackError->setChecked(QMPSettings.getBool("IgnorePlaybackError"));
+        m_gaplessPlayback->setChecked(QMPSettings.getBool("GaplessPlayback"));
         m_leftMouseTogglePlay->setCheckState((Qt::CheckState)qBound(0, QMPSettings.getInt("LeftMouseTogglePlay"), 2));
         m_middleMouseToggleFullscreen->setChecked(QMPSettings.getBool("MiddleMouseToggleFullscreen"));
 
@@ -1256,6 +1266,15 @@ void SettingsWidget::setupPlaybackUi(QWidget *PlaybackSettings)
     m_resamplerFirst = new QCheckBox(playbackScrollAreaWidgetContents);
     playbackFormLayout->setWidget(11, QFormLayout::ItemRole::SpanningRole, m_resamplerFirst);
 
+    m_timeshift = new QCheckBox(playbackScrollAreaWidgetContents);
+    playbackFormLayout->setWidget(12, QFormLayout::ItemRole::LabelRole, m_timeshift);
+    m_timeshiftSizeB = new QSpinBox(playbackScrollAreaWidgetContents);
+    m_timeshiftSizeB->setSuffix(QString::fromUtf8(" MiB"));
+    m_timeshiftSizeB->setMinimum(64);
+    m_timeshiftSizeB->setMaximum(65536);
+    m_timeshiftSizeB->setSingleStep(256);
+    playbackFormLayout->setWidget(12, QFormLayout::ItemRole::FieldRole, m_timeshiftSizeB);
+
     m_replayGain = new QGroupBox(playbackScrollAreaWidgetContents);
     m_replayGain->setCheckable(true);
     QVBoxLayout *replayGainLayout = new QVBoxLayout(m_replayGain);
@@ -1305,6 +1324,7 @@ void SettingsWidget::setupPlaybackUi(QWidget *PlaybackSettings)
     m_silence = new QCheckBox(playbackScrollAreaWidgetContents);
     m_restoreVideoEq = new QCheckBox(playbackScrollAreaWidgetContents);
     m_ignorePlaybackError = new QCheckBox(playbackScrollAreaWidgetContents);
+    m_gaplessPlayback = new QCheckBox(playbackScrollAreaWidgetContents);
     m_leftMouseTogglePlay = new QCheckBox(playbackScrollAreaWidgetContents);
     m_leftMouseTogglePlay->setTristate(true);
     m_middleMouseToggleFullscreen = new QCheckBox(playbackScrollAreaWidgetContents);
@@ -1334,6 +1354,7 @@ void SettingsWidget::setupPlaybackUi(QWidget *PlaybackSettings)
     playbackGridLayout->addWidget(m_syncVtoA, 13, 0, 1, 2);
     playbackGridLayout->addWidget(m_silence, 14, 0, 1, 2);
     playbackGridLayout->addWidget(m_restoreVideoEq, 15, 0, 1, 2);
+    playbackGridLayout->addWidget(m_gaplessPlayback, 16, 0, 1, 2);
     playbackGridLayout->addWidget(m_ignorePlaybackError, 17, 0, 1, 2);
     playbackGridLayout->addWidget(m_leftMouseTogglePlay, 18, 0, 1, 1);
     playbackGridLayout->addWidget(m_middleMouseToggleFullscreen, 19, 0, 1, 1);
@@ -1389,9 +1410,12 @@ void SettingsWidget::setupPlaybackUi(QWidget *PlaybackSettings)
     m_forceSamplerate->setText(tr("Force samplerate: "));
     m_forceChannels->setText(tr("Force channels conversion: "));
     m_resamplerFirst->setText(tr("Use audio resampler and channel conversion before filters and visualizations"));
+    m_timeshift->setText(tr("Timeshift for live streams (disk space): "));
+    m_timeshift->setToolTip(tr("Keeps already played part of live stream in a file, so it can be paused and rewound for a long time"));
     m_keepARatio->setText(tr("Keep aspect ratio"));
     m_accurateSeekB->setText(tr("Accurate seeking"));
     m_ignorePlaybackError->setText(tr("Play next entry after playback error"));
+    m_gaplessPlayback->setText(tr("Open next local file before the end of playback (gapless playback)"));
     m_savePos->setText(tr("Continue last playback when program starts"));
     m_wheelActionB->setTitle(tr("Mouse wheel action on video dock"));
     m_wheelSeekB->setText(tr("Mouse wheel scrolls music/movie"));
@@ -1960,6 +1984,8 @@ void SettingsWidget::apply()
             QMPSettings.set("BackwardBuffer", m_backwardBufferNetworkB->currentIndex());
             QMPSettings.set("AVBufferTimeNetworkLive", m_bufferLiveB->value());
             QMPSettings.set("PlayIfBuffered", m_playIfBufferedB->value());
+            QMPSettings.set("Timeshift", m_timeshift->isChecked());
+            QMPSettings.set("TimeshiftSize", m_timeshiftSizeB->value());
             QMPSettings.set("DesiredVideoHeight", getDesiredVideoHeight());
             QMPSettings.set("ForceSamplerate", m_forceSamplerate->isChecked());
             QMPSettings.set("Samplerate", m_samplerateB->value());
@@ -1987,6 +2013,7 @@ void SettingsWidget::apply()
             QMPSettings.set("Silence", m_silence->isChecked());
             QMPSettings.set("RestoreVideoEqualizer", m_restoreVideoEq->isChecked());
             QMPSettings.set("IgnorePlaybackError", m_ignorePlaybackError->isChecked());
+            QMPSettings.set("GaplessPlayback", m_gaplessPlayback->isChecked());
             QMPSettings.set("LeftMouseTogglePlay", m_leftMouseTogglePlay->checkState());
             QMPSettings.set("MiddleMouseToggleFullscreen", m_middleMouseToggleFullscreen->isChecked());
             QMPSettings.set("AccurateSeek", m_accurateSeekB->checkState());
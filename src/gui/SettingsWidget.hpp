@@ -167,9 +167,12 @@ private:
     QCheckBox *m_forceChannels;
     QSpinBox *m_channelsB;
     QCheckBox *m_resamplerFirst;
+    QCheckBox *m_timeshift;
+    QSpinBox *m_timeshiftSizeB;
     QCheckBox *m_keepARatio;
     QCheckBox *m_accurateSeekB;
     QCheckBox *m_ignorePlaybackError;
+    QCheckBox *m_gaplessPlayback;
     QCheckBox *m_savePos;
     QGroupBox *m_wheelActionB;
     QRadioButton *m_wheelSeekB;
@@ -0,0 +1,202 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <SubtitlesRenderer.hpp>
+
+#include <QMPlay2Core.hpp>
+#include <QMPlay2OSD.hpp>
+#include <PlayClass.hpp>
+#include <LibASS.hpp>
+
+#include <QThread>
+
+#include <algorithm>
+
+constexpr size_t g_maxEntries = 16;
+
+static inline bool ptsEquals(double a, double b)
+{
+    return qAbs(a - b) < 1e-6;
+}
+
+SubtitlesRenderer::SubtitlesRenderer(PlayClass &playC)
+    : playC(playC)
+    , m_ass(std::make_unique<LibASS>(QMPlay2Core.getSettings()))
+    , m_thr(QThread::create([this] {
+        run();
+    }))
+{
+    m_thr->setObjectName("SubtitlesRenderer");
+}
+SubtitlesRenderer::~SubtitlesRenderer()
+{
+    stop();
+}
+
+void SubtitlesRenderer::start()
+{
+    if (m_thr->isRunning())
+        return;
+    m_br = false;
+    m_thr->start();
+}
+void SubtitlesRenderer::stop()
+{
+    m_mutex.lock();
+    m_br = true;
+    m_cond.wakeAll();
+    m_mutex.unlock();
+    m_thr->wait();
+    clear();
+}
+
+void SubtitlesRenderer::setEnabled(bool enabled)
+{
+    if (m_enabled.exchange(enabled) && !enabled)
+        clear();
+}
+
+void SubtitlesRenderer::request(double pts)
+{
+    if (!m_enabled)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_entries.empty())
+    {
+        if (ptsEquals(m_entries.back().pts, pts))
+            return;
+        if (m_entries.back().pts > pts) // Timestamps went back without flushing
+            m_entries.clear();
+    }
+    if (m_entries.size() >= g_maxEntries)
+        m_entries.pop_front();
+    m_entries.push_back({pts});
+    m_cond.wakeOne();
+}
+
+bool SubtitlesRenderer::take(double pts, quint32 generation, std::shared_ptr<QMPlay2OSD> &osd)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_entries.empty() && m_entries.front().pts < pts && !ptsEquals(m_entries.front().pts, pts))
+        m_entries.pop_front();
+    if (m_entries.empty() || !ptsEquals(m_entries.front().pts, pts))
+        return false;
+
+    Entry entry = std::move(m_entries.front());
+    m_entries.pop_front();
+    if (!entry.rendered || entry.generation != generation)
+        return false;
+
+    osd = std::move(entry.osd);
+    return true;
+}
+
+bool SubtitlesRenderer::isShared(const std::shared_ptr<QMPlay2OSD> &osd) const
+{
+    if (!osd)
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_lastOsd == osd)
+        return true;
+    return std::any_of(m_entries.cbegin(), m_entries.cend(), [&](const Entry &entry) {
+        return entry.osd == osd;
+    });
+}
+
+void SubtitlesRenderer::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto &&entry : m_entries)
+    {
+        entry.rendered = false;
+        entry.osd.reset();
+    }
+    m_cond.wakeOne();
+}
+void SubtitlesRenderer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_lastOsd.reset();
+}
+
+void SubtitlesRenderer::run()
+{
+    for (;;)
+    {
+        double pts = 0.0;
+        std::shared_ptr<QMPlay2OSD> osd;
+
+        m_mutex.lock();
+        for (;;)
+        {
+            if (m_br)
+                break;
+            auto it = std::find_if(m_entries.cbegin(), m_entries.cend(), [](const Entry &entry) {
+                return !entry.rendered;
+            });
+            if (it != m_entries.cend())
+            {
+                pts = it->pts;
+                break;
+            }
+            m_cond.wait(&m_mutex);
+        }
+        if (m_br)
+        {
+            m_mutex.unlock();
+            break;
+        }
+        osd = m_lastOsd; // Reused if subtitles didn't change
+        m_mutex.unlock();
+
+        quint32 generation = 0;
+        bool ok = false;
+
+        playC.subsMutex.lock();
+        if (playC.ass)
+        {
+            generation = playC.ass->generation();
+            ok = playC.ass->copyASS(*m_ass, pts);
+        }
+        playC.subsMutex.unlock();
+
+        if (ok)
+            ok = m_ass->renderASS(osd, pts);
+
+        QMutexLocker locker(&m_mutex);
+        if (ok)
+            m_lastOsd = osd;
+        for (auto &&entry : m_entries)
+        {
+            if (!ptsEquals(entry.pts, pts))
+                continue;
+            if (!entry.rendered)
+            {
+                entry.rendered = true;
+                entry.generation = generation;
+                if (ok)
+                    entry.osd = std::move(osd);
+            }
+            break;
+        }
+    }
+}
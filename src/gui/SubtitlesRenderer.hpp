@@ -0,0 +1,93 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QWaitCondition>
+#include <QMutex>
+
+#include <atomic>
+#include <memory>
+#include <deque>
+
+class QMPlay2OSD;
+class PlayClass;
+class LibASS;
+class QThread;
+
+/*
+ * Renders ASS subtitles ahead of the video presentation, for timestamps of
+ * already decoded frames. Rendered subtitles are valid only for the same
+ * "LibASS::generation()", otherwise the video thread renders them itself.
+ * Visible events are copied to a private "LibASS" instance, so "subsMutex"
+ * isn't locked while rendering.
+ */
+class SubtitlesRenderer
+{
+    Q_DISABLE_COPY(SubtitlesRenderer)
+
+public:
+    SubtitlesRenderer(PlayClass &playC);
+    ~SubtitlesRenderer();
+
+    void start();
+    void stop();
+
+    inline bool isEnabled() const
+    {
+        return m_enabled;
+    }
+    void setEnabled(bool enabled);
+
+    // Called by the decoding thread for every queued frame
+    void request(double pts);
+
+    // Must be called with locked "playC.subsMutex", "osd" can be empty if there are no subtitles at "pts"
+    bool take(double pts, quint32 generation, std::shared_ptr<QMPlay2OSD> &osd);
+
+    // Rendered subtitles must not be modified in place
+    bool isShared(const std::shared_ptr<QMPlay2OSD> &osd) const;
+
+    // Renders again all requested timestamps, e.g. when new events were added
+    void invalidate();
+    void clear();
+
+private:
+    void run();
+
+private:
+    struct Entry
+    {
+        double pts = 0.0;
+        quint32 generation = 0;
+        bool rendered = false;
+        std::shared_ptr<QMPlay2OSD> osd;
+    };
+
+    PlayClass &playC;
+    std::unique_ptr<LibASS> m_ass;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    std::deque<Entry> m_entries;
+    std::shared_ptr<QMPlay2OSD> m_lastOsd;
+    std::atomic_bool m_enabled = false;
+    bool m_br = false;
+
+    std::unique_ptr<QThread> m_thr;
+};
@@ -0,0 +1,102 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <VideoFrameHistory.hpp>
+
+#include <algorithm>
+
+// Timestamps closer than this are treated as the same frame
+constexpr double g_tsEpsilon = 0.0001;
+
+void VideoFrameHistory::setMemoryLimit(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_memoryLimit = qMax<qint64>(0, bytes);
+    while (!m_entries.empty() && m_bytes > m_memoryLimit)
+    {
+        m_bytes -= frameBytes(m_entries.front().frame);
+        m_entries.pop_front();
+    }
+}
+
+void VideoFrameHistory::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+void VideoFrameHistory::add(const Frame &frame, double ts)
+{
+    if (frame.isEmpty() || !frame.hasCPUAccess() || qIsNaN(ts))
+        return;
+
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 bytes = frameBytes(frame);
+    if (bytes > m_memoryLimit)
+        return;
+
+    if (!m_entries.empty() && ts <= m_entries.back().ts + g_tsEpsilon)
+    {
+        // Discontinuity, e.g. a timestamp reset or a loop
+        m_entries.clear();
+        m_bytes = 0;
+    }
+
+    while (!m_entries.empty() && m_bytes + bytes > m_memoryLimit)
+    {
+        m_bytes -= frameBytes(m_entries.front().frame);
+        m_entries.pop_front();
+    }
+
+    m_entries.push_back({frame, ts});
+    m_bytes += bytes;
+}
+
+bool VideoFrameHistory::findBefore(double ts, Entry &entry) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), ts - g_tsEpsilon, [](const Entry &e, double value) {
+        return e.ts < value;
+    });
+    if (it == m_entries.cbegin())
+        return false;
+    entry = *(--it);
+    return true;
+}
+bool VideoFrameHistory::findAfter(double ts, double maxTs, Entry &entry) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), ts + g_tsEpsilon, [](double value, const Entry &e) {
+        return value < e.ts;
+    });
+    if (it == m_entries.cend() || it->ts > maxTs + g_tsEpsilon)
+        return false;
+    entry = *it;
+    return true;
+}
+
+qint64 VideoFrameHistory::frameBytes(const Frame &frame)
+{
+    qint64 bytes = 0;
+    const int numPlanes = frame.numPlanes();
+    for (int p = 0; p < numPlanes; ++p)
+        bytes += static_cast<qint64>(frame.linesize(p)) * frame.height(p);
+    return bytes;
+}
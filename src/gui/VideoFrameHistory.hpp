@@ -0,0 +1,65 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <Frame.hpp>
+
+#include <QMutex>
+
+#include <deque>
+
+/*
+ * Recently decoded and filtered video frames ordered by timestamp. The amount of frames
+ * is limited by memory usage. It's used for stepping backwards without decoding again.
+ */
+class VideoFrameHistory
+{
+    Q_DISABLE_COPY(VideoFrameHistory)
+
+public:
+    struct Entry
+    {
+        Frame frame;
+        double ts = qQNaN();
+    };
+
+public:
+    VideoFrameHistory() = default;
+
+    // Zero disables the history
+    void setMemoryLimit(qint64 bytes);
+
+    void clear();
+
+    // Frames must be added in presentation order, otherwise the history is restarted
+    void add(const Frame &frame, double ts);
+
+    // Finds the nearest frame before "ts" or after "ts" (but not after "maxTs")
+    bool findBefore(double ts, Entry &entry) const;
+    bool findAfter(double ts, double maxTs, Entry &entry) const;
+
+private:
+    static qint64 frameBytes(const Frame &frame);
+
+private:
+    mutable QMutex m_mutex;
+    std::deque<Entry> m_entries;
+    qint64 m_bytes = 0;
+    qint64 m_memoryLimit = 0;
+};
@@ -0,0 +1,101 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <VideoFrameQueue.hpp>
+
+void VideoFrameQueue::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax(1, capacity);
+    while (static_cast<int>(m_entries.size()) > m_capacity)
+        m_entries.pop_front();
+    m_notFullCond.wakeAll();
+}
+int VideoFrameQueue::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+int VideoFrameQueue::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+bool VideoFrameQueue::isEmpty() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.empty();
+}
+bool VideoFrameQueue::isFull() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_entries.size()) >= m_capacity;
+}
+
+quint32 VideoFrameQueue::generation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generation;
+}
+
+void VideoFrameQueue::push(Entry &&entry)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.push_back(std::move(entry));
+    m_notEmptyCond.wakeAll();
+}
+bool VideoFrameQueue::pop(Entry &entry)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.empty())
+        return false;
+    entry = std::move(m_entries.front());
+    m_entries.pop_front();
+    m_notFullCond.wakeAll();
+    return true;
+}
+
+void VideoFrameQueue::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    ++m_generation;
+    m_notFullCond.wakeAll();
+}
+
+bool VideoFrameQueue::waitForEntries(unsigned long timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_entries.empty())
+        return true;
+    return m_notEmptyCond.wait(&m_mutex, timeout);
+}
+void VideoFrameQueue::waitForFreeSpace(const std::function<bool()> &stopWaiting)
+{
+    QMutexLocker locker(&m_mutex);
+    while (static_cast<int>(m_entries.size()) >= m_capacity && !stopWaiting())
+        m_notFullCond.wait(&m_mutex);
+}
+
+void VideoFrameQueue::wakeAll()
+{
+    QMutexLocker locker(&m_mutex);
+    m_notEmptyCond.wakeAll();
+    m_notFullCond.wakeAll();
+}
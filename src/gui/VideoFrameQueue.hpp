@@ -0,0 +1,78 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <Frame.hpp>
+
+#include <QWaitCondition>
+#include <QMutex>
+
+#include <functional>
+#include <deque>
+
+/*
+ * Bounded queue of decoded and filtered video frames. It is filled by the
+ * video decoding thread and drained by the video presentation thread.
+ */
+class VideoFrameQueue
+{
+    Q_DISABLE_COPY(VideoFrameQueue)
+
+public:
+    struct Entry
+    {
+        Frame frame; // Can be empty if frame was skipped, but timestamp is still valid
+        double ts = qQNaN();
+        bool ptsIsValid = false;
+        bool interlaced = false;
+        bool seekFinished = false;
+    };
+
+public:
+    VideoFrameQueue() = default;
+
+    void setCapacity(int capacity);
+    int capacity() const;
+
+    int count() const;
+    bool isEmpty() const;
+    bool isFull() const;
+
+    quint32 generation() const;
+
+    void push(Entry &&entry);
+    bool pop(Entry &entry);
+
+    void clear();
+
+    // Returns "false" on timeout
+    bool waitForEntries(unsigned long timeout);
+    // Waits until there is free space or "stopWaiting" returns "true", it's checked under the queue
+    // mutex, so it's enough to call "wakeAll()" after the state changes
+    void waitForFreeSpace(const std::function<bool()> &stopWaiting);
+
+    void wakeAll();
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmptyCond, m_notFullCond;
+    std::deque<Entry> m_entries;
+    int m_capacity = 1;
+    quint32 m_generation = 0;
+};
@@ -50,6 +50,7 @@ extern "C" {
 using Functions::gettime;
 using namespace std;
 
+#include <QElapsedTimer>
 #include <QDebug>
 #include <QImage>
 #include <QDir>
@@ -60,14 +61,26 @@ using namespace std;
 
 #include <cmath>
 
+// Maximum number of decoded frames waiting for presentation. Hardware decoders have
+// limited surface pools, so don't hold too many of their frames.
+static constexpr int g_swFrameQueueSize = 5;
+static constexpr int g_hwFrameQueueSize = 2;
+
 VideoThr::VideoThr(PlayClass &playC, const QStringList &pluginsName) :
     AVThread(playC),
     syncVtoA(QMPlay2Core.getSettings().getBool("SyncVtoA")),
     doScreenshot(false),
     deleteOSD(false), deleteFrame(false), gotFrameOrError(false), decoderError(false),
     W(0), H(0), seq(0),
-    sDec(nullptr)
+    sDec(nullptr),
+    m_decodeThr(QThread::create([this] {
+        decode();
+    }))
+    , m_subsRenderer(playC)
 {
+    m_decodeThr->setObjectName("VideoDecodeThr");
+    m_presentMutex.lock();
+
     if (QMPlay2Core.renderer() != QMPlay2CoreClass::Renderer::Legacy)
     {
         writer = QMPlay2Core.gpuInstance()->createOrGetVideoOutput();
@@ -89,6 +102,9 @@ VideoThr::~VideoThr()
 #endif
     playC.osd.reset();
     delete sDec;
+    if (!stopDecodeThr())
+        m_decodeThr->wait(); // Must not be destroyed while running
+    m_subsRenderer.stop();
 }
 
 void VideoThr::setDec(Decoder *dec)
@@ -96,6 +112,12 @@ void VideoThr::setDec(Decoder *dec)
     AVThread::setDec(dec);
     if (!dec->hasHWDecContext() && videoWriter()->hwDecContext())
         videoWriter()->setHWDecContext(nullptr);
+    m_frameQueue.setCapacity(dec->hasHWDecContext() ? g_hwFrameQueueSize : g_swFrameQueueSize);
+    m_frameQueue.clear();
+    m_subsRenderer.clear();
+    // Hardware frames hold decoder surfaces, so keep the history for software frames only
+    m_frameHistory.setMemoryLimit(dec->hasHWDecContext() ? 0 : QMPlay2Core.getSettings().getInt("FrameHistoryMemory") * 1048576LL);
+    m_frameHistory.clear();
     decoderError = false;
 }
 
@@ -117,7 +139,20 @@ bool VideoThr::lock()
     {
         m_subsDisplayLocker = {};
     }
-    return AVThread::lock();
+    if (!AVThread::lock())
+        return false;
+    if (!m_presentMutex.tryLock(MUTEXWAIT_TIMEOUT))
+    {
+        AVThread::unlock();
+        return false;
+    }
+    return true;
+}
+void VideoThr::unlock()
+{
+    m_presentMutex.unlock();
+    AVThread::unlock();
+    m_frameQueue.wakeAll();
 }
 
 void VideoThr::stop(bool terminate)
@@ -125,7 +160,14 @@ void VideoThr::stop(bool terminate)
     if (QMPlay2Core.renderer() != QMPlay2CoreClass::Renderer::Legacy)
         QMPlay2Core.gpuInstance()->clearVideoOutput();
     playC.videoSeekPos = -1;
+    if (!terminate)
+    {
+        br = true;
+        m_presentMutex.unlock();
+        m_frameQueue.wakeAll();
+    }
     AVThread::stop(terminate);
+    stopDecodeThr();
 }
 
 bool VideoThr::hasError() const
@@ -363,15 +405,70 @@ void VideoThr::updateSubs()
 {
     if (playC.ass)
     {
+        const auto update = [this](std::shared_ptr<QMPlay2OSD> &subtitles) {
+            if (!subtitles)
+                return;
+            if (m_subsRenderer.isShared(subtitles))
+            {
+                // Don't modify subtitles which are still referenced by the renderer
+                const double pts = subtitles->pts();
+                subtitles.reset();
+                playC.ass->getASS(subtitles, pts);
+            }
+            else
+            {
+                playC.ass->getASS(subtitles);
+            }
+        };
         playC.subsMutex.lock();
-        if (m_subtitlesBusy)
-            playC.ass->getASS(m_subtitlesBusy);
-        if (m_subtitles)
-            playC.ass->getASS(m_subtitles);
+        update(m_subtitlesBusy);
+        update(m_subtitles);
         playC.subsMutex.unlock();
+        m_subsRenderer.invalidate();
     }
 }
 
+bool VideoThr::showFrameFromHistory(bool backward)
+{
+    if (!playC.paused)
+        return false;
+
+    // Stepping backwards without history seeks and decodes again, the history is filled then
+    m_frameStepping = true;
+
+    // Don't use "write()", it belongs to frames from the presentation thread and swaps subtitles buffers
+    QMutexLocker locker(&m_presentMutex);
+
+    if (!writer->readyWrite())
+        return false;
+
+    const double currentTs = playC.frame_last_pts;
+    const double lastQueueTs = m_lastQueueTs;
+
+    VideoFrameHistory::Entry entry;
+    if (backward)
+    {
+        if (!m_frameHistory.findBefore(currentTs, entry))
+            return false;
+    }
+    else
+    {
+        if (!m_showingHistory || !m_frameHistory.findAfter(currentTs, lastQueueTs, entry))
+            return false;
+    }
+
+    m_showingHistory = (entry.ts < lastQueueTs);
+    playC.frame_last_pts = entry.ts;
+    playC.chPos(entry.ts);
+    videoWriter()->writeVideo(entry.frame, {});
+    return true;
+}
+void VideoThr::stopFrameStepping()
+{
+    m_frameStepping = false;
+    m_frameHistory.clear();
+}
+
 inline VideoWriter *VideoThr::videoWriter() const
 {
     return static_cast<VideoWriter *>(writer);
@@ -379,18 +476,23 @@ inline VideoWriter *VideoThr::videoWriter() const
 
 void VideoThr::run()
 {
-    bool skip = false, paused = false, oneFrame = false, useLastDelay = false, maybeFlush = false, lastAVDesync = false, interlaced = false, err = false, skipNonKey = false;
+    bool skip = false, paused = false, oneFrame = false, useLastDelay = false, lastAVDesync = false, interlaced = false;
     double tmp_time = 0.0, sync_last_pts = 0.0, frame_timer = -1.0, sync_timer = 0.0, framesDisplayedTime = 0.0;
-    QMutex emptyBufferMutex;
     Frame videoFrame;
     unsigned fast = 0;
-    int tmp_br = 0, frames = 0, framesDisplayed = 0;
+    int frames = 0, framesDisplayed = 0;
     canWrite = true;
 
+    m_decodeThr->start();
+    m_subsRenderer.start();
+
     const auto resetVariables = [&] {
-        tmp_br = tmp_time = frames = 0;
+        tmp_time = frames = 0;
+        m_decodedBytes = 0;
         skip = false;
         fast = 0;
+        m_skipFrames = false;
+        m_hurryUp = 0;
 
         if (frame_timer != -1.0)
             frame_timer = gettime();
@@ -407,14 +509,10 @@ void VideoThr::run()
         return false;
     };
 
-    const auto finishAccurateSeek = [&] {
-        resetVariables();
-        playC.videoSeekPos = -1.0;
-        playC.emptyBufferCond.wakeAll();
-    };
-
     while (!br)
     {
+        const quint64 emptyBufferSeq = playC.emptyBufferWakeSeq();
+
         if (deleteFrame)
         {
             videoFrame.clear();
@@ -430,13 +528,15 @@ void VideoThr::run()
             doScreenshot = false;
         }
 
-        const bool mustFetchNewPacket = !filters.readyRead();
-        playC.vPackets.lock();
-        const bool hasVPackets = playC.vPackets.canFetch();
-        if (maybeFlush || (!gotFrameOrError && !err && mustFetchNewPacket))
-            maybeFlush = playC.endOfStream && !hasVPackets;
-        err = false;
-        if ((playC.paused && !oneFrame) || (!(maybeFlush || hasVPackets) && mustFetchNewPacket) || playC.waitForData || (playC.videoSeekPos <= 0.0 && playC.audioSeekPos > 0.0) || decoderError)
+        if (m_resetPresenter.exchange(false))
+            resetVariables();
+        if (m_flushPresenter.exchange(false))
+        {
+            frame_timer = -1.0;
+            useLastDelay = true; //if seeking
+        }
+
+        if ((playC.paused && !oneFrame) || playC.waitForData || playC.flushVideo || (playC.videoSeekPos <= 0.0 && playC.audioSeekPos > 0.0 && !playC.nextFrameB) || decoderError)
         {
             if (playC.paused && !paused)
             {
@@ -447,137 +547,81 @@ void VideoThr::run()
                 frame_timer = -1.0;
                 emit playC.updateBitrateAndFPS(-1, -1, -1.0, 0.0, interlaced); //Set real FPS to 0 on pause
             }
-            playC.vPackets.unlock();
 
             if (!playC.paused)
-                waiting = playC.fillBufferB = true;
+            {
+                waiting = m_decoderWaiting && m_frameQueue.isEmpty();
+                playC.requestFillBuffer();
+            }
 
-            emptyBufferMutex.lock();
-            playC.emptyBufferCond.wait(&emptyBufferMutex, MUTEXWAIT_TIMEOUT);
-            emptyBufferMutex.unlock();
+            playC.waitForEmptyBufferWake(emptyBufferSeq);
 
             resetVariables();
 
             continue;
         }
-        paused = waiting = false;
-
-        Packet packet;
-        double ts = qQNaN();
-        if (hasVPackets && mustFetchNewPacket)
-        {
-            packet = playC.vPackets.fetch();
-            if (packet.isTsValid())
-                ts = packet.ts();
-        }
-        playC.vPackets.unlock();
-        processOneFrame();
-        playC.fillBufferB = true;
+        paused = false;
 
-        /* Subtitles packet */
-        QVector<Packet> sPackets;
-        playC.sPackets.lock();
-        while (playC.sPackets.canFetch())
+        if (m_frameQueue.isEmpty())
         {
-            auto packet = playC.sPackets.fetch();
-            if (!packet.isEmpty())
-                sPackets.push_back(std::move(packet));
+            // The decoding thread forwards wake-ups from "emptyBufferCond" to the queue
+            waiting = m_decoderWaiting;
+            m_frameQueue.waitForEntries(MUTEXWAIT_TIMEOUT);
+            continue;
         }
-        playC.sPackets.unlock();
+        waiting = false;
 
-        mutex.lock();
+        m_presentMutex.lock();
         if (br)
         {
-            mutex.unlock();
+            m_presentMutex.unlock();
             break;
         }
 
-        const bool flushVideo = playC.flushVideo;
-
-        filtersMutex.lock();
-        if (flushVideo || skipNonKey)
+        VideoFrameQueue::Entry entry;
+        if (playC.flushVideo || !m_frameQueue.pop(entry))
         {
-            filters.clearBuffers();
-            if (flushVideo)
-                frame_timer = -1.0;
+            m_presentMutex.unlock();
+            continue;
         }
 
-        if ((!packet.isEmpty() || maybeFlush) && (!skipNonKey || packet.hasKeyFrame()))
-        {
-            Frame decoded;
-            AVPixelFormat newPixelFormat = AV_PIX_FMT_NONE;
-            const int bytes_consumed = dec->decodeVideo(packet, decoded, newPixelFormat, flushVideo || skipNonKey, (skip && !skipNonKey) ? ~0 : (fast >> 1));
-            ts = decoded.isTsValid() ? decoded.ts() : qQNaN();
-            if (newPixelFormat != AV_PIX_FMT_NONE)
-                emit playC.pixelFormatUpdate(newPixelFormat);
-            if (flushVideo)
-            {
-                useLastDelay = true; //if seeking
-                playC.flushVideo = false;
-            }
-            if (playC.videoSeekPos > 0.0 && bytes_consumed <= 0 && !decoded.isTsValid() && decoded.isEmpty())
-                finishAccurateSeek();
-            if (!decoded.isEmpty())
-            {
-                if (decoded.width() != W || decoded.height() != H)
-                {
-                    //Frame size has been changed
-                    filtersMutex.unlock();
-                    updateMutex.lock();
-                    mutex.unlock();
-                    emit playC.frameSizeUpdate(decoded.width(), decoded.height());
-                    updateMutex.lock(); //Wait for "frameSizeUpdate()" to be finished
-                    mutex.lock();
-                    updateMutex.unlock();
-                    filtersMutex.lock();
-                }
-                interlaced = decoded.isInterlaced();
-                filters.addFrame(decoded);
-                gotFrameOrError = true;
-            }
-            else if (skip)
-            {
-                filters.removeLastFromInputBuffer();
-            }
-            if (bytes_consumed < 0)
-            {
-                gotFrameOrError = true;
-                err = true;
-                m_error = true;
-            }
-            else
-            {
-                tmp_br += bytes_consumed;
-                m_error = false;
-            }
-            skipNonKey = false;
-        }
+        processOneFrame();
+        playC.requestFillBuffer();
 
-        // This thread will wait for "DemuxerThr" which'll detect this error and restart with new decoder.
-        if (dec->hasCriticalError())
+        if (entry.seekFinished)
         {
-            decoderError = true;
-        }
-        else if (auto hwDecContext = getHWDecContext())
-        {
-            decoderError = hwDecContext->hasError();
+            resetVariables();
+            if (processOneFrame())
+                playC.requestFillBuffer();
         }
 
-        const bool ptsIsValid = filters.getFrame(videoFrame);
-        if (ptsIsValid)
-            ts = videoFrame.ts();
-        filtersMutex.unlock();
+        const double ts = entry.ts;
+        const bool ptsIsValid = entry.ptsIsValid;
+        interlaced = entry.interlaced;
+        m_lastQueueTs = ts;
+        m_showingHistory = false;
+        if (!entry.frame.isEmpty())
+            videoFrame = std::move(entry.frame);
 
-        const bool tsIsNotNan = !qIsNaN(ts);
+        bool skipNonKey = false;
+
+        /* Subtitles packet */
+        QVector<Packet> sPackets;
+        playC.sPackets.lock();
+        while (playC.sPackets.canFetch())
+        {
+            auto packet = playC.sPackets.fetch();
+            if (!packet.isEmpty())
+                sPackets.push_back(std::move(packet));
+        }
+        playC.sPackets.unlock();
 
         /* Subtitles */
         QMPlay2OSDList osdList;
         m_subsDisplayMutex.lock(); // Must be locked before "playC.subsMutex"!
         playC.subsMutex.lock();
-        const double subsPts = tsIsNotNan
-            ? ts - playC.subtitlesSync
-            : qQNaN()
-        ;
+        const double subsPts = ts - playC.subtitlesSync;
+        const bool flushSubtitles = m_flushSubtitles.exchange(false);
         const bool canDeleteSubs = (deleteSubs && m_subtitles);
         auto resetSubs = [this] {
             m_subtitles.reset();
@@ -585,13 +629,15 @@ void VideoThr::run()
         };
         if (sDec && !m_decodeToAss) //Image subs (pgssub, dvdsub, ...)
         {
-            if (!sDec->decodeSubtitle(sPackets, subsPts, m_subtitles, QSize(W, H), flushVideo))
+            m_subsRenderer.setEnabled(false);
+            if (!sDec->decodeSubtitle(sPackets, subsPts, m_subtitles, QSize(W, H), flushSubtitles))
             {
                 resetSubs();
             }
         }
         else if (playC.ass)
         {
+            const bool eventsAdded = !sPackets.isEmpty();
             for (auto &&sPacket : std::as_const(sPackets))
             {
                 if (sDec && m_decodeToAss)
@@ -608,12 +654,35 @@ void VideoThr::run()
                         playC.ass->addASSEvent(Functions::convertToASS(sPacketData), sPacket.ts(), sPacket.duration());
                 }
             }
-            if (tsIsNotNan && !playC.ass->getASS(m_subtitles, subsPts))
+
+            m_subsRenderer.setEnabled(playC.ass->hasASSTrack());
+            if (eventsAdded)
+                m_subsRenderer.invalidate();
+
+            std::shared_ptr<QMPlay2OSD> subtitles;
+            if (!eventsAdded && m_subsRenderer.take(subsPts, playC.ass->generation(), subtitles))
             {
-                resetSubs();
+                // Already rendered ahead
+                if (subtitles)
+                {
+                    auto locker = subtitles->lock();
+                    subtitles->setPTS(subsPts);
+                    m_subtitles = std::move(subtitles);
+                }
+                else
+                {
+                    resetSubs();
+                }
+            }
+            else
+            {
+                if (m_subsRenderer.isShared(m_subtitles))
+                    m_subtitles.reset();
+                if (!playC.ass->getASS(m_subtitles, subsPts))
+                    resetSubs();
             }
         }
-        if (m_subtitles && tsIsNotNan)
+        if (m_subtitles)
         {
             const bool hasDuration = m_subtitles->duration() >= 0.0;
             if (canDeleteSubs || (m_subtitles->isStarted() && subsPts < m_subtitles->pts()) || (hasDuration && subsPts > m_subtitles->pts() + m_subtitles->duration()))
@@ -646,187 +715,173 @@ void VideoThr::run()
         deleteSubs = deleteOSD = false;
         /**/
 
-        if ((maybeFlush = tsIsNotNan))
+        const AVRational currSAR = videoFrame.sampleAspectRatio();
+        if (currSAR.num != 0 && currSAR.den != 0 && lastSAR.num != 0 && lastSAR.den != 0 && av_cmp_q(lastSAR, currSAR) != 0) //Aspect ratio has been changed
         {
-            const AVRational currSAR = videoFrame.sampleAspectRatio();
-            if (currSAR.num != 0 && currSAR.den != 0 && lastSAR.num != 0 && lastSAR.den != 0 && av_cmp_q(lastSAR, currSAR) != 0) //Aspect ratio has been changed
-            {
-                lastSAR = {0, 0}; //Needs to be updated later
-                emit playC.aRatioUpdate(currSAR); //Sets "lastSAR", because it calls "setARatio()";
-            }
+            lastSAR = {0, 0}; //Needs to be updated later
+            emit playC.aRatioUpdate(currSAR); //Sets "lastSAR", because it calls "setARatio()";
+        }
 
-            if (playC.videoSeekPos > 0.0)
-            {
-                bool cont = true;
-                if (ts >= playC.videoSeekPos)
-                {
-                    finishAccurateSeek();
-                    if (processOneFrame())
-                        playC.fillBufferB = true;
-                    if (playC.audioSeekPos <= 0.0 || oneFrame)
-                        cont = false; // Play only if audio is ready or if still frame should be displayed
-                }
-                if (cont)
-                {
-                    mutex.unlock();
-                    continue;
-                }
-            }
+        const bool audioControlsPos = playC.aThr && dec->isDummyDecoder();
+        if (!audioControlsPos && (ptsIsValid || ts > playC.pos))
+            playC.chPos(ts);
 
-            const bool audioControlsPos = playC.aThr && dec->isDummyDecoder();
-            if (!audioControlsPos && (ptsIsValid || ts > playC.pos))
-                playC.chPos(ts);
+        double delay = ts - playC.frame_last_pts;
+        if (useLastDelay || delay <= 0.0 || (playC.frame_last_pts <= 0.0 && delay > playC.frame_last_delay) || (m_tsDisontPossible && delay > 1.0 && delay / playC.frame_last_delay > 10.0))
+        {
+            delay = playC.frame_last_delay;
+            useLastDelay = false;
+        }
 
-            double delay = ts - playC.frame_last_pts;
-            if (useLastDelay || delay <= 0.0 || (playC.frame_last_pts <= 0.0 && delay > playC.frame_last_delay) || (m_tsDisontPossible && delay > 1.0 && delay / playC.frame_last_delay > 10.0))
-            {
-                delay = playC.frame_last_delay;
-                useLastDelay = false;
-            }
+        tmp_time += delay;
+        ++frames;
 
-            tmp_time += delay;
-            ++frames;
+        playC.frame_last_delay = delay;
+        playC.frame_last_pts = ts;
 
-            playC.frame_last_delay = delay;
-            playC.frame_last_pts = ts;
+        delay /= playC.speed;
 
-            delay /= playC.speed;
+        if (playC.skipAudioFrame < 0.0)
+            playC.skipAudioFrame = 0.0;
 
-            if (playC.skipAudioFrame < 0.0)
-                playC.skipAudioFrame = 0.0;
+        const double true_delay = delay;
 
-            const double true_delay = delay;
+        const double audioCurrentPts = playC.audio_current_pts;
+        const bool canSkipFrames = syncVtoA && audioCurrentPts > 0.0;
 
-            const double audioCurrentPts = playC.audio_current_pts;
-            const bool canSkipFrames = syncVtoA && audioCurrentPts > 0.0;
+        if (tmp_time >= 1.0)
+        {
+            emit playC.updateBitrateAndFPS(-1, dec->isDummyDecoder() ? -1 : round((m_decodedBytes.exchange(0) << 3) / (tmp_time * 1000.0)), frames / tmp_time, canSkipFrames ? framesDisplayed / framesDisplayedTime : qQNaN(), interlaced);
+            emit playC.updateDecodedFramesQueue(m_frameQueue.count(), m_frameQueue.capacity());
+            frames = framesDisplayed = 0;
+            tmp_time = framesDisplayedTime = 0.0;
+        }
 
-            if (tmp_time >= 1.0)
+        if (canSkipFrames && !oneFrame)
+        {
+            double sync_pts = audioCurrentPts;
+            if (sync_last_pts == sync_pts)
+                sync_pts += gettime() - sync_timer;
+            else
             {
-                emit playC.updateBitrateAndFPS(-1, dec->isDummyDecoder() ? -1 : round((tmp_br << 3) / (tmp_time * 1000.0)), frames / tmp_time, canSkipFrames ? framesDisplayed / framesDisplayedTime : qQNaN(), interlaced);
-                frames = tmp_br = framesDisplayed = 0;
-                tmp_time = framesDisplayedTime = 0.0;
+                sync_last_pts = sync_pts;
+                sync_timer = gettime();
             }
 
-            if (canSkipFrames && !oneFrame)
+            const double diff = ts - (delay + sync_pts - playC.videoSync);
+            const double sync_threshold = qMax(delay, playC.audio_last_delay);
+            const double max_threshold = qMax(sync_threshold * 2.0, 0.15);
+            const double fDiff = qAbs(diff);
+
+            if (fast && !skip && diff > -sync_threshold / 2.0)
+                fast = 0;
+            skip = false;
+
+//            qDebug() << "diff:" << diff << "sync_threshold:" << sync_threshold << "max_threshold:" << max_threshold;
+            if (fDiff > sync_threshold && fDiff < max_threshold)
             {
-                double sync_pts = audioCurrentPts;
-                if (sync_last_pts == sync_pts)
-                    sync_pts += gettime() - sync_timer;
-                else
+                if (fDiff > sync_threshold * 1.75)
                 {
-                    sync_last_pts = sync_pts;
-                    sync_timer = gettime();
+                    delay += diff / 4.0;
+                    lastAVDesync = true;
+//                    qDebug() << "Syncing 2" << diff << delay << sync_threshold;
                 }
-
-                const double diff = ts - (delay + sync_pts - playC.videoSync);
-                const double sync_threshold = qMax(delay, playC.audio_last_delay);
-                const double max_threshold = qMax(sync_threshold * 2.0, 0.15);
-                const double fDiff = qAbs(diff);
-
-                if (fast && !skip && diff > -sync_threshold / 2.0)
-                    fast = 0;
-                skip = false;
-
-//                qDebug() << "diff:" << diff << "sync_threshold:" << sync_threshold << "max_threshold:" << max_threshold;
-                if (fDiff > sync_threshold && fDiff < max_threshold)
+                else
                 {
-                    if (fDiff > sync_threshold * 1.75)
-                    {
-                        delay += diff / 4.0;
-                        lastAVDesync = true;
-//                        qDebug() << "Syncing 2" << diff << delay << sync_threshold;
-                    }
-                    else
+                    if (lastAVDesync)
                     {
-                        if (lastAVDesync)
-                        {
-                            delay += diff / 8.0;
-//                            qDebug() << "Syncing 1" << diff << delay << sync_threshold;
-                        }
+                        delay += diff / 8.0;
+//                        qDebug() << "Syncing 1" << diff << delay << sync_threshold;
                     }
                 }
-                else if (fDiff >= max_threshold)
+            }
+            else if (fDiff >= max_threshold)
+            {
+                if (diff < 0.0) //obraz się spóźnia
                 {
-                    if (diff < 0.0) //obraz się spóźnia
-                    {
-                        delay = 0.0;
-                        if (fast >= 7)
-                            skip = true;
-                        if (fast >= 56 || (fast >= 28 && fDiff >= max_threshold * 4.0))
-                            skipNonKey = true;
-                    }
-                    else if (diff > 0.0) //obraz idzie za szybko
-                    {
-                        if (diff <= 0.5)
-                            delay *= 2.0;
-                        else if (!playC.skipAudioFrame)
-                            playC.skipAudioFrame = diff;
-                    }
-                    lastAVDesync = true;
-//                    qDebug() << "Skipping" << diff << skip << fast << delay;
+                    delay = 0.0;
+                    if (fast >= 7)
+                        skip = true;
+                    if (fast >= 56 || (fast >= 28 && fDiff >= max_threshold * 4.0))
+                        skipNonKey = true;
                 }
-                else
+                else if (diff > 0.0) //obraz idzie za szybko
                 {
-                    lastAVDesync = false;
+                    if (diff <= 0.5)
+                        delay *= 2.0;
+                    else if (!playC.skipAudioFrame)
+                        playC.skipAudioFrame = diff;
                 }
+                lastAVDesync = true;
+//                qDebug() << "Skipping" << diff << skip << fast << delay;
             }
-            else if (audioCurrentPts <= 0.0 || oneFrame)
+            else
             {
-                skip = false;
-                fast = 0;
+                lastAVDesync = false;
             }
+        }
+        else if (audioCurrentPts <= 0.0 || oneFrame)
+        {
+            skip = false;
+            fast = 0;
+        }
 
-            const bool hasFrame = !videoFrame.isEmpty();
-            const bool hasFrameTimer = (frame_timer != -1.0);
-            const bool updateFrameTimer = (hasFrame != hasFrameTimer);
-            if (hasFrame)
+        const bool hasFrame = !videoFrame.isEmpty();
+        const bool hasFrameTimer = (frame_timer != -1.0);
+        const bool updateFrameTimer = (hasFrame != hasFrameTimer);
+        if (hasFrame)
+        {
+            if (hasFrameTimer)
             {
-                if (hasFrameTimer)
+                const double frame_timer_2 = gettime();
+                const double delay_diff = frame_timer_2 - frame_timer;
+                const double desired_delay = delay;
+                if (delay > 0.0)
+                    delay -= delay_diff;
+                if (canSkipFrames && true_delay > 0.0 && delay_diff > true_delay)
+                    ++fast;
+                else if (fast && delay > 0.0)
                 {
-                    const double frame_timer_2 = gettime();
-                    const double delay_diff = frame_timer_2 - frame_timer;
-                    const double desired_delay = delay;
-                    if (delay > 0.0)
-                        delay -= delay_diff;
-                    if (canSkipFrames && true_delay > 0.0 && delay_diff > true_delay)
-                        ++fast;
-                    else if (fast && delay > 0.0)
-                    {
-                        if (delay > true_delay / 2.0)
-                            delay /= 2.0;
-                        if (fast & 1)
-                            --fast;
-                    }
-                    const double toSleep = delay;
-                    while (delay > 0.0 && !playC.paused && !br && !br2)
-                    {
-                        const double sleepTime = qMin(delay, 0.1);
-                        Functions::s_wait(sleepTime);
-                        delay -= sleepTime;
-                    }
-                    frame_timer = gettime();
-                    frame_timer -= frame_timer - frame_timer_2 - qMax(toSleep, -desired_delay);
+                    if (delay > true_delay / 2.0)
+                        delay /= 2.0;
+                    if (fast & 1)
+                        --fast;
                 }
-                if (!skip && canWrite)
+                const double toSleep = delay;
+                while (delay > 0.0 && !playC.paused && !br && !br2)
                 {
-                    oneFrame = canWrite = false;
-                    if (!osdList.isEmpty())
-                        m_subsDisplayLocker = unique_lock<std::mutex>(m_subsDisplayMutex);
-                    QTimer::singleShot(0, this, [=, osdList = std::move(osdList)]() mutable {
-                        write(videoFrame, std::move(osdList), seq);
-                        m_subsDisplayLocker = {};
-                    });
-                    if (canSkipFrames && !skipNonKey)
-                        ++framesDisplayed;
+                    const double sleepTime = qMin(delay, 0.1);
+                    Functions::s_wait(sleepTime);
+                    delay -= sleepTime;
                 }
-                if (canSkipFrames)
-                    framesDisplayedTime += true_delay;
-            }
-            if (updateFrameTimer)
                 frame_timer = gettime();
+                frame_timer -= frame_timer - frame_timer_2 - qMax(toSleep, -desired_delay);
+            }
+            if (!skip && canWrite)
+            {
+                oneFrame = canWrite = false;
+                if (!osdList.isEmpty())
+                    m_subsDisplayLocker = unique_lock<std::mutex>(m_subsDisplayMutex);
+                QTimer::singleShot(0, this, [=, osdList = std::move(osdList)]() mutable {
+                    write(videoFrame, std::move(osdList), seq);
+                    m_subsDisplayLocker = {};
+                });
+                if (canSkipFrames && !skipNonKey)
+                    ++framesDisplayed;
+            }
+            if (canSkipFrames)
+                framesDisplayedTime += true_delay;
         }
+        if (updateFrameTimer)
+            frame_timer = gettime();
 
-        mutex.unlock();
+        // Let the decoding thread adapt to the presentation
+        m_hurryUp = fast >> 1;
+        m_skipFrames = skip;
+        if (skipNonKey)
+            m_skipNonKey = true;
+
+        m_presentMutex.unlock();
 
         if (br2)
         {
@@ -835,8 +890,228 @@ void VideoThr::run()
         }
     }
 
+    stopDecodeThr();
+    m_subsRenderer.stop();
+
     m_error = false;
 }
+bool VideoThr::stopDecodeThr()
+{
+    // The decoding thread must not be terminated, it can hold locks or be inside the decoder
+    br = true;
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_decodeThr->wait(MUTEXWAIT_TIMEOUT / 10))
+    {
+        if (timer.elapsed() >= TERMINATE_TIMEOUT)
+        {
+            qWarning() << "Video decoding thread doesn't finish";
+            return false;
+        }
+        // Wake it again in case it missed the previous notification
+        m_frameQueue.wakeAll();
+        playC.wakeEmptyBuffer();
+    }
+    return true;
+}
+
+void VideoThr::decode()
+{
+    bool maybeFlush = false, interlaced = false, err = false, skipNonKey = false, keyFramesOnly = false;
+
+    const auto finishAccurateSeek = [&] {
+        m_resetPresenter = true;
+        playC.videoSeekPos = -1.0;
+        playC.wakeEmptyBuffer();
+    };
+
+    while (!br)
+    {
+        const quint64 emptyBufferSeq = playC.emptyBufferWakeSeq();
+
+        if (m_frameQueue.isFull() && !playC.flushVideo)
+        {
+            // "stop()" and "unlock()" wake the queue after changing the state
+            m_frameQueue.waitForFreeSpace([this] {
+                return br || playC.flushVideo;
+            });
+            continue;
+        }
+
+        const bool mustFetchNewPacket = !filters.readyRead();
+        playC.vPackets.lock();
+        const bool hasVPackets = playC.vPackets.canFetch();
+        if (maybeFlush || (!gotFrameOrError && !err && mustFetchNewPacket))
+            maybeFlush = playC.endOfStream && !hasVPackets;
+        err = false;
+        if ((!(maybeFlush || hasVPackets) && mustFetchNewPacket) || playC.waitForData || (playC.videoSeekPos <= 0.0 && playC.audioSeekPos > 0.0) || decoderError)
+        {
+            playC.vPackets.unlock();
+
+            m_decoderWaiting = true;
+            if (!playC.paused)
+                playC.requestFillBuffer();
+
+            playC.waitForEmptyBufferWake(emptyBufferSeq);
+
+            m_frameQueue.wakeAll();
+
+            continue;
+        }
+        m_decoderWaiting = false;
+
+        Packet packet;
+        double ts = qQNaN();
+        if (hasVPackets && mustFetchNewPacket)
+        {
+            packet = playC.vPackets.fetch();
+            if (packet.isTsValid())
+                ts = packet.ts();
+        }
+        playC.vPackets.unlock();
+        playC.requestFillBuffer();
+
+        if (m_skipNonKey.exchange(false))
+            skipNonKey = true;
+
+        mutex.lock();
+        if (br)
+        {
+            mutex.unlock();
+            break;
+        }
+
+        const bool flushVideo = playC.flushVideo;
+
+        if (keyFramesOnly != playC.scrubbing)
+        {
+            keyFramesOnly = playC.scrubbing;
+            dec->setKeyFramesOnly(keyFramesOnly);
+        }
+
+        filtersMutex.lock();
+        if (flushVideo || skipNonKey)
+        {
+            filters.clearBuffers();
+            if (flushVideo)
+            {
+                m_frameQueue.clear();
+                m_subsRenderer.clear();
+                m_frameHistory.clear();
+                m_skipFrames = false;
+                m_hurryUp = 0;
+            }
+        }
+
+        if ((!packet.isEmpty() || maybeFlush) && (!(skipNonKey || keyFramesOnly) || packet.hasKeyFrame()))
+        {
+            // Don't degrade the quality if there are frames waiting for presentation
+            const bool decoderIsAhead = (m_frameQueue.count() > 1);
+            const bool skip = (m_skipFrames && !decoderIsAhead);
+            const unsigned hurryUp = decoderIsAhead ? 0 : m_hurryUp.load();
+
+            Frame decoded;
+            AVPixelFormat newPixelFormat = AV_PIX_FMT_NONE;
+            const int bytes_consumed = dec->decodeVideo(packet, decoded, newPixelFormat, flushVideo || skipNonKey, (skip && !skipNonKey) ? ~0u : hurryUp);
+            ts = decoded.isTsValid() ? decoded.ts() : qQNaN();
+            if (newPixelFormat != AV_PIX_FMT_NONE)
+                emit playC.pixelFormatUpdate(newPixelFormat);
+            if (flushVideo)
+            {
+                m_flushPresenter = m_flushSubtitles = true;
+                playC.flushVideo = false;
+            }
+            if (playC.videoSeekPos > 0.0 && bytes_consumed <= 0 && !decoded.isTsValid() && decoded.isEmpty())
+                finishAccurateSeek();
+            if (!decoded.isEmpty())
+            {
+                if (decoded.width() != W || decoded.height() != H)
+                {
+                    //Frame size has been changed
+                    m_frameQueue.clear(); // Don't present frames with old size
+                    m_subsRenderer.clear();
+                    m_frameHistory.clear();
+                    filtersMutex.unlock();
+                    updateMutex.lock();
+                    mutex.unlock();
+                    emit playC.frameSizeUpdate(decoded.width(), decoded.height());
+                    updateMutex.lock(); //Wait for "frameSizeUpdate()" to be finished
+                    mutex.lock();
+                    updateMutex.unlock();
+                    filtersMutex.lock();
+                }
+                interlaced = decoded.isInterlaced();
+                filters.addFrame(decoded);
+                gotFrameOrError = true;
+            }
+            else if (skip)
+            {
+                filters.removeLastFromInputBuffer();
+            }
+            if (bytes_consumed < 0)
+            {
+                gotFrameOrError = true;
+                err = true;
+                m_error = true;
+            }
+            else
+            {
+                m_decodedBytes += bytes_consumed;
+                m_error = false;
+            }
+            skipNonKey = false;
+        }
+
+        // This thread will wait for "DemuxerThr" which'll detect this error and restart with new decoder.
+        if (dec->hasCriticalError())
+        {
+            decoderError = true;
+        }
+        else if (auto hwDecContext = getHWDecContext())
+        {
+            decoderError = hwDecContext->hasError();
+        }
+
+        Frame videoFrame;
+        const bool ptsIsValid = filters.getFrame(videoFrame);
+        if (ptsIsValid)
+            ts = videoFrame.ts();
+        filtersMutex.unlock();
+
+        if ((maybeFlush = !qIsNaN(ts)))
+        {
+            // Frames before the accurate seek position are not presented, but they are kept in the
+            // history. This way stepping backwards fills the history with the whole GOP at once.
+            if (ptsIsValid && (playC.paused || m_frameStepping))
+                m_frameHistory.add(videoFrame, ts);
+
+            if (playC.videoSeekPos <= 0.0 || ts >= playC.videoSeekPos)
+            {
+                VideoFrameQueue::Entry entry;
+                entry.frame = std::move(videoFrame);
+                entry.ts = ts;
+                entry.ptsIsValid = ptsIsValid;
+                entry.interlaced = interlaced;
+                if (playC.videoSeekPos > 0.0)
+                {
+                    finishAccurateSeek();
+                    entry.seekFinished = true;
+                }
+                if (m_subsRenderer.isEnabled())
+                    m_subsRenderer.request(ts - playC.subtitlesSync);
+                m_frameQueue.push(std::move(entry));
+            }
+        }
+
+        mutex.unlock();
+
+        if (br2)
+        {
+            // Take time for another thread to lock the mutex
+            Functions::s_wait(0.001);
+        }
+    }
+}
 
 #ifdef Q_OS_WIN
 template<bool h>
@@ -19,6 +19,9 @@
 #pragma once
 
 #include <AVThread.hpp>
+#include <VideoFrameHistory.hpp>
+#include <VideoFrameQueue.hpp>
+#include <SubtitlesRenderer.hpp>
 #include <VideoFilters.hpp>
 #include <QMPlay2OSD.hpp>
 
@@ -44,6 +47,7 @@ public:
     bool videoWriterSet();
 
     bool lock() override;
+    void unlock() override;
 
     void stop(bool terminate = false) override;
 
@@ -83,10 +87,21 @@ public:
 
     void updateSubs();
 
+    // Shows a previous or a next frame from the decoded frames history, works only when paused
+    bool showFrameFromHistory(bool backward);
+    inline bool isShowingFrameFromHistory() const
+    {
+        return m_showingHistory;
+    }
+    // The history is filled only when paused or after a frame step, it's released when playback continues
+    void stopFrameStepping();
+
 private:
     inline VideoWriter *videoWriter() const;
 
     void run() override;
+    void decode();
+    bool stopDecodeThr();
 
 #ifdef Q_OS_WIN
     template<bool h>
@@ -98,7 +113,8 @@ private:
     void pause();
 
 private:
-    bool deleteSubs, syncVtoA, doScreenshot, canWrite, deleteOSD, deleteFrame, gotFrameOrError, decoderError, m_error = false;
+    bool deleteSubs, syncVtoA, doScreenshot, canWrite, deleteOSD, deleteFrame;
+    std::atomic_bool gotFrameOrError, decoderError, m_error = false; // Shared with the decoding thread
     bool m_tsDisontPossible = false;
     AVRational lastSAR;
     int W, H;
@@ -111,6 +127,18 @@ private:
     std::unique_lock<std::mutex> m_subsDisplayLocker;
     VideoFilters filters;
     QMutex filtersMutex;
+
+    std::unique_ptr<QThread> m_decodeThr;
+    VideoFrameQueue m_frameQueue;
+    SubtitlesRenderer m_subsRenderer;
+    VideoFrameHistory m_frameHistory;
+    std::atomic<double> m_lastQueueTs = 0.0; // The newest frame presented from the queue
+    std::atomic_bool m_showingHistory = false, m_frameStepping = false;
+    QMutex m_presentMutex;
+    std::atomic_bool m_decoderWaiting = false, m_resetPresenter = false, m_flushPresenter = false, m_flushSubtitles = false;
+    std::atomic_bool m_skipFrames = false, m_skipNonKey = false;
+    std::atomic<unsigned> m_hurryUp = 0;
+    std::atomic<qint64> m_decodedBytes = 0;
     double m_subtitlesScale = 1.0;
 
 #ifdef Q_OS_WIN
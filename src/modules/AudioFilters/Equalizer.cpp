@@ -18,8 +18,30 @@
 
 #include <Equalizer.hpp>
 
+#include <QThreadPool>
+#include <QSemaphore>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <cmath>
 
+// Channels are processed in parallel only if there is enough work for each of them
+constexpr int g_minParallelChannels = 3;
+constexpr int g_minParallelSamples = 16384;
+
+static QThreadPool &channelsThreadPool()
+{
+    static QThreadPool threadPool;
+    static const bool initialized = [] {
+        threadPool.setObjectName("EqualizerChannels");
+        threadPool.setMaxThreadCount(std::min(QThread::idealThreadCount(), 8));
+        return true;
+    }();
+    Q_UNUSED(initialized)
+    return threadPool;
+}
+
 static inline float cosI(const float y1, const float y2, float p)
 {
     p = (1.0f - cos(p * static_cast<float>(M_PI))) / 2.0f;
@@ -64,6 +86,11 @@ float Equalizer::getAmpl(int val)
     return powf(50.0f / (100 - val), 3.33f);
 }
 
+Equalizer::Channel::~Channel()
+{
+    FFT::freeComplex(complex);
+}
+
 Equalizer::Equalizer(Module &module)
 {
     SetModule(module);
@@ -100,8 +127,7 @@ int Equalizer::bufferedSamples() const
     if (m_canFilter)
     {
         QMutexLocker locker(&m_mutex);
-        int bufferedSamples = m_input[0].size();
-        return bufferedSamples;
+        return m_inputSize;
     }
     return 0;
 }
@@ -110,10 +136,11 @@ void Equalizer::clearBuffers()
     QMutexLocker locker(&m_mutex);
     if (m_canFilter)
     {
-        m_input.clear();
-        m_input.resize(m_chn);
-        m_lastSamples.clear();
-        m_lastSamples.resize(m_chn);
+        if (static_cast<int>(m_channels.size()) != m_chn)
+            allocChannels();
+        m_inputPos = m_inputSize = 0;
+        for (auto &&channel : m_channels)
+            channel->hasLastSamples = false;
     }
 }
 double Equalizer::filter(QByteArray &data, bool flush)
@@ -125,114 +152,231 @@ double Equalizer::filter(QByteArray &data, bool flush)
 
     const int fftSize = m_fftSize;
     const int fftSizeDiv2 = fftSize / 2;
-    const float fftSizeFlt = fftSize;
     const int chn = m_chn;
 
     if (!flush)
     {
-        float *samples = (float *)data.data();
-        const int size = data.size() / sizeof(float);
-        for (int c = 0; c < chn; ++c) // Buffering data
-            for (int i = 0; i < size; i += chn)
-                m_input[c].push_back(samples[c + i]);
+        pushInput(reinterpret_cast<const float *>(data.constData()), data.size() / sizeof(float) / chn);
     }
-    else for (int c = 0; c < chn; ++c) // Adding silence
+    else if (m_inputSize < fftSize) // Adding silence
     {
-        m_input[c].resize(fftSize);
+        const int silence = fftSize - m_inputSize;
+        std::vector<float> zeros(silence * chn);
+        pushInput(zeros.data(), silence);
     }
 
     data.resize(0);
-    const int chunks = m_input[0].size() / fftSizeDiv2 - 1;
+    const int chunks = m_inputSize / fftSizeDiv2 - 1;
     if (chunks > 0) // If there's enough data
     {
-        data.resize(chn * sizeof(float) * fftSizeDiv2 * chunks);
-        auto samples = reinterpret_cast<float *>(data.data());
-        for (int c = 0; c < chn; ++c)
+        if (chn >= g_minParallelChannels && chunks * fftSize >= g_minParallelSamples)
         {
-            int pos = c;
-            while (static_cast<int>(m_input[c].size()) >= fftSize)
+            // Same approach as in "VideoFilter::processSlices()", the state must outlive this
+            // function, because the pool tasks can start after all channels are already done.
+            struct Jobs
             {
-                for (int i = 0; i < fftSize; ++i)
+                std::atomic_int next {0};
+                QSemaphore done;
+            };
+            auto jobs = std::make_shared<Jobs>();
+
+            const auto work = [this, jobs, chn, chunks] {
+                for (int c; (c = jobs->next.fetch_add(1)) < chn;)
                 {
-                    m_complex[i].re = m_input[c][i];
-                    m_complex[i].im = 0.0f;
+                    processChannel(c, chunks);
+                    jobs->done.release();
                 }
+            };
 
-                if (!flush)
-                    m_input[c].erase(m_input[c].begin(), m_input[c].begin() + fftSizeDiv2);
-                else
-                    m_input[c].clear();
+            auto &threadPool = channelsThreadPool();
+            const int threads = std::min(chn, threadPool.maxThreadCount());
+            for (int i = 1; i < threads; ++i)
+                threadPool.start(work);
+            work();
 
-                m_fftIn.calc(m_complex);
-                for (int i = 0; i < fftSizeDiv2; ++i)
-                {
-                    const float coeff = m_f[i] * m_preamp;
-                    m_complex[              i].re *= coeff;
-                    m_complex[              i].im *= coeff;
-                    m_complex[fftSize - 1 - i].re *= coeff;
-                    m_complex[fftSize - 1 - i].im *= coeff;
-                }
-                m_fftOut.calc(m_complex);
+            jobs->done.acquire(chn);
+        }
+        else for (int c = 0; c < chn; ++c)
+        {
+            processChannel(c, chunks);
+        }
 
-                if (m_lastSamples[c].empty())
-                {
-                    for (int i = 0; i < fftSizeDiv2; ++i, pos += chn)
-                        samples[pos] = m_complex[i].re / fftSizeFlt;
-                    m_lastSamples[c].resize(fftSizeDiv2);
-                }
-                else for (int i = 0; i < fftSizeDiv2; ++i, pos += chn)
-                {
-                    samples[pos] = (m_complex[i].re / fftSizeFlt) * m_windF[i] + m_lastSamples[c][i];
-                }
+        if (!flush)
+        {
+            const int consumed = chunks * fftSizeDiv2;
+            m_inputPos = (m_inputPos + consumed) & (m_inputCapacity - 1);
+            m_inputSize -= consumed;
+        }
+        else
+        {
+            m_inputPos = m_inputSize = 0;
+        }
 
-                for (int i = fftSizeDiv2; i < fftSize; ++i)
-                    m_lastSamples[c][i - fftSizeDiv2] = (m_complex[i].re / fftSizeFlt) * m_windF[i];
-            }
+        const int outSize = chunks * fftSizeDiv2;
+        data.resize(chn * sizeof(float) * outSize);
+        auto samples = reinterpret_cast<float *>(data.data());
+        for (int c = 0; c < chn; ++c)
+        {
+            const float *output = m_channels[c]->output.data();
+            for (int i = 0, pos = c; i < outSize; ++i, pos += chn)
+                samples[pos] = output[i];
         }
     }
 
-    return fftSizeFlt / m_srate;
+    return static_cast<double>(fftSize) / m_srate;
 }
 
 void Equalizer::alloc(bool b)
 {
     QMutexLocker locker(&m_mutex);
-    if (!b && (m_fftIn.isValid() || m_fftOut.isValid()))
+    if (!b && m_fftSize > 0)
     {
         m_canFilter = false;
         m_fftNBits = m_fftSize = 0;
-        m_fftIn.finish();
-        m_fftOut.finish();
-        av_free(m_complex);
-        m_complex = nullptr;
+        m_channels.clear();
+        m_channels.shrink_to_fit();
         m_input.clear();
         m_input.shrink_to_fit();
-        m_lastSamples.clear();
-        m_lastSamples.shrink_to_fit();
+        m_inputCapacity = m_inputPos = m_inputSize = 0;
         m_windF.clear();
         m_windF.shrink_to_fit();
-        m_f.clear();
-        m_f.shrink_to_fit();
+        m_gain.clear();
+        m_gain.shrink_to_fit();
     }
     else if (b)
     {
-        if (!m_fftIn.isValid() || !m_fftOut.isValid())
+        if (m_fftSize == 0)
         {
             m_fftNBits  = sets().getInt("Equalizer/nbits");
             m_fftSize   = 1 << m_fftNBits;
-            m_fftIn.init(m_fftNBits, false);
-            m_fftOut.init(m_fftNBits, true);
-            m_complex = FFT::allocComplex(m_fftSize);
-            m_input.resize(m_chn);
-            m_lastSamples.resize(m_chn);
             m_windF.resize(m_fftSize);
             for (int i = 0; i < m_fftSize; ++i)
                 m_windF[i] = 0.5f - 0.5f * cos(2.0f * M_PI * i / (m_fftSize - 1));
+            m_channels.clear();
         }
+        if (static_cast<int>(m_channels.size()) != m_chn)
+            allocChannels();
         interpolateFilterCurve();
         m_canFilter = true;
     }
 }
+void Equalizer::allocChannels()
+{
+    m_channels.clear();
+    m_channels.reserve(m_chn);
+    for (int c = 0; c < m_chn; ++c)
+    {
+        auto channel = std::make_unique<Channel>();
+        channel->fftIn.init(m_fftNBits, false);
+        channel->fftOut.init(m_fftNBits, true);
+        channel->complex = FFT::allocComplex(m_fftSize);
+        channel->lastSamples.resize(m_fftSize / 2);
+        m_channels.push_back(std::move(channel));
+    }
+
+    m_inputCapacity = 0;
+    m_input.clear();
+    m_inputPos = m_inputSize = 0;
+}
+
+void Equalizer::pushInput(const float *samples, int count)
+{
+    const int chn = m_chn;
+
+    if (m_inputSize + count > m_inputCapacity)
+    {
+        // Grow and linearize the ring buffer
+        int newCapacity = std::max(m_inputCapacity, m_fftSize * 2);
+        while (newCapacity < m_inputSize + count)
+            newCapacity *= 2;
+
+        std::vector<float> newInput(static_cast<size_t>(newCapacity) * chn);
+        for (int c = 0; c < chn; ++c)
+        {
+            const float *src = m_input.data() + static_cast<size_t>(c) * m_inputCapacity;
+            float *dst = newInput.data() + static_cast<size_t>(c) * newCapacity;
+            const int firstPart = std::min(m_inputSize, m_inputCapacity - m_inputPos);
+            if (firstPart > 0)
+                memcpy(dst, src + m_inputPos, firstPart * sizeof(float));
+            if (m_inputSize > firstPart)
+                memcpy(dst + firstPart, src, (m_inputSize - firstPart) * sizeof(float));
+        }
+        m_input.swap(newInput);
+        m_inputCapacity = newCapacity;
+        m_inputPos = 0;
+    }
+
+    const int mask = m_inputCapacity - 1;
+    const int writePos = (m_inputPos + m_inputSize) & mask;
+    const int firstPart = std::min(count, m_inputCapacity - writePos);
+    for (int c = 0; c < chn; ++c) // Deinterleaving
+    {
+        float *ring = m_input.data() + static_cast<size_t>(c) * m_inputCapacity;
+        const float *src = samples + c;
+        float *dst = ring + writePos;
+        for (int i = 0; i < firstPart; ++i, src += chn)
+            dst[i] = *src;
+        for (int i = firstPart; i < count; ++i, src += chn)
+            ring[i - firstPart] = *src;
+    }
+    m_inputSize += count;
+}
+void Equalizer::processChannel(int c, int chunks)
+{
+    Channel &channel = *m_channels[c];
+
+    const int fftSize = m_fftSize;
+    const int fftSizeDiv2 = fftSize / 2;
+    const int mask = m_inputCapacity - 1;
+    const float *ring = m_input.data() + static_cast<size_t>(c) * m_inputCapacity;
+    const float *windF = m_windF.data();
+    const float *gain = m_gain.data();
+    FFT::Complex *complex = channel.complex;
+    float *lastSamples = channel.lastSamples.data();
+
+    channel.output.resize(chunks * fftSizeDiv2);
+    float *output = channel.output.data();
+
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        const int readPos = (m_inputPos + chunk * fftSizeDiv2) & mask;
+        const int firstPart = std::min(fftSize, m_inputCapacity - readPos);
+        for (int i = 0; i < firstPart; ++i)
+        {
+            complex[i].re = ring[readPos + i];
+            complex[i].im = 0.0f;
+        }
+        for (int i = firstPart; i < fftSize; ++i)
+        {
+            complex[i].re = ring[i - firstPart];
+            complex[i].im = 0.0f;
+        }
+
+        channel.fftIn.calc(complex);
+        for (int i = 0; i < fftSize; ++i)
+        {
+            complex[i].re *= gain[i];
+            complex[i].im *= gain[i];
+        }
+        channel.fftOut.calc(complex);
+
+        if (!channel.hasLastSamples)
+        {
+            for (int i = 0; i < fftSizeDiv2; ++i)
+                output[i] = complex[i].re;
+            channel.hasLastSamples = true;
+        }
+        else for (int i = 0; i < fftSizeDiv2; ++i)
+        {
+            output[i] = complex[i].re * windF[i] + lastSamples[i];
+        }
+
+        for (int i = fftSizeDiv2; i < fftSize; ++i)
+            lastSamples[i - fftSizeDiv2] = complex[i].re * windF[i];
+
+        output += fftSizeDiv2;
+    }
+}
 void Equalizer::interpolateFilterCurve()
 {
     const int size = sets().getInt("Equalizer/count");
@@ -241,10 +385,11 @@ void Equalizer::interpolateFilterCurve()
     for (int i = 0; i < size; ++i)
         src[i] = getAmpl(sets().getInt(QString("Equalizer/%1").arg(i)));
 
+    float preamp;
     int preampVal = sets().getInt("Equalizer/-1");
     if (preampVal >= 0)
     {
-        m_preamp = getAmpl(preampVal);
+        preamp = getAmpl(preampVal);
     }
     else // Auto preamp
     {
@@ -254,12 +399,11 @@ void Equalizer::interpolateFilterCurve()
             const int val = sets().getInt(QString("Equalizer/%1").arg(i));
             preampVal = qMax(val < 0 ? 0 : val, preampVal);
         }
-        m_preamp = getAmpl(100 - preampVal);
+        preamp = getAmpl(100 - preampVal);
     }
 
     const int len = m_fftSize / 2;
-    if (static_cast<int>(m_f.size()) != len)
-        m_f.resize(len);
+    std::vector<float> f(len);
     if (m_srate && size >= 2)
     {
         QVector<float> freqs = Equalizer::freqs(sets());
@@ -279,9 +423,15 @@ void Equalizer::interpolateFilterCurve()
                 }
             }
             if (x+1 < size)
-                m_f[i] = cosI(src[x], src[x + 1], (i - start) / (len * freqs[x + 1] / maxHz - 1 - start)); /* start / end */
+                f[i] = cosI(src[x], src[x + 1], (i - start) / (len * freqs[x + 1] / maxHz - 1 - start)); /* start / end */
             else
-                m_f[i] = src[x];
+                f[i] = src[x];
         }
     }
+
+    // Mirrored bins share the gain, inverse FFT is not normalized
+    const float scale = preamp / m_fftSize;
+    m_gain.resize(m_fftSize);
+    for (int i = 0; i < len; ++i)
+        m_gain[i] = m_gain[m_fftSize - 1 - i] = f[i] * scale;
 }
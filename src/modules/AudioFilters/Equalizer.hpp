@@ -21,6 +21,7 @@
 #include <AudioFilter.hpp>
 #include <FFT.hpp>
 
+#include <memory>
 #include <vector>
 
 class Equalizer final : public AudioFilter
@@ -43,9 +44,24 @@ private:
     /**/
 
     void alloc(bool);
+    void allocChannels();
     void interpolateFilterCurve();
 
+    void pushInput(const float *samples, int count);
+    void processChannel(int c, int chunks);
+
 private:
+    struct Channel
+    {
+        ~Channel();
+
+        FFT fftIn;
+        FFT fftOut;
+        FFT::Complex *complex = nullptr;
+        std::vector<float> lastSamples, output;
+        bool hasLastSamples = false;
+    };
+
     int m_fftNBits = 0;
     int m_fftSize = 0;
 
@@ -57,12 +73,16 @@ private:
     bool m_enabled = false;
 
     mutable QRecursiveMutex m_mutex;
-    FFT m_fftIn;
-    FFT m_fftOut;
-    FFT::Complex *m_complex = nullptr;
-    std::vector<std::vector<float>> m_input, m_lastSamples;
-    std::vector<float> m_windF, m_f;
-    float m_preamp = 0.0f;
+    std::vector<std::unique_ptr<Channel>> m_channels;
+
+    // Planar ring buffer, each channel has "m_inputCapacity" (power of 2) samples
+    std::vector<float> m_input;
+    int m_inputCapacity = 0;
+    int m_inputPos = 0;
+    int m_inputSize = 0;
+
+    std::vector<float> m_windF;
+    std::vector<float> m_gain; // Per bin, includes preamp and inverse FFT normalization
 };
 
 #define EqualizerName "Audio Equalizer"
@@ -82,9 +82,13 @@ bool SIDPlay::seek(double s, bool backward)
 
     if (s > 0.0)
     {
+        // libsidplayfp can't snapshot the emulator state, so emulate from the current position or
+        // from the beginning. The filter doesn't affect the emulation state, so disable it meanwhile.
+        setFilter(false);
         const auto posMs = static_cast<uint_least32_t>(s * 1000.0);
         while (m_sidplay.timeMs() <= posMs && !m_aborted)
             m_sidplay.play(CYCLES);
+        setFilter(true);
     }
 
     return true;
@@ -255,6 +259,7 @@ bool SIDPlay::open(const QString &_url, bool tracksOnly)
 
         m_title = getTitle(info, track);
         m_chn = isStereo ? 2 : 1;
+        m_sidChips = qMax(1, info->sidChips());
 
         const QString title    = info->infoString(0);
         const QString author   = info->infoString(1);
@@ -278,6 +283,17 @@ bool SIDPlay::open(const QString &_url, bool tracksOnly)
     return false;
 }
 
+void SIDPlay::setFilter(bool enable)
+{
+#if LIBSIDPLAYFP_VERSION_MAJ > 2 || (LIBSIDPLAYFP_VERSION_MAJ == 2 && LIBSIDPLAYFP_VERSION_MIN >= 10)
+    // Per SID filter control is available since libsidplayfp 2.10
+    for (quint8 i = 0; i < m_sidChips; ++i)
+        m_sidplay.filter(i, enable);
+#else
+    m_rs.filter(enable);
+#endif
+}
+
 QString SIDPlay::getTitle(const SidTuneInfo *info, int track) const
 {
     const QString title  = info->infoString(0);
@@ -57,6 +57,8 @@ private:
 
     bool open(const QString &url, bool tracksOnly);
 
+    void setFilter(bool enable);
+
     QString getTitle(const SidTuneInfo *info, int track) const;
 
 
@@ -66,6 +68,7 @@ private:
     double m_time;
     int m_length;
     quint8 m_chn;
+    quint8 m_sidChips = 1;
 
     QList<QMPlay2Tag> m_tags;
     QString m_url, m_title;
@@ -261,7 +261,7 @@ void Drawable::draw(const Frame &videoFrame)
         {
             if (osdImg.size() != QSize(ddsd.dwWidth, ddsd.dwHeight))
             {
-                osdImg = QImage(ddsd.dwWidth, ddsd.dwHeight, QImage::Format_ARGB32);
+                osdImg = QImage(ddsd.dwWidth, ddsd.dwHeight, QImage::Format_ARGB32_Premultiplied);
                 osdImg.fill(0);
             }
             Functions::paintOSDtoYV12(dest, osdImg, W, H, ddsd.lPitch, ddsd.lPitch >> 1, osd_list, osd_ids);
@@ -289,7 +289,13 @@ int FFDecSW::decodeVideo(const Packet &encodedPacket, Frame &decoded, AVPixelFor
 
     if (codec_ctx->codec_type == AVMEDIA_TYPE_VIDEO)
     {
-        if (respectHurryUP && hurry_up)
+        if (m_keyFramesOnly)
+        {
+            codec_ctx->skip_frame = AVDISCARD_NONKEY;
+            codec_ctx->skip_loop_filter = codec_ctx->skip_idct = AVDISCARD_DEFAULT;
+            codec_ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+        }
+        else if (respectHurryUP && hurry_up)
         {
             if (skipFrames && !forceSkipFrames && hurry_up > 1)
                 codec_ctx->skip_frame = AVDISCARD_NONREF;
@@ -308,6 +314,15 @@ int FFDecSW::decodeVideo(const Packet &encodedPacket, Frame &decoded, AVPixelFor
 
         bytesConsumed = decodeStep(frameFinished);
 
+        if (m_keyFramesOnly && !frameFinished && bytesConsumed > 0)
+        {
+            // Frame threading delays the output, so drain the decoder to get the key frame now
+            packet->data = nullptr;
+            packet->size = 0;
+            decodeStep(frameFinished);
+            avcodec_flush_buffers(codec_ctx);
+        }
+
         if (forceSkipFrames) //Nie możemy pomijać na pierwszej klatce, ponieważ wtedy może nie być odczytany przeplot
             codec_ctx->skip_frame = AVDISCARD_NONREF;
 
@@ -388,6 +403,11 @@ int FFDecSW::decodeVideo(const Packet &encodedPacket, Frame &decoded, AVPixelFor
 
     return bytesConsumed < 0 ? -1 : bytesConsumed;
 }
+void FFDecSW::setKeyFramesOnly(bool keyFramesOnly)
+{
+    m_keyFramesOnly = keyFramesOnly;
+}
+
 bool FFDecSW::decodeSubtitle(const QVector<Packet> &encodedPackets, double pos, shared_ptr<QMPlay2OSD> &osd, const QSize &size, bool flush)
 {
     if (codec_ctx->codec_type != AVMEDIA_TYPE_SUBTITLE)
@@ -766,13 +786,22 @@ bool FFDecSW::getFromBitmapSubsBuffer(shared_ptr<QMPlay2OSD> &osd, double pos)
                     const int w = osdImg.size.width();
                     const int h = osdImg.size.height();
 
+                    // OSD images are premultiplied
+                    uint32_t premultipliedPalette[AVPALETTE_COUNT];
+                    for (int i = 0; i < AVPALETTE_COUNT; ++i)
+                    {
+                        const uint32_t color = palette[i];
+                        const uint32_t a = color >> 24;
+                        const auto premultiply = [a](uint32_t c) {
+                            return (c * a + 127) / 255;
+                        };
+                        premultipliedPalette[i] = a << 24 | premultiply(color & 0xFF) << 16 | premultiply((color >> 8) & 0xFF) << 8 | premultiply((color >> 16) & 0xFF);
+                    }
+
                     for (int y = 0; y < h; ++y)
                     {
                         for (int x = 0; x < w; ++x)
-                        {
-                            const uint32_t color = palette[source[y * linesize + x]];
-                            *(dest++) = (color & 0xFF00FF00) | ((color << 16) & 0x00FF0000) | ((color >> 16) & 0x000000FF);
-                        }
+                            *(dest++) = premultipliedPalette[source[y * linesize + x]];
                     }
                 }
 
@@ -67,6 +67,7 @@ private:
 
     int  decodeAudio(const Packet &encodedPacket, QByteArray &decoded, double &ts, quint8 &channels, quint32 &sampleRate, bool flush) override;
     int  decodeVideo(const Packet &encodedPacket, Frame &decoded, AVPixelFormat &newPixFmt, bool flush, unsigned hurry_up) override;
+    void setKeyFramesOnly(bool keyFramesOnly) override;
     bool decodeSubtitle(const QVector<Packet> &encodedPackets, double pos, std::shared_ptr<QMPlay2OSD> &osd, const QSize &size, bool flush) override;
     QList<QByteArray> decodeSubtitle(const Packet &encodedPacket) override;
 
@@ -95,6 +96,7 @@ private:
     const AVPixFmtDescriptor *m_origPixDesc = nullptr;
     AVPixelFormat m_desiredPixFmt = AV_PIX_FMT_NONE;
     bool m_dontConvert = false;
+    bool m_keyFramesOnly = false;
 
     std::deque<Subtitle> m_subtitles;
 
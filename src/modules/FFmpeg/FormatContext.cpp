@@ -18,6 +18,7 @@
 
 #include <FFCommon.hpp>
 #include <FormatContext.hpp>
+#include <KeyframeIndex.hpp>
 
 #include <QMPlay2Core.hpp>
 #include <Functions.hpp>
@@ -256,6 +257,7 @@ FormatContext::FormatContext(bool reconnectNetwork, bool allowExperimental) :
 {}
 FormatContext::~FormatContext()
 {
+    m_keyframeIndex.reset(); // Stores the index, uses "formatCtx"
     if (formatCtx)
     {
         avformat_close_input(&formatCtx);
@@ -523,7 +525,10 @@ bool FormatContext::seek(double pos, bool backward)
         const double posToSeek = pos + startTime;
         const qint64 timestamp = ((streamsInfo.count() == 1) ? posToSeek : (backward ? floor(posToSeek) : ceil(posToSeek))) * AV_TIME_BASE;
 
-        isOk = av_seek_frame(formatCtx, -1, timestamp, backward ? AVSEEK_FLAG_BACKWARD : 0) >= 0;
+        if (m_keyframeIndex && m_keyframeIndex->seek(posToSeek, backward))
+            isOk = true;
+        else
+            isOk = av_seek_frame(formatCtx, -1, timestamp, backward ? AVSEEK_FLAG_BACKWARD : 0) >= 0;
         if (!isOk)
         {
             const int ret = av_read_frame(formatCtx, packet);
@@ -631,6 +636,9 @@ bool FormatContext::read(Packet &encoded, int &idx)
     if (fixMkvAss && stream->codecpar->codec_id == AV_CODEC_ID_ASS)
         matroska_fix_ass_packet(stream->time_base, packet);
 
+    if (m_keyframeIndex && m_keyframeIndex->usesByteSeek())
+        m_keyframeIndex->addPacket(packet);
+
     encoded = Packet(packet, forceCopy);
     encoded.setTimeBase(stream->time_base);
 
@@ -1016,6 +1024,10 @@ bool FormatContext::open(const QString &_url, const QString &param)
 
     formatCtx->event_flags = 0;
 
+    // Only for plain local files, CUE and chained OGG tracks are seeked within the whole file
+    if (isLocal && !isStreamed && !stillImage && param.isEmpty() && scheme == "file")
+        m_keyframeIndex = KeyframeIndex::create(formatCtx, url);
+
     packet = av_packet_alloc();
 
     if (lengthToPlay > 0.0)
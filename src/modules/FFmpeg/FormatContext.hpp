@@ -34,6 +34,7 @@ struct AVFormatContext;
 struct AVDictionary;
 struct AVStream;
 struct AVPacket;
+class KeyframeIndex;
 class OggHelper;
 class Packet;
 #ifdef Q_OS_ANDROID
@@ -93,6 +94,8 @@ private:
 
     OggHelper *oggHelper;
 
+    std::unique_ptr<KeyframeIndex> m_keyframeIndex;
+
     QList<QMPlay2Tag> m_urlTags;
 
     const bool m_reconnectNetwork;
@@ -0,0 +1,270 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <KeyframeIndex.hpp>
+
+#include <QMPlay2Core.hpp>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+extern "C"
+{
+    #include <libavformat/avformat.h>
+}
+
+constexpr quint32 g_magic = 0x514D4B49; // "QMKI"
+constexpr quint32 g_version = 1;
+
+constexpr int g_maxCacheFiles = 256;
+
+constexpr double g_minDistance = 0.5; // Don't store keyframes closer than this (in seconds)
+constexpr double g_maxGap = 10.0; // Don't trust the index if keyframes around the seek position are farther away (in seconds)
+
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+#   define HAS_INDEX_GETTERS
+#endif
+
+std::unique_ptr<KeyframeIndex> KeyframeIndex::create(AVFormatContext *formatCtx, const QString &filePath)
+{
+    const QFileInfo fileInfo(filePath);
+    if (!fileInfo.isFile())
+        return nullptr;
+
+    const int streamIdx = av_find_default_stream_index(formatCtx);
+    if (streamIdx < 0)
+        return nullptr;
+
+    const auto iformat = formatCtx->iformat;
+    const QString name = iformat->name;
+
+    Mode mode;
+    if ((name == "mpegts" || name == "mpeg") && !(iformat->flags & AVFMT_NO_BYTE_SEEK))
+    {
+        // Timestamps are stored in the stream and the demuxer resyncs after byte seek
+        mode = Mode::ByteSeek;
+    }
+#ifdef HAS_INDEX_GETTERS
+    else if (name.startsWith("matroska") || (iformat->flags & AVFMT_GENERIC_INDEX))
+    {
+        // Demuxer index is built during playback and it's used for seeking, but it's lost on close
+        mode = Mode::DemuxerIndex;
+    }
+#endif
+    else
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<KeyframeIndex> keyframeIndex(new KeyframeIndex(formatCtx, mode, streamIdx, filePath));
+    keyframeIndex->m_fileSize = fileInfo.size();
+    keyframeIndex->m_fileMTime = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    const bool loaded = keyframeIndex->load();
+#ifdef HAS_INDEX_GETTERS
+    if (mode == Mode::DemuxerIndex)
+    {
+        AVStream *stream = formatCtx->streams[streamIdx];
+        if (loaded)
+        {
+            for (const Entry &entry : std::as_const(keyframeIndex->m_entries))
+                av_add_index_entry(stream, entry.pos, entry.ts, 0, 0, AVINDEX_KEYFRAME);
+        }
+        keyframeIndex->m_demuxerEntriesCount = avformat_index_get_entries_count(stream);
+    }
+#else
+    Q_UNUSED(loaded)
+#endif
+
+    return keyframeIndex;
+}
+
+KeyframeIndex::KeyframeIndex(AVFormatContext *formatCtx, Mode mode, int streamIdx, const QString &filePath)
+    : m_formatCtx(formatCtx)
+    , m_mode(mode)
+    , m_streamIdx(streamIdx)
+    , m_filePath(filePath)
+{}
+KeyframeIndex::~KeyframeIndex()
+{
+#ifdef HAS_INDEX_GETTERS
+    if (m_mode == Mode::DemuxerIndex)
+    {
+        AVStream *stream = m_formatCtx->streams[m_streamIdx];
+        const int count = avformat_index_get_entries_count(stream);
+        if (count > m_demuxerEntriesCount) // Other instance could have more entries, e.g. file opened only for probing
+        {
+            m_entries.clear();
+            m_entries.reserve(count);
+            for (int i = 0; i < count; ++i)
+            {
+                const AVIndexEntry *indexEntry = avformat_index_get_entry(stream, i);
+                if (indexEntry && (indexEntry->flags & AVINDEX_KEYFRAME) && indexEntry->pos >= 0 && indexEntry->timestamp != AV_NOPTS_VALUE)
+                    m_entries.append({indexEntry->timestamp, indexEntry->pos});
+            }
+            m_modified = true;
+        }
+    }
+#endif
+    if (m_modified && m_entries.size() > 1)
+        save();
+}
+
+void KeyframeIndex::addPacket(const AVPacket *packet)
+{
+    if (packet->stream_index != m_streamIdx || !(packet->flags & AV_PKT_FLAG_KEY) || packet->pos < 0)
+        return;
+
+    const qint64 ts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+    if (ts == AV_NOPTS_VALUE)
+        return;
+
+    const qint64 minDistance = std::llround(g_minDistance / av_q2d(m_formatCtx->streams[m_streamIdx]->time_base));
+    const auto isNear = [&](const Entry &entry) {
+        return std::abs(entry.ts - ts) < minDistance;
+    };
+
+    // Entries are mostly appended, except after seeking
+    if (m_entries.isEmpty() || m_entries.constLast().ts < ts)
+    {
+        if (!m_entries.isEmpty() && isNear(m_entries.constLast()))
+            return;
+        m_entries.append({ts, packet->pos});
+    }
+    else
+    {
+        const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), ts, [](const Entry &entry, qint64 ts) {
+            return entry.ts < ts;
+        });
+        if (isNear(*it) || (it != m_entries.begin() && isNear(*(it - 1))))
+            return;
+        m_entries.insert(it, {ts, packet->pos});
+    }
+    m_modified = true;
+}
+
+bool KeyframeIndex::seek(double pos, bool backward)
+{
+    if (m_mode != Mode::ByteSeek || m_entries.size() < 2)
+        return false;
+
+    const double timeBase = av_q2d(m_formatCtx->streams[m_streamIdx]->time_base);
+    const qint64 ts = std::llround(pos / timeBase);
+
+    const auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), ts, [](qint64 ts, const Entry &entry) {
+        return ts < entry.ts;
+    });
+    if (it == m_entries.cbegin() || it == m_entries.cend())
+        return false;
+
+    // The position must be between two known keyframes which are close enough,
+    // otherwise there might be keyframes which were never indexed.
+    const Entry &prev = *(it - 1);
+    const Entry &next = *it;
+    if (next.ts - prev.ts > std::llround(g_maxGap / timeBase))
+        return false;
+
+    const Entry &entry = (backward || prev.ts == ts) ? prev : next;
+    return av_seek_frame(m_formatCtx, -1, entry.pos, AVSEEK_FLAG_BYTE) >= 0;
+}
+
+bool KeyframeIndex::load()
+{
+    QFile f(cacheFilePath());
+    if (!f.open(QFile::ReadOnly))
+        return false;
+
+    QDataStream stream(&f);
+
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != g_magic || version != g_version)
+        return false;
+
+    QString filePath;
+    qint64 fileSize = -1, fileMTime = 0;
+    quint8 mode = 0;
+    qint32 streamIdx = -1, timeBaseNum = 0, timeBaseDen = 0;
+    stream >> filePath >> fileSize >> fileMTime >> mode >> streamIdx >> timeBaseNum >> timeBaseDen;
+
+    const AVRational timeBase = m_formatCtx->streams[m_streamIdx]->time_base;
+    if (filePath != m_filePath || fileSize != m_fileSize || fileMTime != m_fileMTime)
+        return false;
+    if (mode != static_cast<quint8>(m_mode) || streamIdx != m_streamIdx || timeBaseNum != timeBase.num || timeBaseDen != timeBase.den)
+        return false;
+
+    qint32 count = 0;
+    stream >> count;
+    if (stream.status() != QDataStream::Ok || count < 0 || count > f.size() / 16)
+        return false;
+
+    QVector<Entry> entries(count);
+    for (Entry &entry : entries)
+        stream >> entry.ts >> entry.pos;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    m_entries = std::move(entries);
+    return true;
+}
+void KeyframeIndex::save()
+{
+    const QString filePath = cacheFilePath();
+    const QString dirPath = QFileInfo(filePath).path();
+    if (!QDir().mkpath(dirPath))
+        return;
+
+    QSaveFile f(filePath);
+    if (!f.open(QFile::WriteOnly))
+        return;
+
+    const AVRational timeBase = m_formatCtx->streams[m_streamIdx]->time_base;
+
+    QDataStream stream(&f);
+    stream << g_magic << g_version;
+    stream << m_filePath << m_fileSize << m_fileMTime << static_cast<quint8>(m_mode) << static_cast<qint32>(m_streamIdx) << static_cast<qint32>(timeBase.num) << static_cast<qint32>(timeBase.den);
+    stream << static_cast<qint32>(m_entries.size());
+    for (const Entry &entry : std::as_const(m_entries))
+        stream << entry.ts << entry.pos;
+
+    if (f.commit())
+    {
+        m_modified = false;
+        removeOldCacheFiles(dirPath);
+    }
+}
+
+QString KeyframeIndex::cacheFilePath() const
+{
+    return QMPlay2Core.getSettingsDir() + "KeyframeIndex/" + QCryptographicHash::hash(m_filePath.toUtf8(), QCryptographicHash::Md5).toHex() + ".bin";
+}
+void KeyframeIndex::removeOldCacheFiles(const QString &dirPath)
+{
+    const QFileInfoList files = QDir(dirPath).entryInfoList({"*.bin"}, QDir::Files, QDir::Time);
+    for (int i = g_maxCacheFiles; i < files.size(); ++i)
+        QFile::remove(files.at(i).filePath());
+}
@@ -0,0 +1,89 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+struct AVFormatContext;
+struct AVPacket;
+
+/*
+ * Persistent keyframe timestamp -> byte offset index of a local file. It is
+ * built during playback and stored per file (path, size and modification time).
+ *
+ * MPEG-TS/PS files are seeked directly by byte offset. For Matroska and formats
+ * with generic index the stored entries are given back to the demuxer.
+ */
+class KeyframeIndex
+{
+    Q_DISABLE_COPY(KeyframeIndex)
+
+    enum class Mode : quint8
+    {
+        ByteSeek,
+        DemuxerIndex,
+    };
+
+public:
+    // Returns "nullptr" if the format doesn't need the index
+    static std::unique_ptr<KeyframeIndex> create(AVFormatContext *formatCtx, const QString &filePath);
+
+    ~KeyframeIndex(); // Saves the index, must be destroyed before "formatCtx"
+
+    inline bool usesByteSeek() const
+    {
+        return m_mode == Mode::ByteSeek;
+    }
+
+    void addPacket(const AVPacket *packet);
+
+    // "pos" is in seconds (including the start time), returns "false" if the position is not indexed
+    bool seek(double pos, bool backward);
+
+private:
+    KeyframeIndex(AVFormatContext *formatCtx, Mode mode, int streamIdx, const QString &filePath);
+
+    bool load();
+    void save();
+
+    QString cacheFilePath() const;
+    static void removeOldCacheFiles(const QString &dirPath);
+
+private:
+    struct Entry
+    {
+        qint64 ts; // In stream time base
+        qint64 pos;
+    };
+
+    AVFormatContext *const m_formatCtx;
+    const Mode m_mode;
+    const int m_streamIdx;
+    const QString m_filePath;
+
+    qint64 m_fileSize = -1;
+    qint64 m_fileMTime = 0;
+
+    QVector<Entry> m_entries;
+    int m_demuxerEntriesCount = 0;
+    bool m_modified = false;
+};
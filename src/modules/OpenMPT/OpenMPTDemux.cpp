@@ -27,6 +27,7 @@
 #include <libopenmpt/libopenmpt.hpp>
 
 #include <algorithm>
+#include <cmath>
 
 OpenMPDemux::OpenMPDemux(Module &module)
     : m_sampleRate(Functions::getBestSampleRate())
@@ -106,15 +107,23 @@ bool OpenMPDemux::seek(double pos, bool)
         if (pos < curPos)
             m_module->set_position_seconds(0.0);
 
-        constexpr int kBufSize = 1024;
+        // libopenmpt can't snapshot the playback state, so render and discard the audio. Use low
+        // sample rate and no interpolation, it doesn't change the pattern playback state.
+        constexpr std::int32_t kFastForwardSampleRate = 8000;
+        constexpr std::size_t kBufSize = 4096;
         std::int16_t buf[kBufSize];
-        while (!m_aborted && m_module->get_position_seconds() < pos)
+        m_module->set_render_param(openmpt::module::RENDER_INTERPOLATIONFILTER_LENGTH, 1);
+        for (;;)
         {
-            if (m_module->read(m_sampleRate, kBufSize, buf) <= 0)
-            {
+            const double remaining = pos - m_module->get_position_seconds();
+            if (m_aborted || remaining <= 0.0)
+                break;
+
+            const auto count = std::clamp(static_cast<std::size_t>(std::ceil(remaining * kFastForwardSampleRate)), std::size_t(1), kBufSize);
+            if (m_module->read(kFastForwardSampleRate, count, buf) == 0)
                 break;
-            }
         }
+        m_module->set_render_param(openmpt::module::RENDER_INTERPOLATIONFILTER_LENGTH, m_interpolationFilter);
     }
     else
     {
@@ -18,15 +18,59 @@
 
 #include <OpenMPTVisPatterns.hpp>
 
+#include <QStaticText>
 #include <QPainter>
 
 #include <libopenmpt/libopenmpt.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 extern "C" {
+    #include <libavutil/buffer.h>
     #include <libavutil/frame.h>
     #include <libavutil/pixfmt.h>
 }
 
+static constexpr char kFirstChar = 33;
+static constexpr char kLastChar = 126;
+static constexpr int kNumChars = kLastChar - kFirstChar + 1;
+static constexpr int kNumColors = 9;
+
+static constexpr QRgb kBackgroundColor = qRgb(0, 0, 0);
+static constexpr QRgb kCurrentRowColor = qRgb(30, 30, 60);
+
+static quint8 colorIndex(char hlChar)
+{
+    switch (hlChar)
+    {
+        case 'n': return 0;
+        case 'm': return 1;
+        case 'i': return 2;
+        case 'u': return 3;
+        case 'v': return 4;
+        case 'e': return 5;
+        case 'f': return 6;
+        case '.': return 7;
+        default:  return 8;
+    }
+}
+static QColor color(quint8 colorIdx)
+{
+    switch (colorIdx)
+    {
+        case 0: return QColor(0, 255, 0);
+        case 1: return QColor(0, 255, 128);
+        case 2: return QColor(0, 255, 255);
+        case 3: return QColor(255, 255, 0);
+        case 4: return QColor(200, 200, 0);
+        case 5: return QColor(255, 80, 80);
+        case 6: return QColor(255, 120, 255);
+        case 7: return QColor(100, 100, 100);
+        default: return QColor(180, 180, 180);
+    }
+}
+
 static int computeMaxCellWidth(openmpt::module *module, int pattern, const QFontMetrics &fm)
 {
     const int numChannels = module->get_num_channels();
@@ -82,16 +126,29 @@ OpenMPTVisPatterns::OpenMPTVisPatterns(openmpt::module *module, int channels, in
     m_maxCellWidth = maxCellWidth;
     m_charWidth = fm.horizontalAdvance("X");
 
-    for (int i = 33; i <= 126; ++i)
-    {
-        QStaticText &st = m_charCache[i];
-        st.setText(QString(QChar(i)));
-        st.prepare(QTransform(), m_font);
-    }
+    if (m_width <= 0 || m_charWidth <= 0)
+        return;
+
+    prepareAtlas();
+
+    m_canvas = QImage(m_width, m_userRows * m_rowHeight, QImage::Format_RGB32);
+    m_canvas.fill(kBackgroundColor);
+
+    // Constant linesize, frames of every height fit into the pool buffers
+    m_linesize = (m_width * 4 + 63) & ~63;
+    m_bufferPool = av_buffer_pool_init(m_linesize * m_userRows * m_rowHeight, nullptr);
+}
+OpenMPTVisPatterns::~OpenMPTVisPatterns()
+{
+    // Buffers still used by frames are freed later
+    av_buffer_pool_uninit(&m_bufferPool);
 }
 
 Frame OpenMPTVisPatterns::render(openmpt::module *module)
 {
+    if (!m_bufferPool)
+        return {};
+
     const int curPattern = module->get_current_pattern();
     const int curRow = module->get_current_row();
 
@@ -117,90 +174,190 @@ Frame OpenMPTVisPatterns::render(openmpt::module *module)
     {
         m_rows = newRows;
         m_height = m_rows * m_rowHeight;
+        m_canvasPattern = -1;
     }
 
     const int firstRow = qMax(0, curRow - m_rows / 2);
     const int lastRow = qMin(numRows - 1, firstRow + m_rows - 1);
 
-    AVFrame *avFrame = av_frame_alloc();
-    avFrame->width = m_width;
-    avFrame->height = m_height;
-    avFrame->format = AV_PIX_FMT_BGRA;
+    std::vector<bool> dirtyRows(m_rows, true);
+    if (m_canvasPattern == curPattern && qAbs(firstRow - m_canvasFirstRow) < m_rows)
+    {
+        // Scroll the canvas, then redraw the exposed rows and the old and new current row
+        const int delta = firstRow - m_canvasFirstRow;
+        scrollCanvas(delta);
+        for (int visRow = 0; visRow < m_rows; ++visRow)
+        {
+            const int prevVisRow = visRow + delta;
+            dirtyRows[visRow] = (prevVisRow < 0 || prevVisRow >= m_rows);
+        }
+        for (const int row : {m_canvasCurRow, curRow})
+        {
+            const int visRow = row - firstRow;
+            if (visRow >= 0 && visRow < m_rows)
+                dirtyRows[visRow] = true;
+        }
+    }
 
-    if (av_frame_get_buffer(avFrame, 0) != 0)
+    for (int visRow = 0; visRow < m_rows; ++visRow)
+    {
+        if (!dirtyRows[visRow])
+            continue;
+
+        const int row = firstRow + visRow;
+        if (row <= lastRow)
+            drawRow(rowGlyphs(module, curPattern, row), visRow, row == curRow);
+        else
+            clearRow(visRow);
+    }
+
+    m_canvasPattern = curPattern;
+    m_canvasFirstRow = firstRow;
+    m_canvasCurRow = curRow;
+
+    AVFrame *avFrame = av_frame_alloc();
+    avFrame->buf[0] = av_buffer_pool_get(m_bufferPool);
+    if (!avFrame->buf[0])
     {
         av_frame_free(&avFrame);
         return {};
     }
+    avFrame->data[0] = avFrame->buf[0]->data;
+    avFrame->linesize[0] = m_linesize;
+    avFrame->width = m_width;
+    avFrame->height = m_height;
+    avFrame->format = AV_PIX_FMT_BGRA;
+
+    for (int y = 0; y < m_height; ++y)
+        memcpy(avFrame->data[0] + y * m_linesize, m_canvas.constScanLine(y), m_width * sizeof(QRgb));
+
+    Frame frame(avFrame);
+    av_frame_free(&avFrame);
 
-    QImage img(avFrame->data[0], m_width, m_height, avFrame->linesize[0], QImage::Format_RGB32);
-    img.fill(Qt::black);
+    return frame;
+}
+void OpenMPTVisPatterns::reset()
+{
+    m_lastPattern = -1;
+    m_lastRow = -1;
+}
+
+void OpenMPTVisPatterns::prepareAtlas()
+{
+    m_atlas = QImage(kNumChars * m_charWidth, 2 * kNumColors * m_rowHeight, QImage::Format_RGB32);
 
-    QPainter p(&img);
+    QPainter p(&m_atlas);
+    p.fillRect(0, 0, m_atlas.width(), kNumColors * m_rowHeight, QColor::fromRgb(kBackgroundColor));
+    p.fillRect(0, kNumColors * m_rowHeight, m_atlas.width(), kNumColors * m_rowHeight, QColor::fromRgb(kCurrentRowColor));
     p.setFont(m_font);
 
-    for (int row = firstRow; row <= lastRow; ++row)
+    for (int c = 0; c < kNumChars; ++c)
     {
-        const int y = (row - firstRow) * m_rowHeight;
+        QStaticText staticText(QString(QChar(kFirstChar + c)));
+        staticText.prepare(QTransform(), m_font);
 
-        if (row == curRow)
-            p.fillRect(0, y, m_width, m_rowHeight, QColor(30, 30, 60));
-
-        for (int ch = 0; ch < m_channels; ++ch)
+        for (int style = 0; style < 2; ++style)
         {
-            const int x = ch * m_maxCellWidth;
+            const bool isCurrentRow = (style == 1);
+            for (quint8 colorIdx = 0; colorIdx < kNumColors; ++colorIdx)
+            {
+                const QRect cell(c * m_charWidth, (style * kNumColors + colorIdx) * m_rowHeight, m_charWidth, m_rowHeight);
+                p.setClipRect(cell);
+                p.setPen(isCurrentRow ? color(colorIdx).lighter(130) : color(colorIdx));
+                p.drawStaticText(cell.x(), cell.y() + 1, staticText);
+            }
+        }
+    }
+}
 
-            const std::string text = module->format_pattern_row_channel(curPattern, row, ch);
-            const std::string hl = module->highlight_pattern_row_channel(curPattern, row, ch);
+const std::vector<OpenMPTVisPatterns::Glyph> &OpenMPTVisPatterns::rowGlyphs(openmpt::module *module, int pattern, int row)
+{
+    if (pattern != m_glyphsPattern)
+    {
+        const int numRows = qMax(0, module->get_pattern_num_rows(pattern));
+        m_glyphsPattern = pattern;
+        m_rowGlyphs.assign(numRows, {});
+        m_rowGlyphsReady.assign(numRows, false);
+    }
 
-            const QString qText = QString::fromStdString(text);
-            const QString qHl = QString::fromStdString(hl);
+    auto &glyphs = m_rowGlyphs[row];
+    if (m_rowGlyphsReady[row])
+        return glyphs;
 
-            for (int i = 0; i < qText.size(); ++i)
-            {
-                const QChar c = qText.at(i);
-                if (c == ' ')
-                    continue;
-
-                char hlChar = (i < qHl.size()) ? qHl.at(i).toLatin1() : ' ';
-                QColor color = [hlChar]() {
-                    switch (hlChar)
-                    {
-                        case 'n': return QColor(0, 255, 0);
-                        case 'm': return QColor(0, 255, 128);
-                        case 'i': return QColor(0, 255, 255);
-                        case 'u': return QColor(255, 255, 0);
-                        case 'v': return QColor(200, 200, 0);
-                        case 'e': return QColor(255, 80, 80);
-                        case 'f': return QColor(255, 120, 255);
-                        case '.': return QColor(100, 100, 100);
-                        default:  return QColor(180, 180, 180);
-                    }
-                }();
-
-                if (row == curRow)
-                    color = color.lighter(130);
-
-                p.setPen(color);
-
-                const QPoint textPos(x + i * m_charWidth, y + 1);
-                if (Q_LIKELY(c.unicode() >= 33 && c.unicode() <= 126))
-                    p.drawStaticText(textPos, m_charCache[c.unicode()]);
-                else
-                    p.drawText(textPos, c);
-            }
+    for (int ch = 0; ch < m_channels; ++ch)
+    {
+        const int cellX = ch * m_maxCellWidth;
+
+        const std::string text = module->format_pattern_row_channel(pattern, row, ch);
+        const std::string hl = module->highlight_pattern_row_channel(pattern, row, ch);
+
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const char c = text[i];
+            if (c < kFirstChar || c > kLastChar)
+                continue;
+
+            const int x = cellX + static_cast<int>(i) * m_charWidth;
+            if (x >= m_width)
+                break;
+
+            glyphs.push_back({
+                static_cast<quint16>(x),
+                static_cast<quint8>(c),
+                colorIndex(i < hl.size() ? hl[i] : ' '),
+            });
         }
     }
+    m_rowGlyphsReady[row] = true;
 
-    p.end();
+    return glyphs;
+}
 
-    Frame frame(avFrame);
-    av_frame_free(&avFrame);
+void OpenMPTVisPatterns::drawRow(const std::vector<Glyph> &glyphs, int visRow, bool current)
+{
+    const int y0 = visRow * m_rowHeight;
+    const QRgb bgColor = current ? kCurrentRowColor : kBackgroundColor;
+    for (int y = 0; y < m_rowHeight; ++y)
+    {
+        auto line = reinterpret_cast<QRgb *>(m_canvas.scanLine(y0 + y));
+        std::fill(line, line + m_width, bgColor);
+    }
 
-    return frame;
+    const int atlasRowOffset = current ? kNumColors : 0;
+    for (const Glyph &glyph : glyphs)
+    {
+        const int w = qMin(m_charWidth, m_width - glyph.x);
+        const int atlasX = (glyph.chr - kFirstChar) * m_charWidth;
+        const int atlasY = (atlasRowOffset + glyph.color) * m_rowHeight;
+        for (int y = 0; y < m_rowHeight; ++y)
+        {
+            memcpy(
+                reinterpret_cast<QRgb *>(m_canvas.scanLine(y0 + y)) + glyph.x,
+                reinterpret_cast<const QRgb *>(m_atlas.constScanLine(atlasY + y)) + atlasX,
+                w * sizeof(QRgb)
+            );
+        }
+    }
 }
-void OpenMPTVisPatterns::reset()
+void OpenMPTVisPatterns::clearRow(int visRow)
 {
-    m_lastPattern = -1;
-    m_lastRow = -1;
+    const int y0 = visRow * m_rowHeight;
+    for (int y = 0; y < m_rowHeight; ++y)
+    {
+        auto line = reinterpret_cast<QRgb *>(m_canvas.scanLine(y0 + y));
+        std::fill(line, line + m_width, kBackgroundColor);
+    }
+}
+void OpenMPTVisPatterns::scrollCanvas(int rows)
+{
+    if (rows == 0)
+        return;
+
+    const size_t rowBytes = static_cast<size_t>(m_canvas.bytesPerLine()) * m_rowHeight;
+    const size_t bytesToMove = rowBytes * (m_rows - qAbs(rows));
+    uchar *bits = m_canvas.bits();
+    if (rows > 0)
+        memmove(bits, bits + rows * rowBytes, bytesToMove);
+    else
+        memmove(bits + qAbs(rows) * rowBytes, bits, bytesToMove);
 }
@@ -20,16 +20,37 @@
 
 #include <OpenMPTVisBase.hpp>
 
-#include <QStaticText>
+#include <QImage>
+
+#include <vector>
+
+struct AVBufferPool;
 
 class OpenMPTVisPatterns : public OpenMPTVisBase
 {
 public:
     OpenMPTVisPatterns(openmpt::module *module, int channels, int rows);
+    ~OpenMPTVisPatterns();
 
     Frame render(openmpt::module *module) override;
     void reset() override;
 
+private:
+    struct Glyph
+    {
+        quint16 x;
+        quint8 chr;
+        quint8 color;
+    };
+
+    void prepareAtlas();
+
+    const std::vector<Glyph> &rowGlyphs(openmpt::module *module, int pattern, int row);
+
+    void drawRow(const std::vector<Glyph> &glyphs, int visRow, bool current);
+    void clearRow(int visRow);
+    void scrollCanvas(int rows);
+
 private:
     int m_channels{0};
     int m_userRows{0};
@@ -38,7 +59,23 @@ private:
     int m_maxCellWidth{0};
     int m_charWidth{0};
     QFont m_font;
-    QStaticText m_charCache[127];
     int m_lastPattern{-1};
     int m_lastRow{-1};
+
+    // Pre-rendered printable ASCII characters for every color, for normal and current row
+    QImage m_atlas;
+
+    // Visible rows, only changed rows are redrawn
+    QImage m_canvas;
+    int m_canvasPattern{-1};
+    int m_canvasFirstRow{-1};
+    int m_canvasCurRow{-1};
+
+    // Formatted rows of the current pattern
+    int m_glyphsPattern{-1};
+    std::vector<std::vector<Glyph>> m_rowGlyphs;
+    std::vector<bool> m_rowGlyphsReady;
+
+    AVBufferPool *m_bufferPool{nullptr};
+    int m_linesize{0};
 };
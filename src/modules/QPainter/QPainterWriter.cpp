@@ -24,12 +24,32 @@
 
 #include <QCoreApplication>
 #include <QPainter>
+#include <QThread>
+
+#include <algorithm>
 
 extern "C" {
     #include <libavutil/cpu.h>
     #include <libavutil/mem.h>
 }
 
+static inline int scalerThreads()
+{
+    static const int threads = std::min(QThread::idealThreadCount(), 8);
+    return threads;
+}
+
+static void mirrorHorizontally(QImage &img)
+{
+    const int w = img.width();
+    const int h = img.height();
+    for (int y = 0; y < h; ++y)
+    {
+        auto line = reinterpret_cast<quint32 *>(img.scanLine(y));
+        std::reverse(line, line + w);
+    }
+}
+
 Drawable::Drawable(QPainterWriter &writer) :
     writer(writer)
 {
@@ -50,28 +70,40 @@ void Drawable::draw(const Frame &newVideoFrame, bool canRepaint, bool entireScre
         update();
         return;
     }
+    // Don't enlarge by swscale, the zoomed image can be much bigger than the frame. QPainter scales it instead.
     m_scaleByQt = (imgW > videoFrame.width()) || (imgH > videoFrame.height());
-    if (imgScaler.create(videoFrame, m_scaleByQt ? -1 : imgW, m_scaleByQt ? -1 : imgH))
+    const int scaledW = m_scaleByQt ? videoFrame.width() : imgW;
+    const int scaledH = m_scaleByQt ? videoFrame.height() : imgH;
+
+    // Scaling, vertical flip and picture adjustment are done by multi-threaded swscale in a single pass
+    if (imgScaler.create(videoFrame, scaledW, scaledH, scalerThreads()))
     {
-        auto createImg = [this](int w, int h) {
-            auto imgData = reinterpret_cast<uint8_t *>(av_malloc(w * h * 4 + av_cpu_max_align()));
-            img = QImage(imgData, w, h, QImage::Format_RGB32, [](void *ptr) {
-                av_free(ptr);
-            }, imgData);
-        };
-        if (m_scaleByQt && (img.width() != videoFrame.width() || img.height() != videoFrame.height()))
+        if (img.width() != scaledW || img.height() != scaledH)
         {
-            createImg(videoFrame.width(), videoFrame.height());
+            const size_t imgSize = static_cast<size_t>(scaledW) * static_cast<size_t>(scaledH) * 4 + av_cpu_max_align();
+            auto imgData = reinterpret_cast<uint8_t *>(av_malloc(imgSize));
+            if (imgData)
+            {
+                img = QImage(imgData, scaledW, scaledH, QImage::Format_RGB32, [](void *ptr) {
+                    av_free(ptr);
+                }, imgData);
+                if (!m_scaleByQt)
+                    img.setDevicePixelRatio(devicePixelRatioF());
+            }
+            else
+            {
+                img = QImage();
+            }
         }
-        else if (!m_scaleByQt && (img.width() != imgW || img.height() != imgH))
+        if (!img.isNull())
         {
-            createImg(imgW, imgH);
+            const bool eqByScaler = imgScaler.setEQ(Contrast, Brightness);
+            imgScaler.scale(videoFrame, img.bits(), writer.flip & Qt::Vertical);
+            if (writer.flip & Qt::Horizontal)
+                mirrorHorizontally(img);
+            if (!eqByScaler && (Brightness != 0 || Contrast != 100))
+                Functions::ImageEQ(Contrast, Brightness, img.bits(), img.bytesPerLine() * img.height());
         }
-        imgScaler.scale(videoFrame, img.bits());
-        if (writer.flip)
-            img = img.mirrored(writer.flip & Qt::Horizontal, writer.flip & Qt::Vertical);
-        if (Brightness != 0 || Contrast != 100)
-            Functions::ImageEQ(Contrast, Brightness, img.bits(), img.bytesPerLine() * img.height());
     }
     if (canRepaint && !entireScreen)
         update(X, Y, W, H);
@@ -94,10 +126,16 @@ void Drawable::paintEvent(QPaintEvent *)
 {
     QPainter p(this);
 
+    p.translate(X, Y);
     if (m_scaleByQt)
+    {
         p.setRenderHint(QPainter::SmoothPixmapTransform);
-    p.translate(X, Y);
-    p.drawImage(QRect(0, 0, W, H), img);
+        p.drawImage(QRect(0, 0, W, H), img);
+    }
+    else
+    {
+        p.drawImage(QPointF(), img); // Image has the device pixel ratio and the size of the destination, so it's not scaled
+    }
 
     if (!osd_list.isEmpty())
     {
@@ -19,6 +19,8 @@
 #include <BlendDeint.hpp>
 #include <VideoFilters.hpp>
 
+#include <vector>
+
 BlendDeint::BlendDeint()
     : VideoFilter(true)
 {
@@ -42,17 +44,42 @@ bool BlendDeint::filter(QQueue<Frame> &framesQueue)
             videoFrame = std::move(newFrame);
         }
 #endif
+
+        // Lines are blended in-place with the next line, so save the first line
+        // of each slice before other slices modify it.
+        const int jobsCount = sliceJobsCount(videoFrame.height(1) - 2);
+        std::vector<quint8> boundaryLines[3];
+        quint8 *planes[3];
         for (int p = 0; p < 3; ++p)
         {
             const int linesize = videoFrame.linesize(p);
-            quint8 *data = videoFrame.data(p) + linesize;
+            planes[p] = videoFrame.data(p);
+            const quint8 *data = planes[p] + linesize;
             const int h = videoFrame.height(p) - 2;
-            for (int i = 0; i < h; ++i)
+            boundaryLines[p].resize((jobsCount - 1) * linesize);
+            for (int j = 1; j < jobsCount; ++j)
+                memcpy(boundaryLines[p].data() + (j - 1) * linesize, data + (h * j / jobsCount) * linesize, linesize);
+        }
+
+        processSlices(jobsCount, [&](const int jobId, const int jobsCount) {
+            for (int p = 0; p < 3; ++p)
             {
-                VideoFilters::averageTwoLines(data, data, data + linesize, linesize);
-                data += linesize;
+                const int linesize = videoFrame.linesize(p);
+                const int h = videoFrame.height(p) - 2;
+                const int sliceStart = (h *  jobId   ) / jobsCount;
+                const int sliceEnd   = (h * (jobId+1)) / jobsCount;
+                quint8 *data = planes[p] + linesize * (sliceStart + 1);
+                for (int i = sliceStart; i < sliceEnd; ++i)
+                {
+                    const quint8 *nextLine = (i + 1 == sliceEnd && jobId + 1 < jobsCount)
+                        ? boundaryLines[p].data() + jobId * linesize
+                        : data + linesize
+                    ;
+                    VideoFilters::averageTwoLines(data, data, nextLine, linesize);
+                    data += linesize;
+                }
             }
-        }
+        });
         framesQueue.enqueue(videoFrame);
     }
     return !m_internalQueue.isEmpty();
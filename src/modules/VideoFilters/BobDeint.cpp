@@ -41,43 +41,57 @@ bool BobDeint::filter(QQueue<Frame> &framesQueue)
 
         const bool parity = (isTopFieldFirst(sourceFrame) == m_secondFrame);
 
+        quint8 *dstPlanes[3];
         for (int p = 0; p < 3; ++p)
-        {
-            const int linesizeSrc = sourceFrame.linesize(p);
-            const int linesizeDst = destFrame.linesize(p);
-            const int minLinesize = std::min(linesizeSrc, linesizeDst);
-            const quint8 *src = sourceFrame.constData(p);
-            quint8 *dst = destFrame.data(p);
+            dstPlanes[p] = destFrame.data(p);
 
-            const int h = sourceFrame.height(p);
-            const int halfH = (h >> 1) - 1;
-
-            if (parity)
-            {
-                src += linesizeSrc;
-                memcpy(dst, src, minLinesize); //Duplicate first line (simple deshake)
-                dst += linesizeDst;
-            }
-            for (int y = 0; y < halfH; ++y)
+        processSlices(sliceJobsCount(sourceFrame.height(1) >> 1), [&](const int jobId, const int jobsCount) {
+            for (int p = 0; p < 3; ++p)
             {
-                memcpy(dst, src, minLinesize);
-                dst += linesizeDst;
+                const int linesizeSrc = sourceFrame.linesize(p);
+                const int linesizeDst = destFrame.linesize(p);
+                const int minLinesize = std::min(linesizeSrc, linesizeDst);
+                const quint8 *src = sourceFrame.constData(p);
+                quint8 *dst = dstPlanes[p];
+
+                const int h = sourceFrame.height(p);
+                const int halfH = (h >> 1) - 1;
+
+                const int sliceStart = (halfH *  jobId   ) / jobsCount;
+                const int sliceEnd   = (halfH * (jobId+1)) / jobsCount;
+
+                if (parity)
+                {
+                    src += linesizeSrc;
+                    if (jobId == 0)
+                        memcpy(dst, src, minLinesize); //Duplicate first line (simple deshake)
+                    dst += linesizeDst;
+                }
+                src += sliceStart * (linesizeSrc << 1);
+                dst += sliceStart * (linesizeDst << 1);
+                for (int y = sliceStart; y < sliceEnd; ++y)
+                {
+                    memcpy(dst, src, minLinesize);
+                    dst += linesizeDst;
 
-                VideoFilters::averageTwoLines(dst, src, src + (linesizeSrc << 1), minLinesize);
-                dst += linesizeDst;
+                    VideoFilters::averageTwoLines(dst, src, src + (linesizeSrc << 1), minLinesize);
+                    dst += linesizeDst;
 
-                src += linesizeSrc << 1;
-            }
-            memcpy(dst, src, minLinesize); //Copy last line
-            if (!parity)
-                memcpy(dst + linesizeDst, dst, linesizeDst);
-            if (h & 1) //Duplicate last line for odd height
-            {
+                    src += linesizeSrc << 1;
+                }
+                if (jobId + 1 < jobsCount)
+                    continue;
+                memcpy(dst, src, minLinesize); //Copy last line
                 if (!parity)
-                    dst += linesizeDst;
-                memcpy(dst + linesizeDst, dst, linesizeDst);
+                    memcpy(dst + linesizeDst, dst, linesizeDst);
+                if (h & 1) //Duplicate last line for odd height
+                {
+                    if (!parity)
+                        dst += linesizeDst;
+                    memcpy(dst + linesizeDst, dst, linesizeDst);
+                }
             }
-        }
+        });
 
         deinterlaceDoublerCommon(destFrame);
         framesQueue.enqueue(destFrame);
@@ -38,24 +38,32 @@ bool MotionBlur::filter(QQueue<Frame> &framesQueue)
         Frame videoFrame2 = getNewFrame(videoFrame1);
         const Frame &videoFrame3 = m_internalQueue.at(0);
 
+        quint8 *destPlanes[3];
         for (int p = 0; p < 3; ++p)
-        {
-            const quint8 *src1 = videoFrame1.constData(p);
-            const quint8 *src2 = videoFrame3.constData(p);
-            quint8 *dest = videoFrame2.data(p);
-            const int linesizeSrc1 = videoFrame1.linesize(p);
-            const int linesizeDest = videoFrame2.linesize(p);
-            const int linesizeSrc2 = videoFrame3.linesize(p);
-            const int minLinesize = std::min({linesizeSrc1, linesizeDest, linesizeSrc2});
-            const int h = videoFrame1.height(p);
-            for (int i = 0; i < h; ++i)
+            destPlanes[p] = videoFrame2.data(p);
+
+        processSlices(sliceJobsCount(videoFrame1.height(1)), [&](const int jobId, const int jobsCount) {
+            for (int p = 0; p < 3; ++p)
             {
-                VideoFilters::averageTwoLines(dest, src1, src2, minLinesize);
-                dest += linesizeDest;
-                src1 += linesizeSrc1;
-                src2 += linesizeSrc2;
+                const int linesizeSrc1 = videoFrame1.linesize(p);
+                const int linesizeDest = videoFrame2.linesize(p);
+                const int linesizeSrc2 = videoFrame3.linesize(p);
+                const int minLinesize = std::min({linesizeSrc1, linesizeDest, linesizeSrc2});
+                const int h = videoFrame1.height(p);
+                const int sliceStart = (h *  jobId   ) / jobsCount;
+                const int sliceEnd   = (h * (jobId+1)) / jobsCount;
+                const quint8 *src1 = videoFrame1.constData(p) + sliceStart * linesizeSrc1;
+                const quint8 *src2 = videoFrame3.constData(p) + sliceStart * linesizeSrc2;
+                quint8 *dest = destPlanes[p] + sliceStart * linesizeDest;
+                for (int i = sliceStart; i < sliceEnd; ++i)
+                {
+                    VideoFilters::averageTwoLines(dest, src1, src2, minLinesize);
+                    dest += linesizeDest;
+                    src1 += linesizeSrc1;
+                    src2 += linesizeSrc2;
+                }
             }
-        }
+        });
 
         videoFrame2.setTS(getMidFrameTS(videoFrame2.ts(), videoFrame3.ts()));
 
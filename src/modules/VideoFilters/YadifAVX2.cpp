@@ -0,0 +1,88 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <YadifSIMD.hpp>
+
+#include <immintrin.h>
+
+namespace {
+
+struct AVX2
+{
+    using V = __m256i;
+    static constexpr int N = 16;
+
+    static inline V load(const quint8 *p)
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    }
+    static inline void store(quint8 *p, const V v)
+    {
+        // "packus" works within 128-bit lanes, so move both results into the lower half
+        const V packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(packed));
+    }
+
+    static inline V set1(const short v)
+    {
+        return _mm256_set1_epi16(v);
+    }
+
+    static inline V add(const V a, const V b)
+    {
+        return _mm256_add_epi16(a, b);
+    }
+    static inline V sub(const V a, const V b)
+    {
+        return _mm256_sub_epi16(a, b);
+    }
+    static inline V shr1(const V v)
+    {
+        return _mm256_srai_epi16(v, 1);
+    }
+    static inline V abs(const V v)
+    {
+        return _mm256_abs_epi16(v);
+    }
+
+    static inline V min(const V a, const V b)
+    {
+        return _mm256_min_epi16(a, b);
+    }
+    static inline V max(const V a, const V b)
+    {
+        return _mm256_max_epi16(a, b);
+    }
+
+    static inline V lt(const V a, const V b)
+    {
+        return _mm256_cmpgt_epi16(b, a);
+    }
+    static inline V bitAnd(const V a, const V b)
+    {
+        return _mm256_and_si256(a, b);
+    }
+    static inline V select(const V mask, const V a, const V b)
+    {
+        return _mm256_blendv_epi8(b, a, mask);
+    }
+};
+
+}
+
+YADIF_FILTER_LINE_SIMD_IMPL(yadifFilterLineAVX2, AVX2)
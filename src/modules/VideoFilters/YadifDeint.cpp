@@ -22,13 +22,11 @@
 */
 
 #include <YadifDeint.hpp>
+#include <YadifSIMD.hpp>
 
 #include <QMPlay2Core.hpp>
 
-#include <QtConcurrent/QtConcurrentRun>
-
 #include <algorithm>
-#include <vector>
 
 using namespace std;
 
@@ -42,12 +40,7 @@ static inline void check(const quint8 *const curr,
     const int score = abs(curr[mrefs-1+j] - curr[prefs-1-j]) + abs(curr[mrefs+j] - curr[prefs-j]) + abs(curr[mrefs+1+j] - curr[prefs+1-j]);
     if (score < spatialScore)
     {
-        // This must be in a separate condition w/o assigning condition to a variable,
-        // otherwise the compiler will not optimize it.
         spatialScore = score;
-    }
-    if (score < spatialScore)
-    {
         spatialPred = (curr[mrefs+j] + curr[prefs-j]) >> 1;
         switch (j)
         {
@@ -114,6 +107,70 @@ static inline void filterLine(quint8 *dest, const void *const destEnd,
     }
 }
 
+static YadifFilterLineFn getFilterLineSIMD()
+{
+#if defined(YADIF_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return yadifFilterLineAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return yadifFilterLineSSE2;
+#elif defined(YADIF_NEON)
+    return yadifFilterLineNEON;
+#endif
+    return nullptr;
+}
+
+template<bool spatialCheck>
+static inline void filterLineWithEdges(quint8 *dest, const int w,
+                                       const quint8 *prev, const quint8 *curr, const quint8 *next,
+                                       const qptrdiff prefs, const qptrdiff mrefs,
+                                       const bool filterParity)
+{
+    static const YadifFilterLineFn filterLineSIMD = getFilterLineSIMD();
+
+    filterLine<false, spatialCheck>
+    (
+        dest,
+        dest + 3,
+        prev,
+        curr,
+        next,
+        prefs,
+        mrefs,
+        filterParity
+    );
+
+    int x = 3;
+    if (filterLineSIMD)
+        x += filterLineSIMD(dest + x, w - 6, prev + x, curr + x, next + x, prefs, mrefs, filterParity, spatialCheck);
+
+    // Scalar code for the remaining pixels or if SIMD is not available
+    filterLine<true, spatialCheck>
+    (
+        dest  + x,
+        dest  + w - 3,
+        prev  + x,
+        curr  + x,
+        next  + x,
+        prefs,
+        mrefs,
+        filterParity
+    );
+
+    filterLine<false, spatialCheck>
+    (
+        dest  + w - 3,
+        dest  + w,
+        prev  + w - 3,
+        curr  + w - 3,
+        next  + w - 3,
+        prefs,
+        mrefs,
+        filterParity
+    );
+}
+
 static void filterSlice(const int plane, const int parity, const int tff, const bool spatialCheck,
                         Frame &destFrame, const Frame &prevFrame, const Frame &currFrame, const Frame &nextFrame,
                         const int jobId, const int jobsCount)
@@ -145,77 +202,9 @@ static void filterSlice(const int plane, const int parity, const int tff, const
             const int mrefs = y ? -refs : refs;
 
             if (spatialCheck && y != 1 && y + 2 != h)
-            {
-                filterLine<false, true>
-                (
-                    dest,
-                    dest + 3,
-                    prev,
-                    curr,
-                    next,
-                    prefs,
-                    mrefs,
-                    filterParity
-                );
-                filterLine<true, true>
-                (
-                    dest  + 3,
-                    dest  + w - 3,
-                    prev  + 3,
-                    curr  + 3,
-                    next  + 3,
-                    prefs,
-                    mrefs,
-                    filterParity
-                );
-                filterLine<false, true>
-                (
-                    dest  + w - 3,
-                    dest  + w,
-                    prev  + w - 3,
-                    curr  + w - 3,
-                    next  + w - 3,
-                    prefs,
-                    mrefs,
-                    filterParity
-                );
-            }
+                filterLineWithEdges<true>(dest, w, prev, curr, next, prefs, mrefs, filterParity);
             else
-            {
-                filterLine<false, false>
-                (
-                    dest,
-                    dest + 3,
-                    prev,
-                    curr,
-                    next,
-                    prefs,
-                    mrefs,
-                    filterParity
-                );
-                filterLine<true, false>
-                (
-                    dest  + 3,
-                    dest  + w - 3,
-                    prev  + 3,
-                    curr  + 3,
-                    next  + 3,
-                    prefs,
-                    mrefs,
-                    filterParity
-                );
-                filterLine<false, false>
-                (
-                    dest  + w - 3,
-                    dest  + w,
-                    prev  + w - 3,
-                    curr  + w - 3,
-                    next  + w - 3,
-                    prefs,
-                    mrefs,
-                    filterParity
-                );
-            }
+                filterLineWithEdges<false>(dest, w, prev, curr, next, prefs, mrefs, filterParity);
         }
         else
         {
@@ -231,7 +220,6 @@ YadifDeint::YadifDeint(bool doubler, bool spatialCheck)
     , m_doubler(doubler)
     , m_spatialCheck(spatialCheck)
 {
-    m_threadsPool.setMaxThreadCount(min(QThread::idealThreadCount(), 18));
     addParam("DeinterlaceFlags");
     addParam("W");
     addParam("H");
@@ -264,17 +252,7 @@ bool YadifDeint::filter(QQueue<Frame> &framesQueue)
             }
         };
 
-        const int threadsCount = min(m_threadsPool.maxThreadCount(), destFrame.height(1));
-
-        vector<QFuture<void>> threads;
-        threads.reserve(threadsCount);
-
-        for (int i = 1; i < threadsCount; ++i)
-            threads.push_back(QtConcurrent::run(&m_threadsPool, doFilter, i, threadsCount));
-        doFilter(0, threadsCount);
-
-        for (auto &&thread : threads)
-            thread.waitForFinished();
+        processSlices(sliceJobsCount(destFrame.height(1)), doFilter);
 
         if (m_doubler)
             deinterlaceDoublerCommon(destFrame);
@@ -20,8 +20,6 @@
 
 #include <VideoFilter.hpp>
 
-#include <QThreadPool>
-
 class YadifDeint final : public VideoFilter
 {
 public:
@@ -33,7 +31,6 @@ public:
 private:
     const bool m_doubler;
     const bool m_spatialCheck;
-    QThreadPool m_threadsPool;
 };
 
 #define YadifDeintName "Yadif"
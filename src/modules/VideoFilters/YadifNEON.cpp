@@ -0,0 +1,86 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <YadifSIMD.hpp>
+
+#include <arm_neon.h>
+
+namespace {
+
+struct NEON
+{
+    using V = int16x8_t;
+    static constexpr int N = 8;
+
+    static inline V load(const quint8 *p)
+    {
+        return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+    }
+    static inline void store(quint8 *p, const V v)
+    {
+        vst1_u8(p, vqmovun_s16(v));
+    }
+
+    static inline V set1(const short v)
+    {
+        return vdupq_n_s16(v);
+    }
+
+    static inline V add(const V a, const V b)
+    {
+        return vaddq_s16(a, b);
+    }
+    static inline V sub(const V a, const V b)
+    {
+        return vsubq_s16(a, b);
+    }
+    static inline V shr1(const V v)
+    {
+        return vshrq_n_s16(v, 1);
+    }
+    static inline V abs(const V v)
+    {
+        return vabsq_s16(v);
+    }
+
+    static inline V min(const V a, const V b)
+    {
+        return vminq_s16(a, b);
+    }
+    static inline V max(const V a, const V b)
+    {
+        return vmaxq_s16(a, b);
+    }
+
+    static inline V lt(const V a, const V b)
+    {
+        return vreinterpretq_s16_u16(vcltq_s16(a, b));
+    }
+    static inline V bitAnd(const V a, const V b)
+    {
+        return vandq_s16(a, b);
+    }
+    static inline V select(const V mask, const V a, const V b)
+    {
+        return vbslq_s16(vreinterpretq_u16_s16(mask), a, b);
+    }
+};
+
+}
+
+YADIF_FILTER_LINE_SIMD_IMPL(yadifFilterLineNEON, NEON)
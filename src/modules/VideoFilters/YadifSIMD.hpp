@@ -0,0 +1,138 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Vectorized Yadif kernel, see "filterLine()" in "YadifDeint.cpp" for the scalar reference.
+    Based on the Yadif deinterlacing filter from FFmpeg (libavfilter/vf_yadif.c)
+    Copyright (C) 2006-2011 Michael Niedermayer <michaelni@gmx.at>
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+// Filters "w" pixels at most (rounded down to the vector width), returns the number of filtered pixels.
+// At least 3 pixels on the left and on the right side of the range must be readable.
+using YadifFilterLineFn = int (*)(quint8 *dest, const int w,
+                                  const quint8 *prev, const quint8 *curr, const quint8 *next,
+                                  const qptrdiff prefs, const qptrdiff mrefs,
+                                  const bool filterParity, const bool spatialCheck);
+
+int yadifFilterLineSSE2(quint8 *dest, const int w,
+                        const quint8 *prev, const quint8 *curr, const quint8 *next,
+                        const qptrdiff prefs, const qptrdiff mrefs,
+                        const bool filterParity, const bool spatialCheck);
+int yadifFilterLineAVX2(quint8 *dest, const int w,
+                        const quint8 *prev, const quint8 *curr, const quint8 *next,
+                        const qptrdiff prefs, const qptrdiff mrefs,
+                        const bool filterParity, const bool spatialCheck);
+int yadifFilterLineNEON(quint8 *dest, const int w,
+                        const quint8 *prev, const quint8 *curr, const quint8 *next,
+                        const qptrdiff prefs, const qptrdiff mrefs,
+                        const bool filterParity, const bool spatialCheck);
+
+/*
+ * "Ops" provides a vector of signed 16-bit lanes ("V") holding "N" pixels and operations on it.
+ * Every instruction set implements "Ops" in its own translation unit compiled with proper flags.
+ */
+template<typename Ops, bool spatialCheck>
+static inline int yadifFilterLineSIMD(quint8 *dest, const int w,
+                                      const quint8 *prev, const quint8 *curr, const quint8 *next,
+                                      const qptrdiff prefs, const qptrdiff mrefs,
+                                      const bool filterParity)
+{
+    using V = typename Ops::V;
+
+    const quint8 *prev2 = filterParity ? prev : curr;
+    const quint8 *next2 = filterParity ? curr : next;
+
+    const auto absDiff = [](const V a, const V b) {
+        return Ops::abs(Ops::sub(a, b));
+    };
+    const auto avg = [](const V a, const V b) {
+        return Ops::shr1(Ops::add(a, b));
+    };
+
+    int x = 0;
+    for (; x + Ops::N <= w; x += Ops::N)
+    {
+        const quint8 *const cur = curr + x;
+
+        const V c = Ops::load(cur + mrefs);
+        const V e = Ops::load(cur + prefs);
+        const V p2 = Ops::load(prev2 + x);
+        const V n2 = Ops::load(next2 + x);
+
+        const V d = avg(p2, n2);
+        const V temporalDiff0 = absDiff(p2, n2);
+        const V temporalDiff1 = Ops::shr1(Ops::add(absDiff(Ops::load(prev + x + mrefs), c), absDiff(Ops::load(prev + x + prefs), e)));
+        const V temporalDiff2 = Ops::shr1(Ops::add(absDiff(Ops::load(next + x + mrefs), c), absDiff(Ops::load(next + x + prefs), e)));
+
+        V diff = Ops::max(Ops::max(Ops::shr1(temporalDiff0), temporalDiff1), temporalDiff2);
+        V spatialPred = avg(c, e);
+        V spatialScore = Ops::sub(
+            Ops::add(Ops::add(absDiff(Ops::load(cur + mrefs - 1), Ops::load(cur + prefs - 1)), absDiff(c, e)), absDiff(Ops::load(cur + mrefs + 1), Ops::load(cur + prefs + 1))),
+            Ops::set1(1)
+        );
+
+        // Branchless version of nested "check<j>()" calls, "mask" is set where previous check succeeded
+        const auto check = [&](const int j, const V mask) {
+            const V score = Ops::add(
+                Ops::add(absDiff(Ops::load(cur + mrefs - 1 + j), Ops::load(cur + prefs - 1 - j)), absDiff(Ops::load(cur + mrefs + j), Ops::load(cur + prefs - j))),
+                absDiff(Ops::load(cur + mrefs + 1 + j), Ops::load(cur + prefs + 1 - j))
+            );
+            const V better = Ops::bitAnd(mask, Ops::lt(score, spatialScore));
+            spatialScore = Ops::select(better, score, spatialScore);
+            spatialPred = Ops::select(better, avg(Ops::load(cur + mrefs + j), Ops::load(cur + prefs - j)), spatialPred);
+            return better;
+        };
+        check(-2, check(-1, Ops::set1(-1)));
+        check(+2, check(+1, Ops::set1(-1)));
+
+        if (spatialCheck)
+        {
+            const V b = avg(Ops::load(prev2 + x + 2 * mrefs), Ops::load(next2 + x + 2 * mrefs));
+            const V f = avg(Ops::load(prev2 + x + 2 * prefs), Ops::load(next2 + x + 2 * prefs));
+            const V dc = Ops::sub(d, c);
+            const V de = Ops::sub(d, e);
+            const V bc = Ops::sub(b, c);
+            const V fe = Ops::sub(f, e);
+            const V maxVal = Ops::max(Ops::max(de, dc), Ops::min(bc, fe));
+            const V minVal = Ops::min(Ops::min(de, dc), Ops::max(bc, fe));
+            diff = Ops::max(Ops::max(diff, minVal), Ops::sub(Ops::set1(0), maxVal));
+        }
+
+        spatialPred = Ops::min(spatialPred, Ops::add(d, diff));
+        spatialPred = Ops::max(spatialPred, Ops::sub(d, diff));
+
+        Ops::store(dest + x, spatialPred);
+    }
+    return x;
+}
+
+#define YADIF_FILTER_LINE_SIMD_IMPL(name, Ops) \
+    int name(quint8 *dest, const int w, \
+             const quint8 *prev, const quint8 *curr, const quint8 *next, \
+             const qptrdiff prefs, const qptrdiff mrefs, \
+             const bool filterParity, const bool spatialCheck) \
+    { \
+        return spatialCheck \
+            ? yadifFilterLineSIMD<Ops, true>(dest, w, prev, curr, next, prefs, mrefs, filterParity) \
+            : yadifFilterLineSIMD<Ops, false>(dest, w, prev, curr, next, prefs, mrefs, filterParity) \
+        ; \
+    }
@@ -0,0 +1,86 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <YadifSIMD.hpp>
+
+#include <emmintrin.h>
+
+namespace {
+
+struct SSE2
+{
+    using V = __m128i;
+    static constexpr int N = 8;
+
+    static inline V load(const quint8 *p)
+    {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128());
+    }
+    static inline void store(quint8 *p, const V v)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(v, v));
+    }
+
+    static inline V set1(const short v)
+    {
+        return _mm_set1_epi16(v);
+    }
+
+    static inline V add(const V a, const V b)
+    {
+        return _mm_add_epi16(a, b);
+    }
+    static inline V sub(const V a, const V b)
+    {
+        return _mm_sub_epi16(a, b);
+    }
+    static inline V shr1(const V v)
+    {
+        return _mm_srai_epi16(v, 1);
+    }
+    static inline V abs(const V v)
+    {
+        return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+    }
+
+    static inline V min(const V a, const V b)
+    {
+        return _mm_min_epi16(a, b);
+    }
+    static inline V max(const V a, const V b)
+    {
+        return _mm_max_epi16(a, b);
+    }
+
+    static inline V lt(const V a, const V b)
+    {
+        return _mm_cmplt_epi16(a, b);
+    }
+    static inline V bitAnd(const V a, const V b)
+    {
+        return _mm_and_si128(a, b);
+    }
+    static inline V select(const V mask, const V a, const V b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+};
+
+}
+
+YADIF_FILTER_LINE_SIMD_IMPL(yadifFilterLineSSE2, SSE2)
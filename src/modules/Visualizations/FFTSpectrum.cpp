@@ -65,6 +65,8 @@ void FFTSpectrumW::paint(QPainter &p)
 {
     bool canStop = true;
 
+    fftSpectrum.processSoundData();
+
     auto getLimitedSize = [this](int limitFreq) {
         const int size = spectrumData.size();
         return qBound(1, qRound(size * 2.0 * limitFreq / srate), size);
@@ -151,18 +153,18 @@ void FFTSpectrumW::stop()
 /**/
 
 FFTSpectrum::FFTSpectrum(Module &module) :
-    w(*this), tmpDataSize(0), tmpDataPos(0), m_linearScale(false)
+    w(*this), tmpDataSize(0), m_linearScale(false)
 {
     SetModule(module);
 }
 
 void FFTSpectrum::soundBuffer(const bool enable)
 {
-    QMutexLocker mL(&mutex);
     const int arrSize = enable ? (1 << w.fftSize) : 0;
-    if (arrSize != tmpDataSize)
+    if (arrSize != tmpDataSize || m_samples.size() != static_cast<size_t>(arrSize * w.chn))
     {
-        tmpDataPos = 0;
+        m_lastWritePos = 0;
+        m_samples.clear();
         FFT::freeComplex(m_complex);
         m_winFunc.clear();
         w.spectrumData.clear();
@@ -177,7 +179,34 @@ void FFTSpectrum::soundBuffer(const bool enable)
                 m_winFunc[i] = 0.5f - 0.5f * cos(2.0f * static_cast<float>(M_PI) * i / (tmpDataSize - 1));
             w.spectrumData.resize(tmpDataSize / 2);
             w.lastData.resize(tmpDataSize / 2);
+            m_samples.resize(tmpDataSize * w.chn);
         }
+        // Twice the window size, so the reader has time to copy the samples
+        m_ringBuffer.setCapacity(m_samples.size() * 2);
+    }
+}
+void FFTSpectrum::processSoundData()
+{
+    if (!tmpDataSize || m_samples.empty())
+        return;
+
+    const quint64 writePos = m_ringBuffer.writePos();
+    if (writePos == m_lastWritePos || !m_ringBuffer.readLatest(m_samples.data(), m_samples.size()))
+        return;
+    m_lastWritePos = writePos;
+
+    fltmix(m_complex, m_winFunc.data(), m_samples.data(), m_samples.size(), w.chn);
+    m_fft.calc(m_complex);
+
+    const int size = tmpDataSize / 2;
+    float *spectrumData = w.spectrumData.data();
+    for (int i = 0; i < size; ++i)
+    {
+        spectrumData[i] = sqrt(m_complex[i].re * m_complex[i].re + m_complex[i].im * m_complex[i].im) / size;
+        if (m_linearScale)
+            spectrumData[i] *= 2.0f;
+        else
+            spectrumData[i] = qBound(0.0f, (20.0f * std::log10(spectrumData[i]) + 65.0f) / 59.0f, 1.0f);
     }
 }
 
@@ -239,40 +268,15 @@ void FFTSpectrum::sendSoundData(const QByteArray &data)
 {
     if (!w.tim.isActive() || !data.size())
         return;
-    QMutexLocker mL(&mutex);
-    if (!tmpDataSize)
-        return;
-    int newDataPos = 0;
-    while (newDataPos < data.size())
-    {
-        const int size = qMin((data.size() - newDataPos) / (int)sizeof(float), (tmpDataSize - tmpDataPos) * w.chn);
-        if (!size)
-            break;
-        fltmix(m_complex + tmpDataPos, m_winFunc.data() + tmpDataPos, (const float *)(data.constData() + newDataPos), size, w.chn);
-        newDataPos += size * sizeof(float);
-        tmpDataPos += size / w.chn;
-        if (tmpDataPos == tmpDataSize)
-        {
-            m_fft.calc(m_complex);
-            tmpDataPos /= 2;
-            float *spectrumData = w.spectrumData.data();
-            for (int i = 0; i < tmpDataPos; ++i)
-            {
-                spectrumData[i] = sqrt(m_complex[i].re * m_complex[i].re + m_complex[i].im * m_complex[i].im) / tmpDataPos;
-                if (m_linearScale)
-                    spectrumData[i] *= 2.0f;
-                else
-                    spectrumData[i] = qBound(0.0f, (20.0f * std::log10(spectrumData[i]) + 65.0f) / 59.0f, 1.0f);
-            }
-            tmpDataPos = 0;
-        }
-    }
+    // Called from the audio thread, the spectrum is computed when painting
+    m_ringBuffer.write(reinterpret_cast<const float *>(data.constData()), data.size() / sizeof(float));
 }
 void FFTSpectrum::clearSoundData()
 {
     if (w.tim.isActive())
     {
-        QMutexLocker mL(&mutex);
+        m_ringBuffer.clear();
+        m_lastWritePos = 0;
         w.spectrumData.fill(0.0f);
         w.stopped = true;
         w.update();
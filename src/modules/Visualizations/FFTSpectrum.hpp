@@ -19,6 +19,7 @@
 #pragma once
 
 #include <QMPlay2Extensions.hpp>
+#include <SoundRingBuffer.hpp>
 #include <VisWidget.hpp>
 #include <FFT.hpp>
 
@@ -60,6 +61,7 @@ public:
     FFTSpectrum(Module &);
 
     void soundBuffer(const bool);
+    void processSoundData();
 
     bool set() override;
 private:
@@ -78,9 +80,12 @@ private:
     FFT m_fft;
     FFT::Complex *m_complex = nullptr;
     std::vector<float> m_winFunc;
-    int tmpDataSize, tmpDataPos;
+    std::vector<float> m_samples;
+    int tmpDataSize;
     bool m_linearScale;
-    QMutex mutex;
+
+    SoundRingBuffer m_ringBuffer;
+    quint64 m_lastWritePos = 0;
 };
 
 #define FFTSpectrumName "Widmo FFT"
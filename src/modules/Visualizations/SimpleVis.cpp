@@ -34,11 +34,10 @@ static inline float fltclip(float f)
         f = 0.0f;
     return f;
 }
-static inline void fltcpy(float *dest, const float *src, int size)
+static inline void fltclip(float *data, int size)
 {
-    size /= sizeof(float);
     for (int i = 0; i < size; ++i)
-        dest[i] = fltclip(src[i]);
+        data[i] = fltclip(data[i]);
 }
 
 /**/
@@ -65,6 +64,8 @@ SimpleVisW::SimpleVisW(SimpleVis &simpleVis) :
 
 void SimpleVisW::paint(QPainter &p)
 {
+    simpleVis.processSoundData();
+
     const int size = soundData.size() / sizeof(float);
     if (size >= chn)
     {
@@ -156,22 +157,19 @@ void SimpleVisW::stop()
 /**/
 
 SimpleVis::SimpleVis(Module &module) :
-    w(*this), tmpDataPos(0)
+    w(*this)
 {
     SetModule(module);
 }
 
 void SimpleVis::soundBuffer(const bool enable)
 {
-    QMutexLocker mL(&mutex);
     const int arrSize = enable ? (ceil(sndLen * w.srate) * w.chn * sizeof(float)) : 0;
-    if (arrSize != tmpData.size() || arrSize != w.soundData.size())
+    if (arrSize != w.soundData.size())
     {
-        tmpDataPos = 0;
-        tmpData.clear();
+        m_lastWritePos = 0;
         if (arrSize)
         {
-            tmpData.resize(arrSize);
             const int oldSize = w.soundData.size();
             w.soundData.resize(arrSize);
             if (arrSize > oldSize)
@@ -179,8 +177,24 @@ void SimpleVis::soundBuffer(const bool enable)
         }
         else
             w.soundData.clear();
+        // Twice the displayed length, so the reader has time to copy the samples
+        m_ringBuffer.setCapacity(arrSize / sizeof(float) * 2);
     }
 }
+void SimpleVis::processSoundData()
+{
+    const int size = w.soundData.size() / sizeof(float);
+    if (size <= 0)
+        return;
+
+    const quint64 writePos = m_ringBuffer.writePos();
+    float *soundData = reinterpret_cast<float *>(w.soundData.data());
+    if (writePos == m_lastWritePos || !m_ringBuffer.readLatest(soundData, size))
+        return;
+    m_lastWritePos = writePos;
+
+    fltclip(soundData, size);
+}
 
 bool SimpleVis::set()
 {
@@ -232,28 +246,15 @@ void SimpleVis::sendSoundData(const QByteArray &data)
 {
     if (!w.tim.isActive() || !data.size())
         return;
-    QMutexLocker mL(&mutex);
-    if (!tmpData.size())
-        return;
-    int newDataPos = 0;
-    while (newDataPos < data.size())
-    {
-        const int size = qMin(data.size() - newDataPos, tmpData.size() - tmpDataPos);
-        fltcpy((float *)(tmpData.data() + tmpDataPos), (const float *)(data.constData() + newDataPos), size);
-        newDataPos += size;
-        tmpDataPos += size;
-        if (tmpDataPos == tmpData.size())
-        {
-            memcpy(w.soundData.data(), tmpData.constData(), tmpDataPos);
-            tmpDataPos = 0;
-        }
-    }
+    // Called from the audio thread, the samples are taken when painting
+    m_ringBuffer.write(reinterpret_cast<const float *>(data.constData()), data.size() / sizeof(float));
 }
 void SimpleVis::clearSoundData()
 {
     if (w.tim.isActive())
     {
-        QMutexLocker mL(&mutex);
+        m_ringBuffer.clear();
+        m_lastWritePos = 0;
         w.soundData.fill(0);
         w.stopped = true;
         w.update();
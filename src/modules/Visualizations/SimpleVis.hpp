@@ -19,6 +19,7 @@
 #pragma once
 
 #include <QMPlay2Extensions.hpp>
+#include <SoundRingBuffer.hpp>
 #include <VisWidget.hpp>
 
 #include <QCoreApplication>
@@ -60,6 +61,7 @@ public:
     SimpleVis(Module &);
 
     void soundBuffer(const bool);
+    void processSoundData();
 
     bool set() override;
 private:
@@ -75,9 +77,8 @@ private:
 
     SimpleVisW w;
 
-    QByteArray tmpData;
-    int tmpDataPos;
-    QMutex mutex;
+    SoundRingBuffer m_ringBuffer;
+    quint64 m_lastWritePos = 0;
     float sndLen;
 };
 
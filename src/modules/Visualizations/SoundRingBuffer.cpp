@@ -0,0 +1,89 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <SoundRingBuffer.hpp>
+
+#include <cstring>
+
+void SoundRingBuffer::setCapacity(int samples)
+{
+    QMutexLocker locker(&m_mutex);
+    if (static_cast<int>(m_data.size()) != samples)
+    {
+        m_data.assign(samples, 0.0f);
+        m_data.shrink_to_fit();
+    }
+    m_writePos.store(0, std::memory_order_release);
+}
+void SoundRingBuffer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_writePos.store(0, std::memory_order_release);
+}
+
+void SoundRingBuffer::write(const float *samples, int count)
+{
+    if (!m_mutex.tryLock())
+        return;
+
+    const int capacity = m_data.size();
+    if (capacity > 0)
+    {
+        if (count > capacity)
+        {
+            // Only the most recent samples can be read
+            samples += count - capacity;
+            count = capacity;
+        }
+
+        const quint64 writePos = m_writePos.load(std::memory_order_relaxed);
+        const int pos = writePos % capacity;
+        const int firstPart = qMin(count, capacity - pos);
+        memcpy(m_data.data() + pos, samples, firstPart * sizeof(float));
+        memcpy(m_data.data(), samples + firstPart, (count - firstPart) * sizeof(float));
+
+        m_writePos.store(writePos + count, std::memory_order_release);
+    }
+
+    m_mutex.unlock();
+}
+
+bool SoundRingBuffer::readLatest(float *samples, int count) const
+{
+    const int capacity = m_data.size();
+    if (count <= 0 || count > capacity / 2)
+        return false;
+
+    // Retry if the producer has overwritten the samples during copying
+    for (int tries = 0; tries < 3; ++tries)
+    {
+        const quint64 writePos = m_writePos.load(std::memory_order_acquire);
+        if (writePos < static_cast<quint64>(count))
+            return false;
+
+        const int pos = (writePos - count) % capacity;
+        const int firstPart = qMin(count, capacity - pos);
+        memcpy(samples, m_data.data() + pos, firstPart * sizeof(float));
+        memcpy(samples + firstPart, m_data.data(), (count - firstPart) * sizeof(float));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_writePos.load(std::memory_order_relaxed) - writePos <= static_cast<quint64>(capacity - count))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QMutex>
+
+#include <atomic>
+#include <vector>
+
+/*
+ * Single producer, single consumer ring buffer of interleaved samples.
+ * The audio thread writes samples without blocking, the GUI thread reads
+ * the most recent samples when the visualization is repainted.
+ */
+class SoundRingBuffer
+{
+    Q_DISABLE_COPY(SoundRingBuffer)
+
+public:
+    SoundRingBuffer() = default;
+
+    // Not real-time safe, must be called from the consumer thread
+    void setCapacity(int samples);
+    void clear();
+
+    // Producer - never blocks, samples are dropped only while the buffer is being reconfigured
+    void write(const float *samples, int count);
+
+    // Consumer - copies "count" most recent samples, returns "false" if there is not enough samples
+    bool readLatest(float *samples, int count) const;
+
+    inline quint64 writePos() const
+    {
+        return m_writePos.load(std::memory_order_acquire);
+    }
+
+private:
+    QMutex m_mutex; // Protects the buffer from being reconfigured during writing
+    std::vector<float> m_data;
+    std::atomic<quint64> m_writePos {0};
+};
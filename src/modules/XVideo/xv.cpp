@@ -175,7 +175,7 @@ void XVIDEO::open(int W, int H, unsigned long _handle, const QString &adaptorNam
     if (!image)
         return close();
 
-    osdImg = QImage(image->width, image->height, QImage::Format_ARGB32);
+    osdImg = QImage(image->width, image->height, QImage::Format_ARGB32_Premultiplied);
     osdImg.fill(0);
 
     _isOpen = true;
@@ -0,0 +1,194 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <AsyncStreamMuxer.hpp>
+
+#include <StreamMuxer.hpp>
+#include <Packet.hpp>
+
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QThread>
+#include <QMutex>
+
+#include <unordered_set>
+#include <atomic>
+#include <memory>
+#include <deque>
+
+// Data is stored on the disk periodically, so the system doesn't accumulate a lot of dirty pages
+constexpr qint64 g_syncBytes = 32 * 1024 * 1024;
+constexpr qint64 g_syncInterval = 5000;
+
+using namespace std;
+
+// Waits for writing threads of destroyed muxers, it also waits for them on exit
+static QThreadPool &finishersThreadPool()
+{
+    static QThreadPool threadPool;
+    static const bool initialized = [] {
+        threadPool.setObjectName("AsyncStreamMuxerFinishers");
+        return true;
+    }();
+    Q_UNUSED(initialized)
+    return threadPool;
+}
+
+struct AsyncStreamMuxer::Priv
+{
+    void run();
+
+    unique_ptr<StreamMuxer> muxer;
+    unique_ptr<QThread> thread;
+
+    QMutex mutex;
+    QWaitCondition cond;
+    deque<pair<Packet, int>> queue;
+    qint64 queuedBytes = 0;
+    qint64 maxQueuedBytes = 0;
+    bool finish = false;
+
+    unordered_set<int> waitForKeyFrame; // Used only by the caller thread
+    atomic<quint64> droppedPackets {0};
+    atomic_bool error {false};
+};
+
+void AsyncStreamMuxer::Priv::run()
+{
+    deque<pair<Packet, int>> batch;
+    qint64 unsyncedBytes = 0;
+    QElapsedTimer syncTimer;
+    syncTimer.start();
+
+    for (;;)
+    {
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.empty() && !finish)
+                cond.wait(&mutex);
+            if (queue.empty())
+                break;
+            batch.swap(queue);
+        }
+
+        qint64 batchBytes = 0;
+        for (auto &&[packet, idx] : batch)
+        {
+            if (!error && !muxer->write(packet, idx))
+                error = true;
+            batchBytes += packet.size();
+        }
+        batch.clear();
+
+        unsyncedBytes += batchBytes;
+        if (!error && (unsyncedBytes >= g_syncBytes || syncTimer.elapsed() >= g_syncInterval))
+        {
+            if (!muxer->flush(true))
+                error = true;
+            unsyncedBytes = 0;
+            syncTimer.restart();
+        }
+
+        QMutexLocker locker(&mutex);
+        queuedBytes -= batchBytes;
+    }
+
+    muxer.reset(); // Writes the trailer
+}
+
+AsyncStreamMuxer::AsyncStreamMuxer(const QString &fileName, const QList<StreamInfo *> &streamsInfo, const QString &format, bool streamRecording, qint64 maxQueuedBytes)
+    : p(*new Priv)
+{
+    p.maxQueuedBytes = maxQueuedBytes;
+    p.muxer = make_unique<StreamMuxer>(fileName, streamsInfo, format, streamRecording);
+    if (p.muxer->isOk())
+    {
+        p.thread.reset(QThread::create([this] {
+            p.run();
+        }));
+        p.thread->setObjectName("AsyncStreamMuxer");
+        p.thread->start();
+    }
+}
+AsyncStreamMuxer::~AsyncStreamMuxer()
+{
+    if (!p.thread)
+    {
+        delete &p;
+        return;
+    }
+
+    {
+        QMutexLocker locker(&p.mutex);
+        p.finish = true;
+        p.cond.wakeOne();
+    }
+
+    // Draining the queue and writing the trailer can take long on slow output
+    finishersThreadPool().start([priv = &p] {
+        priv->thread->wait();
+        delete priv;
+    });
+}
+
+bool AsyncStreamMuxer::isOk() const
+{
+    return p.thread && !p.error;
+}
+
+bool AsyncStreamMuxer::setFirstDts(const Packet &packet, const int idx)
+{
+    QMutexLocker locker(&p.mutex);
+    Q_ASSERT(p.queue.empty());
+    return p.muxer && p.muxer->setFirstDts(packet, idx);
+}
+
+bool AsyncStreamMuxer::write(const Packet &packet, const int idx)
+{
+    if (p.error)
+        return false;
+
+    if (p.waitForKeyFrame.count(idx) > 0)
+    {
+        if (!packet.hasKeyFrame())
+        {
+            ++p.droppedPackets;
+            return true;
+        }
+        p.waitForKeyFrame.erase(idx);
+    }
+
+    QMutexLocker locker(&p.mutex);
+    if (p.queuedBytes + packet.size() > p.maxQueuedBytes)
+    {
+        // Output is too slow, don't block the caller
+        ++p.droppedPackets;
+        p.waitForKeyFrame.insert(idx);
+        return true;
+    }
+    p.queue.emplace_back(packet, idx);
+    p.queuedBytes += packet.size();
+    p.cond.wakeOne();
+    return true;
+}
+
+quint64 AsyncStreamMuxer::droppedPackets() const
+{
+    return p.droppedPackets;
+}
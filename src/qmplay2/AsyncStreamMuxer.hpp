@@ -0,0 +1,53 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QMPlay2Lib.hpp>
+
+#include <QList>
+
+class StreamInfo;
+class Packet;
+
+/*
+ * Writes packets using "StreamMuxer" in a dedicated thread, so slow output never blocks the caller.
+ * Queued packets share data with the caller. If the queue is full, packets are dropped and the
+ * affected stream continues from the next key frame.
+ */
+class QMPLAY2SHAREDLIB_EXPORT AsyncStreamMuxer
+{
+    struct Priv;
+
+    AsyncStreamMuxer(const AsyncStreamMuxer &) = delete;
+    AsyncStreamMuxer &operator =(const AsyncStreamMuxer &) = delete;
+
+public:
+    AsyncStreamMuxer(const QString &fileName, const QList<StreamInfo *> &streamsInfo, const QString &format, bool streamRecording = false, qint64 maxQueuedBytes = 64 * 1024 * 1024);
+    ~AsyncStreamMuxer(); // Doesn't block, remaining queued packets and the trailer are written in background
+
+    bool isOk() const; // Returns "false" also after write error
+
+    bool setFirstDts(const Packet &packet, const int idx); // Must be called before "write()"
+    bool write(const Packet &packet, const int idx); // Doesn't block, returns "false" after write error
+
+    quint64 droppedPackets() const;
+
+private:
+    Priv &p;
+};
@@ -171,6 +171,11 @@ QList<QByteArray> Decoder::decodeSubtitle(const Packet &encodedPacket)
     return {};
 }
 
+void Decoder::setKeyFramesOnly(bool keyFramesOnly)
+{
+    Q_UNUSED(keyFramesOnly)
+}
+
 int Decoder::pendingFrames() const
 {
     return 0;
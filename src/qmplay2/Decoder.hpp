@@ -56,6 +56,8 @@ public:
      * hurry_up == ~0 -> much faster decoding, no frame copying
     */
     virtual int decodeVideo(const Packet &encodedPacket, Frame &decoded, AVPixelFormat &newPixFmt, bool flush, unsigned hurry_up);
+    // Used for scrubbing, decoder should decode and output key frames as soon as possible
+    virtual void setKeyFramesOnly(bool keyFramesOnly);
     virtual int decodeAudio(const Packet &encodedPacket, QByteArray &decoded, double &ts, quint8 &channels, quint32 &sampleRate, bool flush = false);
     virtual bool decodeSubtitle(const QVector<Packet> &encodedPackets, double pos, std::shared_ptr<QMPlay2OSD> &osd, const QSize &size, bool flush = false);
     virtual QList<QByteArray> decodeSubtitle(const Packet &encodedPacket);
@@ -20,6 +20,7 @@
 
 #include <QMPlay2Extensions.hpp>
 #include <QMPlay2OSD.hpp>
+#include <OSDBlend.hpp>
 #include <Frame.hpp>
 #include <Version.hpp>
 #include <Reader.hpp>
@@ -426,7 +427,7 @@ void Functions::paintOSD(bool rgbSwapped, const QMPlay2OSDList &osd_list, const
                 (const uchar *)img.rgba.constData(),
                 img.size.width(),
                 img.size.height(),
-                rgbSwapped ? QImage::Format_RGBA8888 : QImage::Format_ARGB32
+                rgbSwapped ? QImage::Format_RGBA8888_Premultiplied : QImage::Format_ARGB32_Premultiplied
             );
             if (osd->needsRescale())
             {
@@ -450,6 +451,16 @@ void Functions::paintOSDtoYV12(quint8 *imageData, QImage &osdImg, int W, int H,
     const qreal scaleW = (qreal)W / osdW, scaleH = (qreal)H / imgH;
     const bool mustRepaint = Functions::mustRepaintOSD(osd_list, osd_ids, &scaleW, &scaleH, &bounds);
     bounds = QRect(floor(bounds.x() * iScaleW), floor(bounds.y() * iScaleH), ceil(bounds.width() * iScaleW), ceil(bounds.height() * iScaleH)) & QRect(0, 0, osdW, imgH);
+    if (bounds.isEmpty())
+        return;
+
+    // Chroma is blended from whole 2x2 pixel blocks
+    bounds.setLeft(bounds.left() & ~1);
+    bounds.setTop(bounds.top() & ~1);
+    bounds.setRight(qMin(bounds.right() | 1, osdW - 1));
+    bounds.setBottom(qMin(bounds.bottom() | 1, imgH - 1));
+
+    // "osdImg" must be premultiplied
     quint32 *osdImgData = (quint32 *)osdImg.constBits();
     if (mustRepaint)
     {
@@ -466,48 +477,29 @@ void Functions::paintOSDtoYV12(quint8 *imageData, QImage &osdImg, int W, int H,
     data[2] = data[0] + linesizeLuma * imgH;
     data[1] = data[2] + linesizeChroma * (imgH >> 1);
 
-    for (int h = bounds.top(); h <= bounds.bottom(); ++h)
+    const auto &kernels = OSDBlend::kernels();
+    const int x = bounds.left();
+    const int w = bounds.width();
+    const int chromaW = w >> 1;
+
+    for (int h = bounds.top(); h <= bounds.bottom(); h += 2)
     {
-        const int fullLine = h * linesizeLuma;
-        const int halfLine = (h >> 1) * linesizeChroma;
-        const int line = h * osdW;
+        const quint32 *src0 = osdImgData + h * osdW + x;
+        const quint32 *src1 = (h < bounds.bottom()) ? src0 + osdW : src0;
 
-        for (int w = bounds.left(); w <= bounds.right(); ++w)
-        {
-            const int pixelPos = fullLine + w;
-            const quint32 pixel = osdImgData[line + w];
-            const quint8 A = (pixel >> 24) & 0xFF;
-            if (A)
-            {
-                const quint8 iA = ~A & 0xFF;
-                const quint8  B = (pixel >> 16) & 0xFF;
-                const quint8  G = (pixel >> 8) & 0xFF;
-                const quint8  R = pixel & 0xFF;
-
-                const quint8 Y = ((R * 66) >> 8) + (G >> 1) + ((B * 25) >> 8) + 16;
-                if (A == 0xFF)
-                    data[0][pixelPos] = Y;
-                else
-                    data[0][pixelPos] = data[0][fullLine + w] * iA / 255 + Y * A / 255;
+        kernels.blendLuma(data[0] + h * linesizeLuma + x, src0, w);
+        if (src1 != src0)
+            kernels.blendLuma(data[0] + (h + 1) * linesizeLuma + x, src1, w);
 
-                if (!(w & 1) && !(h & 1))
-                {
-                    const int pixelPos = halfLine + (w >> 1);
-                    const quint8 cB = -((R * 38 ) >> 8) - ((G * 74) >> 8) + ((B * 112) >> 8) + 128;
-                    const quint8 cR =  ((R * 112) >> 8) - ((G * 94) >> 8) - ((B * 18 ) >> 8) + 128;
-                    if (A == 0xFF)
-                    {
-                        data[1][pixelPos] = cB;
-                        data[2][pixelPos] = cR;
-                    }
-                    else
-                    {
-                        const int pixelPosAlpha = halfLine + (w >> 1);
-                        data[1][pixelPos] = data[1][pixelPosAlpha] * iA / 255 + cB * A / 255;
-                        data[2][pixelPos] = data[2][pixelPosAlpha] * iA / 255 + cR * A / 255;
-                    }
-                }
-            }
+        quint8 *dstU = data[1] + (h >> 1) * linesizeChroma + (x >> 1);
+        quint8 *dstV = data[2] + (h >> 1) * linesizeChroma + (x >> 1);
+        kernels.blendChroma(dstU, dstV, src0, src1, chromaW);
+        if (w & 1)
+        {
+            // The last column of odd width image
+            const quint32 last0[2] = {src0[w - 1], src0[w - 1]};
+            const quint32 last1[2] = {src1[w - 1], src1[w - 1]};
+            kernels.blendChroma(dstU + chromaW, dstV + chromaW, last0, last1, 1);
         }
     }
 }
@@ -27,14 +27,21 @@
 extern "C"
 {
     #include <libswscale/swscale.h>
+    #include <libavutil/pixdesc.h>
+    #include <libavutil/frame.h>
+    #include <libavutil/opt.h>
 }
 
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 4, 100)
+#   define SWS_HAS_THREADS
+#endif
+
 ImgScaler::ImgScaler() :
     m_swsCtx(nullptr),
     m_srcH(0), m_dstLinesize(0)
 {}
 
-bool ImgScaler::create(const Frame &videoFrame, int newWdst, int newHdst)
+bool ImgScaler::create(const Frame &videoFrame, int newWdst, int newHdst, int threads)
 {
     if (videoFrame.isEmpty())
         return false;
@@ -43,38 +50,89 @@ bool ImgScaler::create(const Frame &videoFrame, int newWdst, int newHdst)
         newWdst = videoFrame.width();
     if (newHdst < 0)
         newHdst = videoFrame.height();
+#ifndef SWS_HAS_THREADS
+    threads = 1;
+#endif
+
+    if (m_swsCtx && m_threads == threads && m_srcW == videoFrame.width() && m_srcH == videoFrame.height() && m_srcFormat == videoFrame.pixelFormat() && m_dstW == newWdst && m_dstH == newHdst)
+        return true;
+
+    destroy();
+
+    m_srcW = videoFrame.width();
     m_srcH = videoFrame.height();
+    m_srcFormat = videoFrame.pixelFormat();
+    m_dstW = newWdst;
+    m_dstH = newHdst;
     m_dstLinesize = newWdst << 2;
-    m_swsCtx = sws_getCachedContext(
-        m_swsCtx,
-        videoFrame.width(),
-        m_srcH,
-        videoFrame.pixelFormat(),
-        newWdst,
-        newHdst,
-        AV_PIX_FMT_RGB32,
-        SWS_BILINEAR,
-        nullptr,
-        nullptr,
-        nullptr
-    );
-    return (bool)m_swsCtx;
+    m_threads = threads;
+
+#ifdef SWS_HAS_THREADS
+    if (threads > 1)
+    {
+        // Multi-threaded scaling is available only via "sws_scale_frame()"
+        m_swsCtx = sws_alloc_context();
+        if (!m_swsCtx)
+            return false;
+        av_opt_set_int(m_swsCtx, "srcw", m_srcW, 0);
+        av_opt_set_int(m_swsCtx, "srch", m_srcH, 0);
+        av_opt_set_int(m_swsCtx, "src_format", m_srcFormat, 0);
+        av_opt_set_int(m_swsCtx, "dstw", m_dstW, 0);
+        av_opt_set_int(m_swsCtx, "dsth", m_dstH, 0);
+        av_opt_set_int(m_swsCtx, "dst_format", AV_PIX_FMT_RGB32, 0);
+        av_opt_set_int(m_swsCtx, "sws_flags", SWS_BILINEAR, 0);
+        av_opt_set_int(m_swsCtx, "threads", threads, 0);
+        if (sws_init_context(m_swsCtx, nullptr, nullptr) < 0)
+        {
+            destroy();
+            return false;
+        }
+        m_srcFrame = av_frame_alloc();
+        m_dstFrame = av_frame_alloc();
+    }
+    else
+#endif
+    {
+        m_swsCtx = sws_getContext(
+            m_srcW,
+            m_srcH,
+            static_cast<AVPixelFormat>(m_srcFormat),
+            m_dstW,
+            m_dstH,
+            AV_PIX_FMT_RGB32,
+            SWS_BILINEAR,
+            nullptr,
+            nullptr,
+            nullptr
+        );
+        if (!m_swsCtx)
+            return false;
+    }
+
+    if (m_contrast != 100 || m_brightness != 0)
+        m_eqOK = applyEQ();
+
+    return true;
 }
-bool ImgScaler::scale(const Frame &src, void *dst)
+bool ImgScaler::scale(const Frame &src, void *dst, bool vFlip)
 {
     const int numPlanes = src.numPlanes();
-    const uint8_t *srcData[3] = {};
+    const uint8_t *srcData[4] = {};
 
-    auto swsScale = [&](int *srcLinesize) {
-        sws_scale(m_swsCtx, srcData, srcLinesize, 0, m_srcH, (uint8_t **)&dst, &m_dstLinesize);
-    };
+    uint8_t *dstData = reinterpret_cast<uint8_t *>(dst);
+    int dstLinesize = m_dstLinesize;
+    if (vFlip)
+    {
+        dstData += (m_dstH - 1) * dstLinesize;
+        dstLinesize = -dstLinesize;
+    }
 
     if (src.hasCPUAccess())
     {
         for (int i = 0; i < numPlanes; ++i)
             srcData[i] = src.constData(i);
 
-        swsScale(src.linesize());
+        swsScale(srcData, src.linesize(), dstData, dstLinesize);
         return true;
     }
 #ifdef USE_VULKAN
@@ -89,11 +147,11 @@ bool ImgScaler::scale(const Frame &src, void *dst)
         for (int i = 0; i < numPlanes; ++i)
             srcData[i] = hostVkImage->map<uint8_t>(i);
 
-        int srcLinesize[3] = {};
+        int srcLinesize[4] = {};
         for (int i = 0; i < numPlanes; ++i)
             srcLinesize[i] = hostVkImage->linesize(i);
 
-        swsScale(srcLinesize);
+        swsScale(srcData, srcLinesize, dstData, dstLinesize);
         return true;
     }
     catch (const vk::SystemError &e)
@@ -105,7 +163,7 @@ bool ImgScaler::scale(const Frame &src, void *dst)
 }
 void ImgScaler::scale(const void *src[], const int srcLinesize[], void *dst)
 {
-    sws_scale(m_swsCtx, (const uint8_t **)src, srcLinesize, 0, m_srcH, (uint8_t **)&dst, &m_dstLinesize);
+    swsScale(reinterpret_cast<const uint8_t *const *>(src), srcLinesize, reinterpret_cast<uint8_t *>(dst), m_dstLinesize);
 }
 void ImgScaler::destroy()
 {
@@ -114,4 +172,74 @@ void ImgScaler::destroy()
         sws_freeContext(m_swsCtx);
         m_swsCtx = nullptr;
     }
+    av_frame_free(&m_srcFrame);
+    av_frame_free(&m_dstFrame);
+}
+
+bool ImgScaler::setEQ(int contrast, int brightness)
+{
+    if (m_contrast != contrast || m_brightness != brightness)
+    {
+        m_contrast = contrast;
+        m_brightness = brightness;
+        m_eqOK = applyEQ();
+    }
+    return m_eqOK;
+}
+
+bool ImgScaler::applyEQ()
+{
+    if (!m_swsCtx)
+        return true;
+
+    int *invTable = nullptr, *table = nullptr;
+    int srcRange = 0, dstRange = 0;
+    int brightness = 0, contrast = 0, saturation = 0;
+    if (sws_getColorspaceDetails(m_swsCtx, &invTable, &srcRange, &table, &dstRange, &brightness, &contrast, &saturation) < 0)
+        return false;
+
+    // swscale applies contrast around black, compensate it to match "Functions::ImageEQ()" which uses the middle gray
+    const int offset = m_brightness + 127 * (100 - m_contrast) / 100;
+    brightness = offset * 256;
+    contrast = (m_contrast << 16) / 100;
+
+    return (sws_setColorspaceDetails(m_swsCtx, invTable, srcRange, table, dstRange, brightness, contrast, saturation) >= 0);
+}
+
+void ImgScaler::swsScale(const uint8_t *const srcData[], const int srcLinesize[], uint8_t *dst, int dstLinesize)
+{
+#ifdef SWS_HAS_THREADS
+    if (m_srcFrame && m_dstFrame)
+    {
+        // The frames are not reference counted, so use dummy buffers to prevent "sws_scale_frame()" from
+        // allocating and copying them. The data is owned by the caller and it's valid during scaling.
+        static uint8_t dummy;
+        const auto wrap = [](AVFrame *frame, int w, int h, int format) {
+            frame->width = w;
+            frame->height = h;
+            frame->format = format;
+            frame->buf[0] = av_buffer_create(&dummy, 1, [](void *, uint8_t *) {}, nullptr, AV_BUFFER_FLAG_READONLY);
+        };
+
+        wrap(m_srcFrame, m_srcW, m_srcH, m_srcFormat);
+        const int numPlanes = av_pix_fmt_count_planes(static_cast<AVPixelFormat>(m_srcFormat));
+        for (int i = 0; i < numPlanes; ++i)
+        {
+            m_srcFrame->data[i] = const_cast<uint8_t *>(srcData[i]);
+            m_srcFrame->linesize[i] = srcLinesize[i];
+        }
+
+        wrap(m_dstFrame, m_dstW, m_dstH, AV_PIX_FMT_RGB32);
+        m_dstFrame->data[0] = dst;
+        m_dstFrame->linesize[0] = dstLinesize;
+
+        if (m_srcFrame->buf[0] && m_dstFrame->buf[0])
+            sws_scale_frame(m_swsCtx, m_dstFrame, m_srcFrame);
+
+        av_frame_unref(m_srcFrame);
+        av_frame_unref(m_dstFrame);
+        return;
+    }
+#endif
+    sws_scale(m_swsCtx, srcData, srcLinesize, 0, m_srcH, &dst, &dstLinesize);
 }
@@ -20,9 +20,12 @@
 
 #include <QMPlay2Lib.hpp>
 
+#include <cstdint>
+
 /* YUV planar to RGB32 */
 
 struct SwsContext;
+struct AVFrame;
 class Frame;
 
 class QMPLAY2SHAREDLIB_EXPORT ImgScaler
@@ -34,11 +37,24 @@ public:
         destroy();
     }
 
-    bool create(const Frame &videoFrame, int newWdst = -1, int newHdst = -1);
-    bool scale(const Frame &videoFrame, void *dst = nullptr);
+    // "threads" > 1 uses multi-threaded swscale if available
+    bool create(const Frame &videoFrame, int newWdst = -1, int newHdst = -1, int threads = 1);
+    bool scale(const Frame &videoFrame, void *dst = nullptr, bool vFlip = false);
     void scale(const void *src[], const int srcLinesize[], void *dst);
     void destroy();
+
+    // The same parameters as in "Functions::ImageEQ()", applied during YUV to RGB conversion
+    bool setEQ(int contrast, int brightness);
+
 private:
+    bool applyEQ();
+    void swsScale(const uint8_t *const srcData[], const int srcLinesize[], uint8_t *dst, int dstLinesize);
+
     SwsContext *m_swsCtx;
-    int m_srcH, m_dstLinesize;
+    AVFrame *m_srcFrame = nullptr, *m_dstFrame = nullptr;
+    int m_srcW = 0, m_srcH, m_srcFormat = -1;
+    int m_dstW = 0, m_dstH = 0, m_dstLinesize;
+    int m_threads = 1;
+    int m_contrast = 100, m_brightness = 0;
+    bool m_eqOK = true;
 };
@@ -22,6 +22,7 @@
 
 #include <QMPlay2OSD.hpp>
 #include <Functions.hpp>
+#include <OSDBlend.hpp>
 #include <Settings.hpp>
 
 #include <QColor>
@@ -30,6 +31,7 @@ extern "C" {
 #include <ass/ass.h>
 }
 
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 
@@ -189,6 +191,7 @@ bool LibASS::addImgs(ass_image *img, QMPlay2OSD *osd)
     }
 #endif
 
+    const auto &kernels = OSDBlend::kernels();
     while (img)
     {
         auto &osdImg = osd->add();
@@ -196,19 +199,15 @@ bool LibASS::addImgs(ass_image *img, QMPlay2OSD *osd)
         osdImg.size = QSize(img->w, img->h);
         osdImg.rgba = QByteArray(img->w * img->h * sizeof(uint32_t), Qt::Uninitialized);
 
-        const quint8 r = img->color >> 24;
-        const quint8 g = img->color >> 16;
-        const quint8 b = img->color >>  8;
-        const quint8 a = ~img->color & 0xFF;
+        const quint32 r = img->color >> 24;
+        const quint32 g = (img->color >> 16) & 0xFF;
+        const quint32 b = (img->color >>  8) & 0xFF;
+        const quint32 a = ~img->color & 0xFF;
+        const quint32 color = a << 24 | b << 16 | g << 8 | r;
 
-        auto data = reinterpret_cast<uint32_t *>(osdImg.rgba.data());
+        auto data = reinterpret_cast<quint32 *>(osdImg.rgba.data());
         for (int y = 0; y < img->h; y++)
-        {
-            const int offsetI = y * img->stride;
-            const int offsetB = y * img->w;
-            for (int x = 0; x < img->w; x++)
-                data[offsetB + x] = (a * img->bitmap[offsetI + x] / 0xFF) << 24 | b << 16 | g << 8 | r;
-        }
+            kernels.expandAlpha(data + y * img->w, img->bitmap + y * img->stride, img->w, color);
 
         img = img->next;
     }
@@ -218,6 +217,7 @@ bool LibASS::addImgs(ass_image *img, QMPlay2OSD *osd)
 
 void LibASS::setWindowSize(const QSize &winSize)
 {
+    ++m_generation;
     const qreal dpr = QMPlay2Core.getVideoDevicePixelRatio();
     winW = winSize.width() * dpr;
     winH = winSize.height() * dpr;
@@ -225,22 +225,28 @@ void LibASS::setWindowSize(const QSize &winSize)
 }
 void LibASS::setARatio(double _aspect_ratio)
 {
+    ++m_generation;
     aspect_ratio = _aspect_ratio;
     calcSize();
 }
 void LibASS::setZoom(double _zoom)
 {
+    ++m_generation;
     zoom = _zoom;
     calcSize();
 }
 void LibASS::setFontScale(double fs)
 {
+    ++m_generation;
     fontScale = fs;
 }
 
 void LibASS::addFont(const QByteArray &name, const QByteArray &data)
 {
+    ++m_generation;
     ass_add_font(m_subsAss, (char *)name.constData(), (char *)data.constData(), data.size());
+    m_fonts.append({name, data});
+    ++m_fontsGeneration;
 }
 
 void LibASS::initOSD()
@@ -314,10 +320,13 @@ void LibASS::closeOSD()
 
 void LibASS::initASS(const QByteArray &ass_data)
 {
+    ++m_generation;
     if (ass_sub_track && ass_sub_renderer)
         return;
 
     ass_sub_track = ass_new_track(m_subsAss);
+    resetASSEventsIndex();
+    ++m_stylesGeneration;
     if (!ass_data.isEmpty())
     {
         ass_process_codec_private(ass_sub_track, (char *)ass_data.constData(), ass_data.size());
@@ -343,6 +352,8 @@ bool LibASS::isASS() const
 }
 void LibASS::setASSStyle()
 {
+    ++m_generation;
+    ++m_stylesGeneration;
     if (!ass_sub_track)
         return;
 
@@ -455,12 +466,14 @@ void LibASS::setASSStyle()
 }
 void LibASS::addASSEvent(const QByteArray &event)
 {
+    ++m_generation;
     if (!ass_sub_track || !ass_sub_renderer || event.isEmpty())
         return;
     ass_process_data(ass_sub_track, (char *)event.constData(), event.size());
 }
 void LibASS::addASSEvents(const QList<QByteArray> &events, double start, double duration)
 {
+    ++m_generation;
     if (!ass_sub_track || !ass_sub_renderer || events.isEmpty())
         return;
 
@@ -471,6 +484,7 @@ void LibASS::addASSEvents(const QList<QByteArray> &events, double start, double
 }
 void LibASS::addASSEvent(const QByteArray &text, double Start, double Duration)
 {
+    ++m_generation;
     if (!ass_sub_track || !ass_sub_renderer || text.isEmpty() || Start < 0 || Duration < 0)
         return;
     int eventID = ass_alloc_event(ass_sub_track);
@@ -483,9 +497,11 @@ void LibASS::addASSEvent(const QByteArray &text, double Start, double Duration)
 }
 void LibASS::flushASSEvents()
 {
+    ++m_generation;
     if (!ass_sub_track || !ass_sub_renderer)
         return;
     ass_flush_events(ass_sub_track);
+    resetASSEventsIndex();
 }
 bool LibASS::getASS(shared_ptr<QMPlay2OSD> &osd, double pos)
 {
@@ -497,46 +513,10 @@ bool LibASS::getASS(shared_ptr<QMPlay2OSD> &osd, double pos)
     if (qIsNaN(pos))
         return false;
 
-    double _fontScale = fontScale;
-
-    if (_fontScale != 1.0)
-    {
-        for (int i = 0; i < ass_sub_track->n_styles; i++)
-        {
-            ASS_Style &style = ass_sub_track->styles[i];
-            style.ScaleX  *= _fontScale;
-            style.ScaleY  *= _fontScale;
-            style.Shadow  *= _fontScale;
-            style.Outline *= _fontScale;
-        }
-    }
-
-    ass_set_frame_size(ass_sub_renderer, W, H);
-
-    const int marginLR = qMax(0, W / 2 - winW / 2);
-    const int marginTB = qMax(0, H / 2 - winH / 2);
-    ass_set_margins(ass_sub_renderer, marginTB, marginTB, marginLR, marginLR);
-
-    int ch;
-    ASS_Image *img = ass_render_frame(ass_sub_renderer, ass_sub_track, pos * 1000, &ch);
+    ASS_Image *img = renderFrame(pos);
 
     m_lastPos = pos;
 
-    if (ch)
-        m_assIDs.clear();
-
-    if (_fontScale != 1.0)
-    {
-        for (int i = 0; i < ass_sub_track->n_styles; i++)
-        {
-            ASS_Style &style = ass_sub_track->styles[i];
-            style.ScaleX  /= _fontScale;
-            style.ScaleY  /= _fontScale;
-            style.Shadow  /= _fontScale;
-            style.Outline /= _fontScale;
-        }
-    }
-
     if (!img)
         return false;
 
@@ -557,8 +537,130 @@ bool LibASS::getASS(shared_ptr<QMPlay2OSD> &osd, double pos)
     }
     return true;
 }
+bool LibASS::copyASS(LibASS &dst, double pos)
+{
+    if (!ass_sub_track || !ass_sub_renderer || !W || !H)
+        return false;
+
+    if (dst.m_fontsGeneration != m_fontsGeneration)
+    {
+        ass_clear_fonts(dst.m_subsAss);
+        for (auto &&font : m_fonts)
+            ass_add_font(dst.m_subsAss, (char *)font.first.constData(), (char *)font.second.constData(), font.second.size());
+        dst.m_fontsGeneration = m_fontsGeneration;
+        dst.m_setFonts = true;
+    }
+
+    if (!dst.ass_sub_track || dst.m_stylesGeneration != m_stylesGeneration)
+    {
+        copyASSStyles(dst);
+        dst.m_stylesGeneration = m_stylesGeneration;
+        dst.m_eventsGeneration = m_eventsGeneration;
+    }
+    else if (dst.m_eventsGeneration != m_eventsGeneration)
+    {
+        ass_flush_events(dst.ass_sub_track);
+        dst.m_eventsGeneration = m_eventsGeneration;
+    }
+
+    indexASSEvents();
+
+    // Only events which start in the window of the longest event can be visible
+    const long long posMs = pos * 1000;
+    std::set<int> visible; // ReadOrder
+    std::vector<const ASS_Event *> visibleEvents;
+    auto it = std::lower_bound(m_eventsByStart.cbegin(), m_eventsByStart.cend(), posMs - m_maxEventDuration, [](const std::pair<long long, int> &entry, long long start) {
+        return entry.first < start;
+    });
+    for (; it != m_eventsByStart.cend() && it->first <= posMs; ++it)
+    {
+        const ASS_Event &event = ass_sub_track->events[it->second];
+        if (posMs < event.Start + event.Duration && visible.insert(event.ReadOrder).second)
+            visibleEvents.push_back(&event);
+    }
+
+    // Keep visible events with their rendering state, remove the others
+    ASS_Track *track = dst.ass_sub_track;
+    std::set<int> existing; // ReadOrder
+    int nEvents = 0;
+    for (int i = 0; i < track->n_events; ++i)
+    {
+        const int readOrder = track->events[i].ReadOrder;
+        if (visible.count(readOrder) == 0 || !existing.insert(readOrder).second)
+        {
+            ass_free_event(track, i);
+            continue;
+        }
+        if (nEvents != i)
+            memcpy(&track->events[nEvents], &track->events[i], sizeof(ASS_Event));
+        ++nEvents;
+    }
+    track->n_events = nEvents;
+
+    for (const ASS_Event *srcEvent : visibleEvents)
+    {
+        if (existing.count(srcEvent->ReadOrder) > 0)
+            continue;
+        ASS_Event &event = track->events[ass_alloc_event(track)];
+        memcpy(&event, srcEvent, sizeof(ASS_Event));
+        event.Name = srcEvent->Name ? strdup(srcEvent->Name) : nullptr;
+        event.Effect = srcEvent->Effect ? strdup(srcEvent->Effect) : nullptr;
+        event.Text = srcEvent->Text ? strdup(srcEvent->Text) : nullptr;
+        event.render_priv = nullptr;
+    }
+
+    dst.hasASSData = hasASSData;
+    dst.W = W;
+    dst.H = H;
+    dst.winW = winW;
+    dst.winH = winH;
+    dst.zoom = zoom;
+    dst.aspect_ratio = aspect_ratio;
+    dst.fontScale = fontScale;
+
+    return true;
+}
+bool LibASS::renderASS(shared_ptr<QMPlay2OSD> &osd, double pos)
+{
+    if (!ass_sub_track)
+        return false;
+
+    if (!ass_sub_renderer)
+    {
+        ass_sub_renderer = ass_renderer_init(m_subsAss);
+        m_setFonts = true;
+    }
+    if (m_setFonts)
+    {
+        // Can be slow, so don't call it in "copyASS()"
+        ass_set_fonts(ass_sub_renderer, nullptr, nullptr, true, nullptr, true);
+        m_setFonts = false;
+    }
+
+    ASS_Image *img = renderFrame(pos);
+    if (!img)
+        return false;
+
+    if (osd && m_assIDs.count(osd->id()) > 0)
+        return true; // Not changed
+
+    auto newOsd = make_shared<QMPlay2OSD>();
+    newOsd->setPTS(pos);
+    if (!addImgs(img, newOsd.get()))
+        return false;
+    newOsd->genId();
+    m_assIDs.insert(newOsd->id());
+
+    osd = std::move(newOsd);
+    return true;
+}
+bool LibASS::hasASSTrack() const
+{
+    return ass_sub_track && ass_sub_renderer;
+}
 void LibASS::closeASS()
 {
+    ++m_generation;
     while (ass_sub_styles_copy.size())
     {
         ASS_Style *style = ass_sub_styles_copy.takeFirst();
@@ -572,7 +674,12 @@ void LibASS::closeASS()
         ass_free_track(ass_sub_track);
     ass_sub_track = nullptr;
     ass_sub_renderer = nullptr;
+    resetASSEventsIndex();
+    ++m_stylesGeneration;
     ass_clear_fonts(m_subsAss);
+    m_fonts.clear();
+    ++m_fontsGeneration;
+    m_setFonts = false;
     m_lastPos = qQNaN();
     m_assIDs.clear();
 }
@@ -602,6 +709,111 @@ inline void LibASS::calcSize()
     Functions::getImageSize(aspect_ratio, zoom, winW, winH, W, H);
 }
 
+ASS_Image *LibASS::renderFrame(double pos)
+{
+    if (!ass_sub_track || !ass_sub_renderer || !W || !H)
+        return nullptr;
+
+    double _fontScale = fontScale;
+
+    if (_fontScale != 1.0)
+    {
+        for (int i = 0; i < ass_sub_track->n_styles; i++)
+        {
+            ASS_Style &style = ass_sub_track->styles[i];
+            style.ScaleX  *= _fontScale;
+            style.ScaleY  *= _fontScale;
+            style.Shadow  *= _fontScale;
+            style.Outline *= _fontScale;
+        }
+    }
+
+    ass_set_frame_size(ass_sub_renderer, W, H);
+
+    const int marginLR = qMax(0, W / 2 - winW / 2);
+    const int marginTB = qMax(0, H / 2 - winH / 2);
+    ass_set_margins(ass_sub_renderer, marginTB, marginTB, marginLR, marginLR);
+
+    int ch;
+    ASS_Image *img = ass_render_frame(ass_sub_renderer, ass_sub_track, pos * 1000, &ch);
+
+    if (ch)
+        m_assIDs.clear();
+
+    if (_fontScale != 1.0)
+    {
+        for (int i = 0; i < ass_sub_track->n_styles; i++)
+        {
+            ASS_Style &style = ass_sub_track->styles[i];
+            style.ScaleX  /= _fontScale;
+            style.ScaleY  /= _fontScale;
+            style.Shadow  /= _fontScale;
+            style.Outline /= _fontScale;
+        }
+    }
+
+    return img;
+}
+
+void LibASS::copyASSStyles(LibASS &dst) const
+{
+    if (dst.ass_sub_track)
+        ass_free_track(dst.ass_sub_track);
+    ASS_Track *track = dst.ass_sub_track = ass_new_track(dst.m_subsAss);
+
+    track->track_type = ass_sub_track->track_type;
+    track->PlayResX = ass_sub_track->PlayResX;
+    track->PlayResY = ass_sub_track->PlayResY;
+    track->Timer = ass_sub_track->Timer;
+    track->WrapStyle = ass_sub_track->WrapStyle;
+    track->ScaledBorderAndShadow = ass_sub_track->ScaledBorderAndShadow;
+    track->Kerning = ass_sub_track->Kerning;
+    track->YCbCrMatrix = ass_sub_track->YCbCrMatrix;
+    track->default_style = ass_sub_track->default_style;
+    if (ass_sub_track->Language)
+        track->Language = strdup(ass_sub_track->Language);
+#if LIBASS_VERSION >= 0x01700000
+    track->LayoutResX = ass_sub_track->LayoutResX;
+    track->LayoutResY = ass_sub_track->LayoutResY;
+#endif
+
+    // Some libass versions allocate the default style for a new track
+    for (int i = 0; i < track->n_styles; ++i)
+        ass_free_style(track, i);
+    track->n_styles = 0;
+    for (int i = 0; i < ass_sub_track->n_styles; ++i)
+    {
+        const ASS_Style &srcStyle = ass_sub_track->styles[i];
+        ASS_Style &style = track->styles[ass_alloc_style(track)];
+        memcpy(&style, &srcStyle, sizeof(ASS_Style));
+        style.Name = srcStyle.Name ? strdup(srcStyle.Name) : nullptr;
+        style.FontName = srcStyle.FontName ? strdup(srcStyle.FontName) : nullptr;
+    }
+}
+void LibASS::indexASSEvents()
+{
+    if (m_indexedEvents > ass_sub_track->n_events)
+        resetASSEventsIndex();
+
+    // Events are usually added in order, so it's mostly appending
+    for (; m_indexedEvents < ass_sub_track->n_events; ++m_indexedEvents)
+    {
+        const ASS_Event &event = ass_sub_track->events[m_indexedEvents];
+        const auto it = std::upper_bound(m_eventsByStart.begin(), m_eventsByStart.end(), event.Start, [](long long start, const std::pair<long long, int> &entry) {
+            return start < entry.first;
+        });
+        m_eventsByStart.insert(it, {event.Start, m_indexedEvents});
+        m_maxEventDuration = qMax(m_maxEventDuration, event.Duration);
+    }
+}
+void LibASS::resetASSEventsIndex()
+{
+    m_eventsByStart.clear();
+    m_indexedEvents = 0;
+    m_maxEventDuration = 0;
+    ++m_eventsGeneration;
+}
+
 #else // QMPLAY2_LIBASS
 
 bool LibASS::isDummy()
@@ -663,6 +875,18 @@ bool LibASS::getASS(std::shared_ptr<QMPlay2OSD> &, double)
 {
     return false;
 }
+bool LibASS::copyASS(LibASS &, double)
+{
+    return false;
+}
+bool LibASS::renderASS(std::shared_ptr<QMPlay2OSD> &, double)
+{
+    return false;
+}
+bool LibASS::hasASSTrack() const
+{
+    return false;
+}
 void LibASS::closeASS()
 {}
 
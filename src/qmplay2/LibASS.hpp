@@ -22,8 +22,11 @@
 
 #include <QByteArray>
 #include <QList>
+#include <QPair>
 
 #include <memory>
+#include <atomic>
+#include <vector>
 #include <set>
 
 class Settings;
@@ -73,12 +76,30 @@ public:
     void addASSEvent(const QByteArray &, double, double);
     void flushASSEvents();
     bool getASS(std::shared_ptr<QMPlay2OSD> &osd, double pos = qQNaN());
+    // Synchronizes subtitles visible at "pos" to "dst", so "dst" can render them without locking this
+    // instance. Events which are still visible are kept in "dst", so their positions don't change.
+    bool copyASS(LibASS &dst, double pos);
+    // Doesn't modify the given OSD, it's replaced by a new one if the subtitles changed
+    bool renderASS(std::shared_ptr<QMPlay2OSD> &osd, double pos);
+    bool hasASSTrack() const;
     void closeASS();
 
+    // Changes when events, styles or frame size change, so rendered subtitles might be outdated
+    inline quint32 generation() const
+    {
+        return m_generation;
+    }
+
 private:
     void readStyle(const QString &, ass_style *);
     inline void calcSize();
 
+    ass_image *renderFrame(double pos);
+
+    void copyASSStyles(LibASS &dst) const;
+    void indexASSEvents();
+    void resetASSEventsIndex();
+
 private:
     Settings &settings;
 
@@ -100,6 +121,17 @@ private:
     bool hasASSData;
     double m_lastPos = qQNaN();
     std::set<int> m_assIDs;
+    QList<QPair<QByteArray, QByteArray>> m_fonts;
+    quint32 m_fontsGeneration = 0;
+    bool m_setFonts = false;
+
+    // Used by "copyASS()"
+    std::vector<std::pair<long long, int>> m_eventsByStart; // Start time, event index
+    int m_indexedEvents = 0;
+    long long m_maxEventDuration = 0;
+    quint32 m_stylesGeneration = 0, m_eventsGeneration = 0;
+
+    std::atomic<quint32> m_generation = 0;
 
 #ifdef USE_VULKAN
     std::shared_ptr<QmVk::BufferPool> m_vkBufferPool;
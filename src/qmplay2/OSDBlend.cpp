@@ -0,0 +1,152 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <OSDBlend.hpp>
+#include <OSDBlendSIMD.hpp>
+
+static inline int div255(const int x)
+{
+    const int t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static void expandAlphaScalar(quint32 *dst, const quint8 *src, const int w, const quint32 color)
+{
+    const int r = color & 0xFF;
+    const int g = (color >> 8) & 0xFF;
+    const int b = (color >> 16) & 0xFF;
+    const int a = color >> 24;
+    for (int x = 0; x < w; ++x)
+    {
+        const int alpha = div255(src[x] * a);
+        dst[x] = alpha << 24 | div255(b * alpha) << 16 | div255(g * alpha) << 8 | div255(r * alpha);
+    }
+}
+static void blendLumaScalar(quint8 *dstY, const quint32 *src, const int w)
+{
+    for (int x = 0; x < w; ++x)
+    {
+        const quint32 pixel = src[x];
+        const int a = pixel >> 24;
+        if (!a)
+            continue;
+
+        const int r = pixel & 0xFF;
+        const int g = (pixel >> 8) & 0xFF;
+        const int b = (pixel >> 16) & 0xFF;
+
+        const int y = (66 * r + 129 * g + 25 * b + (a << 4) + 128) >> 8;
+        dstY[x] = qMin(y + div255(dstY[x] * (255 - a)), 255);
+    }
+}
+static void blendChromaScalar(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w)
+{
+    const auto avg = [&](const int x, const int shift) {
+        const int sum =
+            ((src0[2 * x] >> shift) & 0xFF) + ((src0[2 * x + 1] >> shift) & 0xFF) +
+            ((src1[2 * x] >> shift) & 0xFF) + ((src1[2 * x + 1] >> shift) & 0xFF)
+        ;
+        return (sum + 2) >> 2;
+    };
+    for (int x = 0; x < w; ++x)
+    {
+        const int a = avg(x, 24);
+        if (!a)
+            continue;
+
+        const int r = avg(x, 0);
+        const int g = avg(x, 8);
+        const int b = avg(x, 16);
+
+        // Averaged premultiplied pixels, so the offset is scaled by alpha
+        const int offset = (a << 7) + 128;
+        const int u = qMax((112 * b + offset - 38 * r - 74 * g) >> 8, 0);
+        const int v = qMax((112 * r + offset - 94 * g - 18 * b) >> 8, 0);
+
+        const int ia = 255 - a;
+        dstU[x] = qMin(u + div255(dstU[x] * ia), 255);
+        dstV[x] = qMin(v + div255(dstV[x] * ia), 255);
+    }
+}
+
+template<OSDExpandAlphaFn expandAlphaSIMD>
+static void expandAlpha(quint32 *dst, const quint8 *src, int w, quint32 color)
+{
+    const int x = expandAlphaSIMD(dst, src, w, color);
+    expandAlphaScalar(dst + x, src + x, w - x, color);
+}
+template<OSDBlendLumaFn blendLumaSIMD>
+static void blendLuma(quint8 *dstY, const quint32 *src, int w)
+{
+    const int x = blendLumaSIMD(dstY, src, w);
+    blendLumaScalar(dstY + x, src + x, w - x);
+}
+template<OSDBlendChromaFn blendChromaSIMD>
+static void blendChroma(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, int w)
+{
+    const int x = blendChromaSIMD(dstU, dstV, src0, src1, w);
+    blendChromaScalar(dstU + x, dstV + x, src0 + 2 * x, src1 + 2 * x, w - x);
+}
+
+#define OSD_BLEND_KERNELS(suffix) \
+    OSDBlend::Kernels { \
+        #suffix, \
+        expandAlpha<osdExpandAlpha##suffix>, \
+        blendLuma<osdBlendLuma##suffix>, \
+        blendChroma<osdBlendChroma##suffix>, \
+    }
+
+static const OSDBlend::Kernels g_scalarKernels {
+    "Scalar",
+    expandAlphaScalar,
+    blendLumaScalar,
+    blendChromaScalar,
+};
+#if defined(OSD_BLEND_X86)
+static const OSDBlend::Kernels g_sse2Kernels = OSD_BLEND_KERNELS(SSE2);
+static const OSDBlend::Kernels g_avx2Kernels = OSD_BLEND_KERNELS(AVX2);
+#elif defined(OSD_BLEND_NEON)
+static const OSDBlend::Kernels g_neonKernels = OSD_BLEND_KERNELS(NEON);
+#endif
+
+namespace OSDBlend {
+
+const Kernels &kernels()
+{
+    static const Kernels *const best = availableKernels().constLast();
+    return *best;
+}
+
+QVector<const Kernels *> availableKernels()
+{
+    QVector<const Kernels *> available {
+        &g_scalarKernels,
+    };
+#if defined(OSD_BLEND_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        available.append(&g_sse2Kernels);
+    if (__builtin_cpu_supports("avx2"))
+        available.append(&g_avx2Kernels);
+#elif defined(OSD_BLEND_NEON)
+    available.append(&g_neonKernels);
+#endif
+    return available;
+}
+
+}
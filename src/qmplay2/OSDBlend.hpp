@@ -0,0 +1,50 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QMPlay2Lib.hpp>
+
+#include <QVector>
+
+/*
+ * Compositing kernels for CPU video outputs. Pixels are premultiplied and
+ * stored as "quint32" values: R in bits 0-7, G in 8-15, B in 16-23, A in 24-31.
+ */
+namespace OSDBlend
+{
+    struct Kernels
+    {
+        const char *name;
+
+        // Converts "w" alpha values into "color" (not premultiplied) with multiplied alpha
+        void (*expandAlpha)(quint32 *dst, const quint8 *src, int w, quint32 color);
+
+        // Blends "w" pixels into the luma plane
+        void (*blendLuma)(quint8 *dstY, const quint32 *src, int w);
+
+        // Blends "w" 2x2 pixel blocks from two lines into the chroma planes
+        void (*blendChroma)(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, int w);
+    };
+
+    // The fastest kernels for the current CPU
+    QMPLAY2SHAREDLIB_EXPORT const Kernels &kernels();
+
+    // All kernels supported by the current CPU, scalar kernels are the first
+    QMPLAY2SHAREDLIB_EXPORT QVector<const Kernels *> availableKernels();
+}
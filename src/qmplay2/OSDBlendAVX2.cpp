@@ -0,0 +1,118 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <OSDBlendSIMD.hpp>
+
+#include <immintrin.h>
+
+namespace {
+
+struct AVX2
+{
+    using V = __m256i;
+    static constexpr int N = 16;
+
+    static inline V loadPlane(const quint8 *p)
+    {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    }
+    static inline void storePlane(quint8 *p, const V v)
+    {
+        // "packus" works within 128-bit lanes, so move both results into the lower half
+        const V packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(packed));
+    }
+
+    // Values are at most 255, so the signed saturation doesn't matter
+    static inline V channel(const V p0, const V p1, const int shift)
+    {
+        const V mask = _mm256_set1_epi32(0xFF);
+        const V packed = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(p0, shift), mask), _mm256_and_si256(_mm256_srli_epi32(p1, shift), mask));
+        return _mm256_permute4x64_epi64(packed, 0xD8);
+    }
+    static inline V pairSums(const V v0, const V v1)
+    {
+        const V ones = _mm256_set1_epi16(1);
+        return _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_madd_epi16(v0, ones), _mm256_madd_epi16(v1, ones)), 0xD8);
+    }
+
+    static inline void loadPixels(const quint32 *p, V &r, V &g, V &b, V &a)
+    {
+        const V p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const V p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 8));
+        r = channel(p0, p1, 0);
+        g = channel(p0, p1, 8);
+        b = channel(p0, p1, 16);
+        a = channel(p0, p1, 24);
+    }
+    static inline void loadPairSums(const quint32 *p, V &r, V &g, V &b, V &a)
+    {
+        V r0, g0, b0, a0, r1, g1, b1, a1;
+        loadPixels(p, r0, g0, b0, a0);
+        loadPixels(p + N, r1, g1, b1, a1);
+        r = pairSums(r0, r1);
+        g = pairSums(g0, g1);
+        b = pairSums(b0, b1);
+        a = pairSums(a0, a1);
+    }
+    static inline void storePixels(quint32 *p, const V r, const V g, const V b, const V a)
+    {
+        const V rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+        const V ba = _mm256_or_si256(b, _mm256_slli_epi16(a, 8));
+        const V lo = _mm256_unpacklo_epi16(rg, ba); // Pixels 0-3 and 8-11
+        const V hi = _mm256_unpackhi_epi16(rg, ba); // Pixels 4-7 and 12-15
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    static inline V set1(const short v)
+    {
+        return _mm256_set1_epi16(v);
+    }
+
+    static inline V add(const V a, const V b)
+    {
+        return _mm256_add_epi16(a, b);
+    }
+    static inline V sub(const V a, const V b)
+    {
+        return _mm256_sub_epi16(a, b);
+    }
+    static inline V mul(const V a, const V b)
+    {
+        return _mm256_mullo_epi16(a, b);
+    }
+    template<int n>
+    static inline V shl(const V v)
+    {
+        return _mm256_slli_epi16(v, n);
+    }
+    template<int n>
+    static inline V shr(const V v)
+    {
+        return _mm256_srli_epi16(v, n);
+    }
+
+    static inline bool isZero(const V v)
+    {
+        return _mm256_testz_si256(v, v);
+    }
+};
+
+}
+
+OSD_BLEND_SIMD_IMPL(AVX2, AVX2)
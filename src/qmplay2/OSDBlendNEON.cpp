@@ -0,0 +1,100 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <OSDBlendSIMD.hpp>
+
+#include <arm_neon.h>
+
+namespace {
+
+struct NEON
+{
+    using V = uint16x8_t;
+    static constexpr int N = 8;
+
+    static inline V loadPlane(const quint8 *p)
+    {
+        return vmovl_u8(vld1_u8(p));
+    }
+    static inline void storePlane(quint8 *p, const V v)
+    {
+        vst1_u8(p, vqmovn_u16(v));
+    }
+
+    static inline void loadPixels(const quint32 *p, V &r, V &g, V &b, V &a)
+    {
+        const uint8x8x4_t v = vld4_u8(reinterpret_cast<const uint8_t *>(p));
+        r = vmovl_u8(v.val[0]);
+        g = vmovl_u8(v.val[1]);
+        b = vmovl_u8(v.val[2]);
+        a = vmovl_u8(v.val[3]);
+    }
+    static inline void loadPairSums(const quint32 *p, V &r, V &g, V &b, V &a)
+    {
+        const uint8x16x4_t v = vld4q_u8(reinterpret_cast<const uint8_t *>(p));
+        r = vpaddlq_u8(v.val[0]);
+        g = vpaddlq_u8(v.val[1]);
+        b = vpaddlq_u8(v.val[2]);
+        a = vpaddlq_u8(v.val[3]);
+    }
+    static inline void storePixels(quint32 *p, const V r, const V g, const V b, const V a)
+    {
+        uint8x8x4_t v;
+        v.val[0] = vmovn_u16(r);
+        v.val[1] = vmovn_u16(g);
+        v.val[2] = vmovn_u16(b);
+        v.val[3] = vmovn_u16(a);
+        vst4_u8(reinterpret_cast<uint8_t *>(p), v);
+    }
+
+    static inline V set1(const short v)
+    {
+        return vdupq_n_u16(v);
+    }
+
+    static inline V add(const V a, const V b)
+    {
+        return vaddq_u16(a, b);
+    }
+    static inline V sub(const V a, const V b)
+    {
+        return vsubq_u16(a, b);
+    }
+    static inline V mul(const V a, const V b)
+    {
+        return vmulq_u16(a, b);
+    }
+    template<int n>
+    static inline V shl(const V v)
+    {
+        return vshlq_n_u16(v, n);
+    }
+    template<int n>
+    static inline V shr(const V v)
+    {
+        return vshrq_n_u16(v, n);
+    }
+
+    static inline bool isZero(const V v)
+    {
+        return vmaxvq_u16(v) == 0;
+    }
+};
+
+}
+
+OSD_BLEND_SIMD_IMPL(NEON, NEON)
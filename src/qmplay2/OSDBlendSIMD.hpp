@@ -0,0 +1,144 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    Vectorized OSD compositing kernels, see "OSDBlend.cpp" for the scalar reference.
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+// Every function processes "w" elements at most (rounded down to the vector width)
+// and returns the number of processed elements.
+using OSDExpandAlphaFn = int (*)(quint32 *dst, const quint8 *src, const int w, const quint32 color);
+using OSDBlendLumaFn = int (*)(quint8 *dstY, const quint32 *src, const int w);
+using OSDBlendChromaFn = int (*)(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w);
+
+int osdExpandAlphaSSE2(quint32 *dst, const quint8 *src, const int w, const quint32 color);
+int osdBlendLumaSSE2(quint8 *dstY, const quint32 *src, const int w);
+int osdBlendChromaSSE2(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w);
+
+int osdExpandAlphaAVX2(quint32 *dst, const quint8 *src, const int w, const quint32 color);
+int osdBlendLumaAVX2(quint8 *dstY, const quint32 *src, const int w);
+int osdBlendChromaAVX2(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w);
+
+int osdExpandAlphaNEON(quint32 *dst, const quint8 *src, const int w, const quint32 color);
+int osdBlendLumaNEON(quint8 *dstY, const quint32 *src, const int w);
+int osdBlendChromaNEON(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w);
+
+/*
+ * "Ops" provides a vector of unsigned 16-bit lanes ("V") holding "N" values and operations on it.
+ * Every instruction set implements "Ops" in its own translation unit compiled with proper flags.
+ * All arithmetic must give the same results as the scalar code in "OSDBlend.cpp".
+ */
+template<typename Ops>
+struct OSDBlendSIMD
+{
+    using V = typename Ops::V;
+
+    // Rounded "x / 255" for "x" <= 65025
+    static inline V div255(const V x)
+    {
+        const V t = Ops::add(x, Ops::set1(128));
+        return Ops::template shr<8>(Ops::add(t, Ops::template shr<8>(t)));
+    }
+
+    static int expandAlpha(quint32 *dst, const quint8 *src, const int w, const quint32 color)
+    {
+        const V r = Ops::set1(color & 0xFF);
+        const V g = Ops::set1((color >> 8) & 0xFF);
+        const V b = Ops::set1((color >> 16) & 0xFF);
+        const V a = Ops::set1(color >> 24);
+
+        int x = 0;
+        for (; x + Ops::N <= w; x += Ops::N)
+        {
+            const V alpha = div255(Ops::mul(Ops::loadPlane(src + x), a));
+            Ops::storePixels(dst + x, div255(Ops::mul(r, alpha)), div255(Ops::mul(g, alpha)), div255(Ops::mul(b, alpha)), alpha);
+        }
+        return x;
+    }
+
+    static int blendLuma(quint8 *dstY, const quint32 *src, const int w)
+    {
+        int x = 0;
+        for (; x + Ops::N <= w; x += Ops::N)
+        {
+            V r, g, b, a;
+            Ops::loadPixels(src + x, r, g, b, a);
+            if (Ops::isZero(a))
+                continue;
+
+            // Y = ((66 * R + 129 * G + 25 * B + 16 * A + 128) >> 8) + D * (255 - A) / 255
+            V y = Ops::add(Ops::add(Ops::mul(r, Ops::set1(66)), Ops::mul(g, Ops::set1(129))), Ops::add(Ops::mul(b, Ops::set1(25)), Ops::template shl<4>(a)));
+            y = Ops::template shr<8>(Ops::add(y, Ops::set1(128)));
+
+            const V d = div255(Ops::mul(Ops::loadPlane(dstY + x), Ops::sub(Ops::set1(255), a)));
+            Ops::storePlane(dstY + x, Ops::add(y, d));
+        }
+        return x;
+    }
+
+    static int blendChroma(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w)
+    {
+        const auto avg = [](const V sum0, const V sum1) {
+            return Ops::template shr<2>(Ops::add(Ops::add(sum0, sum1), Ops::set1(2)));
+        };
+
+        int x = 0;
+        for (; x + Ops::N <= w; x += Ops::N)
+        {
+            V r0, g0, b0, a0, r1, g1, b1, a1;
+            Ops::loadPairSums(src0 + 2 * x, r0, g0, b0, a0);
+            Ops::loadPairSums(src1 + 2 * x, r1, g1, b1, a1);
+
+            const V a = avg(a0, a1);
+            if (Ops::isZero(a))
+                continue;
+
+            const V r = avg(r0, r1);
+            const V g = avg(g0, g1);
+            const V b = avg(b0, b1);
+
+            // Premultiplied color components can't exceed alpha, so both results are never negative
+            const V offset = Ops::add(Ops::template shl<7>(a), Ops::set1(128));
+            const V u = Ops::template shr<8>(Ops::sub(Ops::add(Ops::mul(b, Ops::set1(112)), offset), Ops::add(Ops::mul(r, Ops::set1(38)), Ops::mul(g, Ops::set1(74)))));
+            const V v = Ops::template shr<8>(Ops::sub(Ops::add(Ops::mul(r, Ops::set1(112)), offset), Ops::add(Ops::mul(g, Ops::set1(94)), Ops::mul(b, Ops::set1(18)))));
+
+            const V ia = Ops::sub(Ops::set1(255), a);
+            Ops::storePlane(dstU + x, Ops::add(u, div255(Ops::mul(Ops::loadPlane(dstU + x), ia))));
+            Ops::storePlane(dstV + x, Ops::add(v, div255(Ops::mul(Ops::loadPlane(dstV + x), ia))));
+        }
+        return x;
+    }
+};
+
+#define OSD_BLEND_SIMD_IMPL(suffix, Ops) \
+    int osdExpandAlpha##suffix(quint32 *dst, const quint8 *src, const int w, const quint32 color) \
+    { \
+        return OSDBlendSIMD<Ops>::expandAlpha(dst, src, w, color); \
+    } \
+    int osdBlendLuma##suffix(quint8 *dstY, const quint32 *src, const int w) \
+    { \
+        return OSDBlendSIMD<Ops>::blendLuma(dstY, src, w); \
+    } \
+    int osdBlendChroma##suffix(quint8 *dstU, quint8 *dstV, const quint32 *src0, const quint32 *src1, const int w) \
+    { \
+        return OSDBlendSIMD<Ops>::blendChroma(dstU, dstV, src0, src1, w); \
+    }
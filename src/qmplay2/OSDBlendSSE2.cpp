@@ -0,0 +1,113 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <OSDBlendSIMD.hpp>
+
+#include <emmintrin.h>
+
+namespace {
+
+struct SSE2
+{
+    using V = __m128i;
+    static constexpr int N = 8;
+
+    static inline V loadPlane(const quint8 *p)
+    {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128());
+    }
+    static inline void storePlane(quint8 *p, const V v)
+    {
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(v, v));
+    }
+
+    // Values are at most 255, so the signed saturation doesn't matter
+    static inline V channel(const V p0, const V p1, const int shift)
+    {
+        const V mask = _mm_set1_epi32(0xFF);
+        return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, shift), mask), _mm_and_si128(_mm_srli_epi32(p1, shift), mask));
+    }
+    static inline V pairSums(const V v0, const V v1)
+    {
+        const V ones = _mm_set1_epi16(1);
+        return _mm_packs_epi32(_mm_madd_epi16(v0, ones), _mm_madd_epi16(v1, ones));
+    }
+
+    static inline void loadPixels(const quint32 *p, V &r, V &g, V &b, V &a)
+    {
+        const V p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const V p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 4));
+        r = channel(p0, p1, 0);
+        g = channel(p0, p1, 8);
+        b = channel(p0, p1, 16);
+        a = channel(p0, p1, 24);
+    }
+    static inline void loadPairSums(const quint32 *p, V &r, V &g, V &b, V &a)
+    {
+        V r0, g0, b0, a0, r1, g1, b1, a1;
+        loadPixels(p, r0, g0, b0, a0);
+        loadPixels(p + N, r1, g1, b1, a1);
+        r = pairSums(r0, r1);
+        g = pairSums(g0, g1);
+        b = pairSums(b0, b1);
+        a = pairSums(a0, a1);
+    }
+    static inline void storePixels(quint32 *p, const V r, const V g, const V b, const V a)
+    {
+        const V rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+        const V ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 4), _mm_unpackhi_epi16(rg, ba));
+    }
+
+    static inline V set1(const short v)
+    {
+        return _mm_set1_epi16(v);
+    }
+
+    static inline V add(const V a, const V b)
+    {
+        return _mm_add_epi16(a, b);
+    }
+    static inline V sub(const V a, const V b)
+    {
+        return _mm_sub_epi16(a, b);
+    }
+    static inline V mul(const V a, const V b)
+    {
+        return _mm_mullo_epi16(a, b);
+    }
+    template<int n>
+    static inline V shl(const V v)
+    {
+        return _mm_slli_epi16(v, n);
+    }
+    template<int n>
+    static inline V shr(const V v)
+    {
+        return _mm_srli_epi16(v, n);
+    }
+
+    static inline bool isZero(const V v)
+    {
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_setzero_si128())) == 0xFFFF;
+    }
+};
+
+}
+
+OSD_BLEND_SIMD_IMPL(SSE2, SSE2)
@@ -67,6 +67,10 @@ void Packet::clear()
     m_frame.reset();
 }
 
+AVRational Packet::timeBase() const
+{
+    return m_timeBase;
+}
 void Packet::setTimeBase(const AVRational &timeBase)
 {
     m_timeBase = timeBase;
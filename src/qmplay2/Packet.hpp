@@ -45,6 +45,7 @@ public:
     bool isEmpty() const;
     void clear();
 
+    AVRational timeBase() const;
     void setTimeBase(const AVRational &timeBase);
     void setOffsetTS(double offsetTS);
 
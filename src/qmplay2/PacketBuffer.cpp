@@ -18,45 +18,73 @@
 
 #include <PacketBuffer.hpp>
 
+#include <TimeshiftFile.hpp>
+
+#include <algorithm>
 #include <cmath>
 
 #include <QDebug>
 
 double PacketBuffer::s_backwardTime;
 
-void PacketBuffer::iterate(const IterateCallback &cb)
+static constexpr size_t g_initialRingSize = 64;
+
+PacketBuffer::PacketBuffer()
+    : m_ring(g_initialRingSize)
+{}
+PacketBuffer::~PacketBuffer()
+{}
+
+bool PacketBuffer::enableTimeshift(const QString &dirPath, qint64 capacity, double forwardTime)
 {
+    auto timeshift = std::make_unique<TimeshiftFile>(dirPath, capacity);
+    if (!timeshift->isOpen())
+        return false;
+
     lock();
+    while (diskCount() > 0)
+        dropFront();
+    m_timeshift = std::move(timeshift);
+    m_timeshiftForwardTime = forwardTime;
+    unlock();
 
-    const int count = packetsCount();
+    return true;
+}
+void PacketBuffer::disableTimeshift()
+{
+    lock();
+    while (diskCount() > 0)
+        dropFront();
+    m_timeshift.reset();
+    unlock();
+}
 
-    int startPos = m_pos;
-    if (startPos >= count)
+void PacketBuffer::iterate(const IterateCallback &cb)
+{
+    lock();
+
+    if (m_pos >= m_count)
     {
         unlock();
         return;
     }
 
-    for (int i = startPos; i >= 0; --i) // Find nearest keyframe (backwards)
-    {
-        auto &packet = atPos(i);
-        if (packet.hasKeyFrame())
-        {
-            startPos = i;
-            break;
-        }
-    }
+    // Find nearest keyframe (backwards), or the next one if there is no keyframe before
+    const auto it = std::upper_bound(m_keyFrames.cbegin(), m_keyFrames.cend(), m_firstSeq + m_pos, [](qint64 seq, const KeyFrame &keyFrame) {
+        return seq < keyFrame.seq;
+    });
+    int startPos = -1;
+    if (it != m_keyFrames.cbegin())
+        startPos = std::prev(it)->seq - m_firstSeq;
+    else if (it != m_keyFrames.cend())
+        startPos = it->seq - m_firstSeq;
 
     // Iterate packets starting when found keyframe
-    bool hasKeyframe = false;
-    for (int i = startPos; i < count; ++i)
+    if (startPos > -1)
     {
-        auto &packet = atPos(i);
-        if (!hasKeyframe && packet.hasKeyFrame())
-            hasKeyframe = true;
-        if (hasKeyframe)
+        for (int i = startPos; i < m_count; ++i)
         {
-            if (!cb(packet))
+            if (!cb(packetAt(i)))
                 break;
         }
     }
@@ -70,79 +98,103 @@ bool PacketBuffer::seekTo(double seekPos, bool backward)
     if (count == 0)
         return false;
 
-    const bool findBackwards = (m_pos > 0 && seekPos < atPos(m_pos - 1).ts());
+    const bool findBackwards = (m_pos > 0 && seekPos < tsAt(m_pos - 1));
 
-    if (findBackwards && atPos(0).ts() > seekPos)
+    if (findBackwards && tsAt(0) > seekPos)
     {
-        if (floor(atPos(0).ts()) > seekPos)
+        if (floor(tsAt(0)) > seekPos)
             return false; // No packets for backward seek
-        seekPos = atPos(0).ts();
+        seekPos = tsAt(0);
     }
-    else if (!findBackwards && atPos(count - 1).ts() < seekPos)
+    else if (!findBackwards && tsAt(count - 1) < seekPos)
     {
-        if (ceil(atPos(count - 1).ts()) < seekPos)
+        if (ceil(tsAt(count - 1)) < seekPos)
             return false; // No packets for forward seek
-        seekPos = atPos(count - 1).ts();
+        seekPos = tsAt(count - 1);
     }
 
-    double durationToChange = 0.0;
-    qint64 sizeToChange = 0;
-    int tmpPos;
-
-    const auto doSeek = [&](const int currPos, const bool forward, const bool keyFrame) {
-        tmpPos = -1;
-        if (forward)
+    int tmpPos = -1;
+    if (m_tsBackwardCount == 0)
+    {
+        if (!findBackwards)
+        {
+            // First packet since current position with timestamp not lower than seek position
+            tmpPos = lowerBoundTs(m_pos, count, seekPos);
+            if (tmpPos >= count)
+                tmpPos = -1;
+        }
+        else
+        {
+            // Last packet before current position with timestamp not greater than seek position
+            tmpPos = upperBoundTs(0, m_pos, seekPos) - 1;
+        }
+    }
+    else if (!findBackwards)
+    {
+        // Timestamps are not monotonic (missing timestamps, discontinuities), so scan linearly
+        for (int i = m_pos; i < count; ++i)
         {
-            for (int i = currPos; i < count; ++i)
+            if (tsAt(i) >= seekPos)
             {
-                const Packet &pkt = atPos(i);
-                if (pkt.ts() >= seekPos && (!keyFrame || pkt.hasKeyFrame()))
-                {
-                    tmpPos = i;
-                    return true;
-                }
-                else
-                {
-                    durationToChange += pkt.duration();
-                    sizeToChange += pkt.size();
-                }
+                tmpPos = i;
+                break;
             }
         }
-        else for (int i = currPos - 1; i >= 0; --i)
+    }
+    else
+    {
+        // Timestamps are not monotonic (missing timestamps, discontinuities), so scan linearly
+        for (int i = m_pos - 1; i >= 0; --i)
         {
-            const Packet &pkt = atPos(i);
-            durationToChange -= pkt.duration();
-            sizeToChange -= pkt.size();
-            if (pkt.ts() <= seekPos && (!keyFrame || pkt.hasKeyFrame()))
+            if (tsAt(i) <= seekPos)
             {
                 tmpPos = i;
-                return true;
+                break;
             }
         }
+    }
+    if (tmpPos < 0)
         return false;
-    };
 
-    if (doSeek(m_pos, !findBackwards, false))
+    if (!hasKeyFrameAt(tmpPos))
     {
-        if (atPos(tmpPos).hasKeyFrame() || doSeek(tmpPos, !backward, true))
-        {
-            m_remainingDuration -= durationToChange;
-            m_backwardDuration += durationToChange;
-            m_remainingBytes -= sizeToChange;
-            m_backwardBytes += sizeToChange;
+        tmpPos = findKeyFrame(tmpPos, !backward, seekPos);
+        if (tmpPos < 0)
+            return false;
+    }
 
-            m_pos = tmpPos;
+    const double durationToChange = durationBefore(tmpPos) - durationBefore(m_pos);
+    const qint64 sizeToChange = bytesBefore(tmpPos) - bytesBefore(m_pos);
 
-            return true;
-        }
-    }
+    m_remainingDuration -= durationToChange;
+    m_backwardDuration += durationToChange;
+    m_remainingBytes -= sizeToChange;
+    m_backwardBytes += sizeToChange;
+
+    m_pos = tmpPos;
 
-    return false;
+    return true;
 }
 void PacketBuffer::clear()
 {
     lock();
-    std::deque<Packet>::clear();
+    if (m_ring.size() > g_initialRingSize)
+    {
+        std::vector<Entry>(g_initialRingSize).swap(m_ring);
+    }
+    else for (int i = diskCount(); i < m_count; ++i)
+    {
+        entryAt(i - diskCount()).packet.clear();
+    }
+    m_keyFrames.clear();
+    m_diskEntries.clear();
+    if (m_timeshift)
+        m_timeshift->reset();
+    m_head = m_count = 0;
+    m_firstSeq = 0;
+    m_durationSumBase = 0.0;
+    m_bytesSumBase = 0;
+    m_tsBackwardCount = 0;
     m_remainingDuration = m_backwardDuration = 0.0;
     m_remainingBytes = m_backwardBytes = 0;
     m_pos = 0;
@@ -153,14 +205,28 @@ void PacketBuffer::put(const Packet &packet)
 {
     lock();
     clearBackwards();
-    push_back(packet);
+    if (m_count - diskCount() == static_cast<int>(m_ring.size()))
+        grow();
+    const double durationSum = durationBefore(m_count) + packet.duration();
+    const qint64 bytesSum = bytesBefore(m_count) + packet.size();
+    const bool tsBackward = (m_count > 0 && packet.ts() < tsAt(m_count - 1));
+    Entry &entry = entryAt(m_count - diskCount());
+    entry.packet = packet;
+    entry.durationSum = durationSum;
+    entry.bytesSum = bytesSum;
+    entry.tsBackward = tsBackward;
+    if (tsBackward)
+        ++m_tsBackwardCount;
+    if (packet.hasKeyFrame())
+        m_keyFrames.push_back({m_firstSeq + m_count, packet.ts()});
+    ++m_count;
     m_remainingBytes += packet.size();
     m_remainingDuration += packet.duration();
     unlock();
 }
 Packet PacketBuffer::fetch()
 {
-    const Packet &packet = atPos(m_pos++);
+    Packet packet = packetAt(m_pos++);
     m_remainingDuration -= packet.duration();
     m_backwardDuration += packet.duration();
     m_remainingBytes -= packet.size();
@@ -170,17 +236,214 @@ Packet PacketBuffer::fetch()
 
 void PacketBuffer::clearBackwards()
 {
-    while (m_backwardDuration > s_backwardTime && m_pos > 0)
+    if (!m_timeshift)
+    {
+        while (m_backwardDuration > s_backwardTime && m_pos > 0)
+        {
+            const Packet &tmpPacket = entryAt(0).packet;
+            m_backwardDuration -= tmpPacket.duration();
+            m_backwardBytes -= tmpPacket.size();
+            popFront();
+            --m_pos;
+        }
+        return;
+    }
+
+    // Keep in memory the backward window and "m_timeshiftForwardTime" of remaining packets,
+    // everything else goes to disk. Current position can also be moved to disk if playback
+    // is paused or delayed for a long time.
+    while (m_count > diskCount())
+    {
+        const int nDisk = diskCount();
+        const double memoryDuration = durationBefore(m_count) - durationBefore(nDisk);
+        const double memoryBackwardDuration = (m_pos > nDisk)
+            ? durationBefore(m_pos) - durationBefore(nDisk)
+            : 0.0
+        ;
+        if (memoryBackwardDuration <= s_backwardTime && memoryDuration <= s_backwardTime + m_timeshiftForwardTime)
+            break;
+        moveFrontToDisk();
+    }
+}
+
+inline bool PacketBuffer::hasKeyFrameAt(int idx) const
+{
+    const int nDisk = diskCount();
+    return (idx < nDisk) ? m_diskEntries[idx].keyFrame : entryAt(idx - nDisk).packet.hasKeyFrame();
+}
+inline bool &PacketBuffer::tsBackwardAt(int idx)
+{
+    const int nDisk = diskCount();
+    return (idx < nDisk) ? m_diskEntries[idx].tsBackward : entryAt(idx - nDisk).tsBackward;
+}
+Packet PacketBuffer::packetAt(int idx) const
+{
+    const int nDisk = diskCount();
+    return (idx < nDisk) ? m_timeshift->read(m_diskEntries[idx].offset) : entryAt(idx - nDisk).packet;
+}
+
+inline double PacketBuffer::durationBefore(int idx) const
+{
+    if (idx <= 0)
+        return m_durationSumBase;
+    const int nDisk = diskCount();
+    return (idx <= nDisk) ? m_diskEntries[idx - 1].durationSum : entryAt(idx - 1 - nDisk).durationSum;
+}
+inline qint64 PacketBuffer::bytesBefore(int idx) const
+{
+    if (idx <= 0)
+        return m_bytesSumBase;
+    const int nDisk = diskCount();
+    return (idx <= nDisk) ? m_diskEntries[idx - 1].bytesSum : entryAt(idx - 1 - nDisk).bytesSum;
+}
+
+int PacketBuffer::lowerBoundTs(int begin, int end, double ts) const
+{
+    while (begin < end)
+    {
+        const int mid = begin + (end - begin) / 2;
+        if (tsAt(mid) < ts)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    return begin;
+}
+int PacketBuffer::upperBoundTs(int begin, int end, double ts) const
+{
+    while (begin < end)
+    {
+        const int mid = begin + (end - begin) / 2;
+        if (tsAt(mid) <= ts)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    return begin;
+}
+
+void PacketBuffer::grow()
+{
+    const int memCount = m_count - diskCount();
+    std::vector<Entry> ring(m_ring.size() * 2);
+    for (int i = 0; i < memCount; ++i)
+    {
+        Entry &entry = entryAt(i);
+        ring[i].packet = std::move(entry.packet);
+        ring[i].durationSum = entry.durationSum;
+        ring[i].bytesSum = entry.bytesSum;
+        ring[i].tsBackward = entry.tsBackward;
+    }
+    m_ring.swap(ring);
+    m_head = 0;
+}
+void PacketBuffer::popFront()
+{
+    if (!m_diskEntries.empty())
+    {
+        const DiskEntry &diskEntry = m_diskEntries.front();
+        m_durationSumBase = diskEntry.durationSum;
+        m_bytesSumBase = diskEntry.bytesSum;
+        m_diskEntries.pop_front();
+    }
+    else
+    {
+        Entry &entry = entryAt(0);
+        m_durationSumBase = entry.durationSum;
+        m_bytesSumBase = entry.bytesSum;
+        entry.packet.clear();
+        m_head = (m_head + 1) & (m_ring.size() - 1);
+    }
+    if (!m_keyFrames.empty() && m_keyFrames.front().seq == m_firstSeq)
+        m_keyFrames.pop_front();
+    ++m_firstSeq;
+    --m_count;
+    if (m_count > 0)
+    {
+        // The first packet has no previous packet anymore
+        bool &tsBackward = tsBackwardAt(0);
+        if (tsBackward)
+        {
+            tsBackward = false;
+            --m_tsBackwardCount;
+        }
+    }
+}
+void PacketBuffer::dropFront()
+{
+    const double duration = durationBefore(1) - durationBefore(0);
+    const qint64 bytes = bytesBefore(1) - bytesBefore(0);
+    if (m_pos > 0)
     {
-        const Packet &tmpPacket = *begin();
-        m_backwardDuration -= tmpPacket.duration();
-        m_backwardBytes -= tmpPacket.size();
-        erase(begin());
+        m_backwardDuration -= duration;
+        m_backwardBytes -= bytes;
         --m_pos;
     }
+    else
+    {
+        m_remainingDuration -= duration;
+        m_remainingBytes -= bytes;
+    }
+    popFront();
 }
 
-inline Packet &PacketBuffer::atPos(size_type idx)
+void PacketBuffer::moveFrontToDisk()
 {
-    return operator[](idx);
+    Entry &entry = entryAt(0);
+
+    bool droppedCurrent = false;
+    qint64 offset;
+    while ((offset = m_timeshift->write(entry.packet, m_diskEntries.empty() ? -1 : m_diskEntries.front().offset)) < 0 && !m_diskEntries.empty())
+    {
+        // The ring file is full - forget the oldest packets
+        droppedCurrent |= (m_pos == 0);
+        dropFront();
+    }
+
+    if (offset < 0)
+    {
+        // Packet can't be stored at all, all packets from disk are already removed
+        droppedCurrent |= (m_pos == 0);
+        dropFront();
+    }
+    else
+    {
+        m_diskEntries.push_back({offset, entry.packet.ts(), entry.durationSum, entry.bytesSum, entry.packet.hasKeyFrame(), entry.tsBackward});
+        entry.packet.clear();
+        m_head = (m_head + 1) & (m_ring.size() - 1);
+    }
+
+    if (droppedCurrent)
+    {
+        // Playback was delayed for too long, continue from the oldest available key frame
+        while (m_pos == 0 && m_count > 0 && !hasKeyFrameAt(0))
+            dropFront();
+    }
+}
+
+int PacketBuffer::findKeyFrame(int idx, bool forward, double seekPos) const
+{
+    const qint64 seq = m_firstSeq + idx;
+    if (forward)
+    {
+        for (auto it = std::lower_bound(m_keyFrames.cbegin(), m_keyFrames.cend(), seq, [](const KeyFrame &keyFrame, qint64 value) {
+            return keyFrame.seq < value;
+        }); it != m_keyFrames.cend(); ++it)
+        {
+            if (it->ts >= seekPos)
+                return it->seq - m_firstSeq;
+        }
+    }
+    else
+    {
+        for (auto it = std::upper_bound(m_keyFrames.cbegin(), m_keyFrames.cend(), seq, [](qint64 value, const KeyFrame &keyFrame) {
+            return value < keyFrame.seq;
+        }); it != m_keyFrames.cbegin();)
+        {
+            --it;
+            if (it->ts <= seekPos)
+                return it->seq - m_firstSeq;
+        }
+    }
+    return -1;
 }
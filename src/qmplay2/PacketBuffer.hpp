@@ -23,9 +23,13 @@
 #include <QMutex>
 
 #include <functional>
+#include <memory>
+#include <vector>
 #include <deque>
 
-class QMPLAY2SHAREDLIB_EXPORT PacketBuffer : private std::deque<Packet>
+class TimeshiftFile;
+
+class QMPLAY2SHAREDLIB_EXPORT PacketBuffer
 {
     using IterateCallback = std::function<bool(const Packet &)>;
 
@@ -37,6 +41,19 @@ public:
         s_backwardTime = time;
     }
 
+    PacketBuffer();
+    ~PacketBuffer();
+
+    // Packets which leave the in-memory window are moved into a memory-mapped ring file
+    // instead of being dropped. "forwardTime" is the length of not yet fetched packets
+    // which are kept in memory.
+    bool enableTimeshift(const QString &dirPath, qint64 capacity, double forwardTime); //Thread-safe
+    void disableTimeshift(); //Thread-safe
+    inline bool hasTimeshift() const
+    {
+        return static_cast<bool>(m_timeshift);
+    }
+
     void iterate(const IterateCallback &cb);
 
     bool seekTo(double seekPos, bool backward);
@@ -49,7 +66,7 @@ public:
 
     inline bool isEmpty() const
     {
-        return empty();
+        return m_count == 0;
     }
 
     inline bool canFetch() const
@@ -62,20 +79,20 @@ public:
     }
     inline int packetsCount() const
     {
-        return size();
+        return m_count;
     }
 
     inline double firstPacketTime() const
     {
-        return begin()->ts();
+        return tsAt(0);
     }
     inline double currentPacketTime() const
     {
-        return at(m_pos).ts();
+        return tsAt(m_pos);
     }
     inline double lastPacketTime() const
     {
-        return (--end())->ts();
+        return tsAt(m_count - 1);
     }
 
     inline double remainingDuration() const
@@ -106,9 +123,81 @@ public:
     }
 
 private:
-    inline Packet &atPos(size_type idx);
+    struct Entry
+    {
+        Packet packet;
+        // Running totals up to and including this packet, used for O(1) accounting on seek
+        double durationSum = 0.0;
+        qint64 bytesSum = 0;
+        bool tsBackward = false; // Timestamp is lower than timestamp of the previous packet
+    };
+    struct DiskEntry
+    {
+        qint64 offset;
+        double ts;
+        double durationSum;
+        qint64 bytesSum;
+        bool keyFrame;
+        bool tsBackward;
+    };
+    struct KeyFrame
+    {
+        qint64 seq;
+        double ts;
+    };
+
+    // Packets stored on disk always precede packets stored in memory
+    inline int diskCount() const
+    {
+        return m_diskEntries.size();
+    }
+
+    // Index of in-memory packet, it doesn't include packets stored on disk
+    inline Entry &entryAt(int memIdx)
+    {
+        return m_ring[(m_head + memIdx) & (m_ring.size() - 1)];
+    }
+    inline const Entry &entryAt(int memIdx) const
+    {
+        return m_ring[(m_head + memIdx) & (m_ring.size() - 1)];
+    }
+
+    inline double tsAt(int idx) const
+    {
+        const int nDisk = diskCount();
+        return (idx < nDisk) ? m_diskEntries[idx].ts : entryAt(idx - nDisk).packet.ts();
+    }
+    inline bool hasKeyFrameAt(int idx) const;
+    Packet packetAt(int idx) const;
+
+    inline double durationBefore(int idx) const;
+    inline qint64 bytesBefore(int idx) const;
+
+    void grow();
+    void popFront();
+    void dropFront();
+
+    void moveFrontToDisk();
+
+    inline bool &tsBackwardAt(int idx);
+
+    int lowerBoundTs(int begin, int end, double ts) const;
+    int upperBoundTs(int begin, int end, double ts) const;
+
+    int findKeyFrame(int idx, bool forward, double seekPos) const;
 
 private:
+    std::vector<Entry> m_ring; // Power of two size
+    std::deque<KeyFrame> m_keyFrames; // Sorted by sequence number
+    std::unique_ptr<TimeshiftFile> m_timeshift;
+    std::deque<DiskEntry> m_diskEntries;
+    double m_timeshiftForwardTime = 0.0;
+    int m_head = 0, m_count = 0; // "m_count" includes packets stored on disk
+    qint64 m_firstSeq = 0; // Sequence number of the first packet in the buffer
+    double m_durationSumBase = 0.0; // Running totals of already removed packets
+    qint64 m_bytesSumBase = 0;
+    int m_tsBackwardCount = 0; // Binary search by timestamp is possible only if it's 0
+
     double m_remainingDuration = 0.0, m_backwardDuration = 0.0;
     qint64 m_remainingBytes = 0, m_backwardBytes = 0;
     QMutex m_mutex;
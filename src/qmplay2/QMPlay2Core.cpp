@@ -30,10 +30,14 @@
 
 #include <QLoggingCategory>
 #include <QStandardPaths>
+#include <QElapsedTimer>
 #include <QApplication>
 #include <QLibraryInfo>
+#include <QThreadPool>
 #include <QTranslator>
+#include <QDataStream>
 #include <QDateTime>
+#include <QSaveFile>
 #include <QLibrary>
 #include <QPointer>
 #include <QLocale>
@@ -52,6 +56,8 @@
 
 #include <cstdarg>
 #include <cstdio>
+#include <memory>
+#include <vector>
 
 extern "C"
 {
@@ -94,6 +100,81 @@ private:
 /**/
 
 Q_LOGGING_CATEGORY(ffmpeglog, "FFmpegLog")
+Q_LOGGING_CATEGORY(modules, "Modules", QtInfoMsg)
+
+constexpr quint32 g_modulesManifestMagic = 0x514D4D4D; // "QMMM"
+constexpr quint32 g_modulesManifestVersion = 2; // Version 1 stored API mismatch as invalid library
+
+// Cached result of loading a module file, validated by modification time and size
+struct ModuleManifestEntry
+{
+    enum State : quint8
+    {
+        Valid,
+        Invalid,
+        TooOld,
+    };
+
+    qint64 mTime = 0;
+    qint64 size = 0;
+    State state = Invalid;
+    quint32 apiVersion = 0;
+    QString name;
+
+    inline bool operator ==(const ModuleManifestEntry &other) const
+    {
+        return mTime == other.mTime && size == other.size && state == other.state && apiVersion == other.apiVersion && name == other.name;
+    }
+    inline bool operator !=(const ModuleManifestEntry &other) const
+    {
+        return !operator ==(other);
+    }
+};
+using ModulesManifest = QHash<QString, ModuleManifestEntry>; // File path, entry
+
+static ModulesManifest readModulesManifest(const QString &filePath)
+{
+    QFile f(filePath);
+    if (!f.open(QFile::ReadOnly))
+        return {};
+
+    QDataStream stream(&f);
+
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != g_modulesManifestMagic || version != g_modulesManifestVersion || stream.status() != QDataStream::Ok || count < 0)
+        return {};
+
+    ModulesManifest manifest;
+    for (qint32 i = 0; i < count; ++i)
+    {
+        QString filePath;
+        ModuleManifestEntry entry;
+        quint8 state = 0;
+        stream >> filePath >> entry.mTime >> entry.size >> state >> entry.apiVersion >> entry.name;
+        if (stream.status() != QDataStream::Ok || state > ModuleManifestEntry::TooOld)
+            return {};
+        entry.state = static_cast<ModuleManifestEntry::State>(state);
+        manifest.insert(filePath, entry);
+    }
+    return manifest;
+}
+static void writeModulesManifest(const QString &filePath, const ModulesManifest &manifest)
+{
+    QSaveFile f(filePath);
+    if (!f.open(QFile::WriteOnly))
+        return;
+
+    QDataStream stream(&f);
+    stream << g_modulesManifestMagic << g_modulesManifestVersion << static_cast<qint32>(manifest.size());
+    for (auto it = manifest.cbegin(), itEnd = manifest.cend(); it != itEnd; ++it)
+    {
+        const ModuleManifestEntry &entry = it.value();
+        stream << it.key() << entry.mTime << entry.size << static_cast<quint8>(entry.state) << entry.apiVersion << entry.name;
+    }
+    f.commit();
+}
 
 static void avQMPlay2LogHandler(void *avcl, int level, const char *fmt, va_list vl)
 {
@@ -324,7 +405,6 @@ void QMPlay2CoreClass::init(bool loadModulesAndGpu, bool modulesInSubdirs, const
 #elif defined(USE_OPENGL)
         settings->init("Renderer", "opengl");
 #endif
-        m_gpuInstance = GPUInstance::create();
 
         QFileInfoList pluginsList;
         QDir(settingsDir).mkdir("Modules");
@@ -346,68 +426,154 @@ void QMPlay2CoreClass::init(bool loadModulesAndGpu, bool modulesInSubdirs, const
                         pluginsList += fInfo;
         }
 
-        QStringList pluginsName;
+        QElapsedTimer modulesTimer;
+        modulesTimer.start();
+
+        const auto checkModuleAPIVersion = [this](const QFileInfo &fInfo, const quint32 v)->bool {
+            const quint8 moduleApiVersion = (v & 0xFF);
+            if (moduleApiVersion != QMPLAY2_MODULES_API_VERSION)
+            {
+                log(fInfo.fileName() + " - " + tr("mismatch module API version"), AddTimeToLog | ErrorLog | SaveLog);
+                return false;
+            }
+            const quint8 qtMajorVersion = ((v >> 24) & 0xFF);
+            const quint8 qtMinorVersion = ((v >> 16) & 0xFF);
+            if (qtMajorVersion != QT_VERSION_MAJOR || qtMinorVersion < QT_VERSION_MINOR)
+            {
+                log(fInfo.fileName() + " - " + tr("mismatch module Qt version"), AddTimeToLog | ErrorLog | SaveLog);
+                return false;
+            }
+            return true;
+        };
+        const auto logInvalidLibrary = [this](const QFileInfo &fInfo, bool tooOld) {
+#ifndef Q_OS_ANDROID
+            if (tooOld)
+                log(fInfo.fileName() + " - " + tr("too old QMPlay2 library"), AddTimeToLog | ErrorLog | SaveLog);
+            else
+                log(fInfo.fileName() + " - " + tr("invalid QMPlay2 library"), AddTimeToLog | ErrorLog | SaveLog);
+#else
+            Q_UNUSED(fInfo)
+            Q_UNUSED(tooOld)
+#endif
+        };
+
+        // Files which are known from the manifest to be invalid or incompatible are not loaded at all
+        const QString manifestFilePath = settingsDir + "ModulesManifest.bin";
+        const ModulesManifest oldManifest = readModulesManifest(manifestFilePath);
+        ModulesManifest manifest;
+
+        struct ModuleFile
+        {
+            QFileInfo fInfo;
+            std::unique_ptr<QLibrary> lib;
+            bool loaded = false;
+            qint64 loadTime = 0;
+        };
+        std::vector<ModuleFile> moduleFiles;
         for (const QFileInfo &fInfo : std::as_const(pluginsList))
         {
-            if (QLibrary::isLibrary(fInfo.filePath()))
+            if (!QLibrary::isLibrary(fInfo.filePath()))
+                continue;
+
+            const auto it = oldManifest.constFind(fInfo.filePath());
+            if (it != oldManifest.cend() && it->mTime == fInfo.lastModified().toMSecsSinceEpoch() && it->size == fInfo.size())
+            {
+                const ModuleManifestEntry &entry = it.value();
+                manifest.insert(fInfo.filePath(), entry);
+                if (entry.state != ModuleManifestEntry::Valid)
+                {
+                    logInvalidLibrary(fInfo, entry.state == ModuleManifestEntry::TooOld);
+                    continue;
+                }
+                if (!checkModuleAPIVersion(fInfo, entry.apiVersion))
+                    continue;
+            }
+
+            moduleFiles.push_back({fInfo, std::make_unique<QLibrary>(fInfo.filePath())});
+        }
+
+        // Load libraries in background while GPU instance is being created
+        QThreadPool modulesThreadPool;
+        for (ModuleFile &moduleFile : moduleFiles)
+        {
+            modulesThreadPool.start([&moduleFile] {
+                QElapsedTimer timer;
+                timer.start();
+                moduleFile.loaded = moduleFile.lib->load();
+                moduleFile.loadTime = timer.elapsed();
+            });
+        }
+
+        m_gpuInstance = GPUInstance::create();
+        qCDebug(modules) << "GPU instance created in" << modulesTimer.elapsed() << "ms";
+
+        modulesThreadPool.waitForDone();
+
+        // Modules are created in the original order, because it decides which one wins on duplicated names
+        QStringList pluginsName;
+        for (ModuleFile &moduleFile : moduleFiles)
+        {
+            const QFileInfo &fInfo = moduleFile.fInfo;
+            QLibrary &lib = *moduleFile.lib;
+            if (!moduleFile.loaded)
             {
-                QLibrary lib(fInfo.filePath());
-                if (!lib.load())
-                    log(lib.errorString(), AddTimeToLog | ErrorLog | SaveLog);
+                log(lib.errorString(), AddTimeToLog | ErrorLog | SaveLog);
+                continue;
+            }
+
+            using CreateQMPlay2ModuleInstance = Module  *(*)();
+            using GetQMPlay2ModuleAPIVersion  = quint32  (*)();
+
+            GetQMPlay2ModuleAPIVersion  getQMPlay2ModuleAPIVersion  = (GetQMPlay2ModuleAPIVersion )lib.resolve("getQMPlay2ModuleAPIVersion" );
+            CreateQMPlay2ModuleInstance createQMPlay2ModuleInstance = (CreateQMPlay2ModuleInstance)lib.resolve("createQMPlay2ModuleInstance");
+
+            ModuleManifestEntry manifestEntry;
+            manifestEntry.mTime = fInfo.lastModified().toMSecsSinceEpoch();
+            manifestEntry.size = fInfo.size();
+
+            if (!getQMPlay2ModuleAPIVersion || !createQMPlay2ModuleInstance)
+            {
+                manifestEntry.state = lib.resolve("qmplay2PluginInstance") ? ModuleManifestEntry::TooOld : ModuleManifestEntry::Invalid;
+                manifest.insert(fInfo.filePath(), manifestEntry);
+                logInvalidLibrary(fInfo, manifestEntry.state == ModuleManifestEntry::TooOld);
+                continue;
+            }
+
+            manifestEntry.apiVersion = getQMPlay2ModuleAPIVersion();
+            if (!checkModuleAPIVersion(fInfo, manifestEntry.apiVersion))
+            {
+                // The library itself is fine, API version is checked again on every start, because the core can change
+                manifestEntry.state = ModuleManifestEntry::Valid;
+                manifest.insert(fInfo.filePath(), manifestEntry);
+                continue;
+            }
+
+            QElapsedTimer createTimer;
+            createTimer.start();
+            if (Module *moduleInstance = createQMPlay2ModuleInstance())
+            {
+                const QString name = moduleInstance->name();
+                manifestEntry.state = ModuleManifestEntry::Valid;
+                manifestEntry.name = name;
+                manifest.insert(fInfo.filePath(), manifestEntry);
+                if (pluginsName.contains(name))
+                {
+                    log(fInfo.fileName() + " (" + name + ") - " + tr("duplicated module name"), AddTimeToLog | ErrorLog | SaveLog);
+                    delete moduleInstance;
+                }
                 else
                 {
-                    using CreateQMPlay2ModuleInstance = Module  *(*)();
-                    using GetQMPlay2ModuleAPIVersion  = quint32  (*)();
-
-                    GetQMPlay2ModuleAPIVersion  getQMPlay2ModuleAPIVersion  = (GetQMPlay2ModuleAPIVersion )lib.resolve("getQMPlay2ModuleAPIVersion" );
-                    CreateQMPlay2ModuleInstance createQMPlay2ModuleInstance = (CreateQMPlay2ModuleInstance)lib.resolve("createQMPlay2ModuleInstance");
-
-                    const auto checkModuleAPIVersion = [&](const quint32 v)->bool {
-                        const quint8 moduleApiVersion = (v & 0xFF);
-                        if (moduleApiVersion != QMPLAY2_MODULES_API_VERSION)
-                        {
-                            log(fInfo.fileName() + " - " + tr("mismatch module API version"), AddTimeToLog | ErrorLog | SaveLog);
-                            return false;
-                        }
-                        const quint8 qtMajorVersion = ((v >> 24) & 0xFF);
-                        const quint8 qtMinorVersion = ((v >> 16) & 0xFF);
-                        if (qtMajorVersion != QT_VERSION_MAJOR || qtMinorVersion < QT_VERSION_MINOR)
-                        {
-                            log(fInfo.fileName() + " - " + tr("mismatch module Qt version"), AddTimeToLog | ErrorLog | SaveLog);
-                            return false;
-                        }
-                        return true;
-                    };
-
-                    if (!getQMPlay2ModuleAPIVersion || !createQMPlay2ModuleInstance)
-                    {
-#ifndef Q_OS_ANDROID
-                        if (lib.resolve("qmplay2PluginInstance"))
-                            log(fInfo.fileName() + " - " + tr("too old QMPlay2 library"), AddTimeToLog | ErrorLog | SaveLog);
-                        else
-                            log(fInfo.fileName() + " - " + tr("invalid QMPlay2 library"), AddTimeToLog | ErrorLog | SaveLog);
-#endif
-                    }
-                    else if (checkModuleAPIVersion(getQMPlay2ModuleAPIVersion()))
-                    {
-                        if (Module *moduleInstance = createQMPlay2ModuleInstance())
-                        {
-                            const QString name = moduleInstance->name();
-                            if (pluginsName.contains(name))
-                            {
-                                log(fInfo.fileName() + " (" + name + ") - " + tr("duplicated module name"), AddTimeToLog | ErrorLog | SaveLog);
-                                delete moduleInstance;
-                            }
-                            else
-                            {
-                                pluginsName += moduleInstance->name();
-                                pluginsInstance += moduleInstance;
-                            }
-                        }
-                    }
+                    qCDebug(modules).nospace() << name << ": loaded in " << moduleFile.loadTime << " ms, initialized in " << createTimer.elapsed() << " ms";
+                    pluginsName += name;
+                    pluginsInstance += moduleInstance;
                 }
             }
         }
+
+        qCDebug(modules) << "Modules loaded in" << modulesTimer.elapsed() << "ms";
+
+        if (manifest != oldManifest)
+            writeModulesManifest(manifestFilePath, manifest);
     }
 
     connect(this, SIGNAL(restoreCursor()), this, SLOT(restoreCursorSlot()));
@@ -176,9 +176,20 @@ void SndResampler::convert(const QByteArray &src, QByteArray &dst, bool flush)
 #else
     if (m_keepPitch)
     {
-        QVarLengthArray<QByteArray, 8> tmpQ(m_dstChannels);
         QVarLengthArray<quint8 *, 8> tmp(m_dstChannels);
 
+        // Buffers only grow, so there are no allocations during the playback
+        m_rubberBandBuffers.resize(m_dstChannels);
+        const auto prepareBuffers = [&](const int samples) {
+            for (int i = 0; i < m_dstChannels; ++i)
+            {
+                auto &buffer = m_rubberBandBuffers[i];
+                if (buffer.size() < static_cast<size_t>(samples))
+                    buffer.resize(samples);
+                tmp[i] = reinterpret_cast<quint8 *>(buffer.data());
+            }
+        };
+
         if (!m_rubberBandStretcher)
         {
             RubberBandStretcher::Options options = RubberBandStretcher::OptionProcessRealTime | RubberBandStretcher::OptionChannelsTogether;
@@ -204,16 +215,12 @@ void SndResampler::convert(const QByteArray &src, QByteArray &dst, bool flush)
         {
             const quint8 *in[] = {(const quint8 *)src.constData()};
 
-            for (int i = 0; i < m_dstChannels; ++i)
-            {
-                tmpQ[i] = QByteArray(possibleSwrSize * sizeof(float), Qt::Uninitialized);
-                tmp[i] = reinterpret_cast<quint8 *>(tmpQ[i].data());
-            }
+            prepareBuffers(possibleSwrSize);
 
             const int converted = swr_convert(m_sndConvertCtx, tmp.data(), possibleSwrSize, in, inSize);
             if (converted <= 0)
             {
-                dst.clear();
+                dst.resize(0);
                 return;
             }
 
@@ -229,21 +236,15 @@ void SndResampler::convert(const QByteArray &src, QByteArray &dst, bool flush)
         const int available = m_rubberBandStretcher->available();
         if (available <= 0)
         {
-            dst.clear();
+            dst.resize(0);
             return;
         }
 
-        for (int i = 0; i < m_dstChannels; ++i)
-        {
-            const int newSize = available * sizeof(float);
-            if (tmpQ[i].size() < newSize)
-                tmpQ[i] = QByteArray(available * sizeof(float), Qt::Uninitialized);
-            tmp[i] = reinterpret_cast<quint8 *>(tmpQ[i].data());
-        }
+        prepareBuffers(available);
 
         m_rubberBandStretcher->retrieve(reinterpret_cast<float *const *>(tmp.constData()), available);
 
-        dst = QByteArray(available * sizeof(float) * m_dstChannels, Qt::Uninitialized);
+        dst.resize(available * sizeof(float) * m_dstChannels);
         auto dstF = reinterpret_cast<float *>(dst.data());
         for (int c = 0; c < m_dstChannels; ++c)
         {
@@ -268,7 +269,7 @@ void SndResampler::convert(const QByteArray &src, QByteArray &dst, bool flush)
         if (converted > 0)
             dst.resize(converted * sizeof(float) * m_dstChannels);
         else
-            dst.clear();
+            dst.resize(0);
     }
 }
 
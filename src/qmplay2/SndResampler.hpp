@@ -21,6 +21,7 @@
 #include <QMPlay2Lib.hpp>
 
 #include <memory>
+#include <vector>
 
 class QByteArray;
 struct SwrContext;
@@ -58,6 +59,7 @@ public:
 private:
     SwrContext *m_sndConvertCtx = nullptr;
     std::unique_ptr<RubberBand::RubberBandStretcher> m_rubberBandStretcher;
+    std::vector<std::vector<float>> m_rubberBandBuffers; // Reused planar buffers
     bool m_keepPitch = false;
     int m_srcSamplerate = 0;
     int m_srcChannels = 0;
@@ -22,9 +22,17 @@
 #include <Packet.hpp>
 
 #include <QLoggingCategory>
+#include <QFile>
 
 #include <unordered_map>
 
+#ifdef Q_OS_WIN
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
 Q_LOGGING_CATEGORY(mux, "StreamMuxer")
 
 extern "C"
@@ -39,6 +47,52 @@ extern "C"
 
 using namespace std;
 
+// Packets are written to the file in big chunks
+constexpr int g_ioBufferSize = 256 * 1024;
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+static int writeQFile(void *opaque, const uint8_t *buf, int bufSize)
+#else
+static int writeQFile(void *opaque, uint8_t *buf, int bufSize)
+#endif
+{
+    auto &f = *static_cast<QFile *>(opaque);
+    if (f.write(reinterpret_cast<const char *>(buf), bufSize) != bufSize)
+        return AVERROR(EIO);
+    return bufSize;
+}
+static int64_t seekQFile(void *opaque, int64_t offset, int whence)
+{
+    auto &f = *static_cast<QFile *>(opaque);
+    switch (whence & ~AVSEEK_FORCE)
+    {
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            offset += f.pos();
+            break;
+        case SEEK_END:
+            offset += f.size();
+            break;
+        case AVSEEK_SIZE:
+            return f.size();
+        default:
+            return AVERROR(EINVAL);
+    }
+    if (!f.seek(offset))
+        return AVERROR(EIO);
+    return f.pos();
+}
+
+static bool syncQFile(QFile &f)
+{
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(f.handle())));
+#else
+    return (fsync(f.handle()) == 0);
+#endif
+}
+
 struct StreamData
 {
     int64_t lastDts = AV_NOPTS_VALUE;
@@ -47,6 +101,7 @@ struct StreamData
 
 struct StreamMuxer::Priv
 {
+    QFile file;
     AVFormatContext *ctx = nullptr;
     AVPacket *pkt = nullptr;
     bool streamRecording = false;
@@ -60,8 +115,23 @@ StreamMuxer::StreamMuxer(const QString &fileName, const QList<StreamInfo *> &str
     p.streamRecording = streamRecording;
     if (avformat_alloc_output_context2(&p.ctx, nullptr, format.toLatin1().constData(), nullptr) < 0)
         return;
-    if (avio_open(&p.ctx->pb, fileName.toUtf8(), AVIO_FLAG_WRITE) < 0)
+    p.file.setFileName(fileName);
+    if (!p.file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered))
+        return;
+    if (auto ioBuffer = static_cast<uint8_t *>(av_malloc(g_ioBufferSize)))
+    {
+        p.ctx->pb = avio_alloc_context(ioBuffer, g_ioBufferSize, true, &p.file, nullptr, writeQFile, seekQFile);
+        if (!p.ctx->pb)
+        {
+            av_free(ioBuffer);
+            return;
+        }
+    }
+    else
+    {
         return;
+    }
+    p.ctx->flush_packets = 0; // Don't flush after every packet, see "flush()"
     bool isRawVideo = false;
     for (StreamInfo *streamInfo : streamsInfo)
     {
@@ -146,11 +216,13 @@ StreamMuxer::~StreamMuxer()
                 av_write_trailer(p.ctx);
                 av_packet_free(&p.pkt);
             }
-            avio_close(p.ctx->pb);
-            p.ctx->pb = nullptr;
+            avio_flush(p.ctx->pb);
+            av_freep(&p.ctx->pb->buffer);
+            avio_context_free(&p.ctx->pb);
         }
         avformat_free_context(p.ctx);
     }
+    delete &p;
 }
 
 bool StreamMuxer::isOk() const
@@ -220,3 +292,15 @@ bool StreamMuxer::write(const Packet &packet, const int idx)
     const int err = av_interleaved_write_frame(p.ctx, p.pkt);
     return (err == 0);
 }
+
+bool StreamMuxer::flush(bool sync)
+{
+    if (!isOk())
+        return false;
+
+    avio_flush(p.ctx->pb);
+    if (p.ctx->pb->error < 0)
+        return false;
+
+    return !sync || syncQFile(p.file);
+}
@@ -42,6 +42,9 @@ public:
     bool setFirstDts(const Packet &packet, const int idx);
     bool write(const Packet &packet, const int idx);
 
+    // Writes buffered data to the file, "sync" also waits until it is stored on the disk
+    bool flush(bool sync);
+
 private:
     Priv &p;
 };
@@ -0,0 +1,161 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <TimeshiftFile.hpp>
+
+#include <Packet.hpp>
+
+#include <QLoggingCategory>
+#include <QStandardPaths>
+#include <QDir>
+
+#include <cstring>
+
+Q_LOGGING_CATEGORY(timeshift, "Timeshift")
+
+namespace {
+
+struct RecordHeader
+{
+    qint64 pts;
+    qint64 dts;
+    qint64 duration;
+    AVRational timeBase;
+    qint32 size;
+    qint32 flags;
+};
+
+constexpr qint64 g_alignment = alignof(RecordHeader);
+
+constexpr auto g_filePrefix = "QMPlay2_timeshift_";
+
+inline qint64 recordSize(int packetSize)
+{
+    return (sizeof(RecordHeader) + packetSize + g_alignment - 1) & ~(g_alignment - 1);
+}
+
+}
+
+QString TimeshiftFile::dirPath()
+{
+    QString dirPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (dirPath.isEmpty() || !QDir(dirPath).mkpath("."))
+        dirPath = QDir::tempPath();
+    return dirPath;
+}
+void TimeshiftFile::removeStaleFiles()
+{
+    QDir dir(dirPath());
+    for (auto &&fileName : dir.entryList({QString(g_filePrefix) + "*"}, QDir::Files | QDir::Hidden))
+    {
+        if (!dir.remove(fileName))
+            qCWarning(timeshift) << "Can't remove stale file" << dir.filePath(fileName);
+    }
+}
+
+TimeshiftFile::TimeshiftFile(const QString &dirPath, qint64 capacity)
+    : m_file(dirPath + "/" + g_filePrefix + "XXXXXX")
+{
+    if (!m_file.open())
+    {
+        qCWarning(timeshift) << "Can't create file in" << dirPath;
+        return;
+    }
+    if (!m_file.resize(capacity) || !(m_data = m_file.map(0, capacity)))
+    {
+        qCWarning(timeshift) << "Can't map" << capacity << "bytes of" << m_file.fileName();
+        return;
+    }
+    m_capacity = capacity;
+}
+TimeshiftFile::~TimeshiftFile()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+}
+
+void TimeshiftFile::reset()
+{
+    m_writePos = 0;
+}
+
+qint64 TimeshiftFile::write(const Packet &packet, qint64 tail)
+{
+    if (!m_data || packet.hasFrame())
+        return -1;
+
+    const qint64 size = recordSize(packet.size());
+
+    if (tail < 0)
+        m_writePos = 0;
+
+    qint64 offset = -1;
+    if (tail < 0 || m_writePos > tail)
+    {
+        if (m_capacity - m_writePos >= size)
+            offset = m_writePos;
+        else if (tail >= size)
+            offset = 0; // Wrap around, the end of the file stays unused
+    }
+    else if (tail - m_writePos >= size)
+    {
+        offset = m_writePos;
+    }
+    if (offset < 0)
+        return -1;
+
+    const AVPacket *avPacket = packet;
+
+    RecordHeader header;
+    header.pts = avPacket->pts;
+    header.dts = avPacket->dts;
+    header.duration = avPacket->duration;
+    header.timeBase = packet.timeBase();
+    header.size = avPacket->size;
+    header.flags = avPacket->flags;
+
+    memcpy(m_data + offset, &header, sizeof(header));
+    if (header.size > 0)
+        memcpy(m_data + offset + sizeof(header), avPacket->data, header.size);
+
+    m_writePos = offset + size;
+    return offset;
+}
+Packet TimeshiftFile::read(qint64 offset) const
+{
+    Q_ASSERT(m_data && offset >= 0 && offset < m_capacity);
+
+    RecordHeader header;
+    memcpy(&header, m_data + offset, sizeof(header));
+
+    AVPacket *avPacket = av_packet_alloc();
+    if (av_new_packet(avPacket, header.size) == 0)
+    {
+        if (header.size > 0)
+            memcpy(avPacket->data, m_data + offset + sizeof(header), header.size);
+        avPacket->pts = header.pts;
+        avPacket->dts = header.dts;
+        avPacket->duration = header.duration;
+        avPacket->flags = header.flags;
+    }
+
+    Packet packet(avPacket);
+    packet.setTimeBase(header.timeBase);
+    av_packet_free(&avPacket);
+    return packet;
+}
@@ -0,0 +1,61 @@
+/*
+    QMPlay2 is a video and audio player.
+    Copyright (C) 2010-2026  Błażej Szczygieł
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QMPlay2Lib.hpp>
+
+#include <QTemporaryFile>
+
+class Packet;
+
+/*
+ * Fixed size ring of packets in a memory-mapped temporary file. The file doesn't
+ * track which records are still in use - the caller passes the offset of the
+ * oldest record it wants to keep, so stored packets are dropped in FIFO order.
+ */
+class QMPLAY2SHAREDLIB_EXPORT TimeshiftFile
+{
+    Q_DISABLE_COPY(TimeshiftFile)
+
+public:
+    static QString dirPath();
+    // Removes files left by a crashed instance
+    static void removeStaleFiles();
+
+    TimeshiftFile(const QString &dirPath, qint64 capacity);
+    ~TimeshiftFile();
+
+    inline bool isOpen() const
+    {
+        return (m_data != nullptr);
+    }
+
+    void reset();
+
+    // Returns the offset of the stored packet or -1 if there is no free space
+    // before "tail" (offset of the oldest packet to keep, -1 if nothing is kept).
+    qint64 write(const Packet &packet, qint64 tail);
+    Packet read(qint64 offset) const;
+
+private:
+    QTemporaryFile m_file;
+    uchar *m_data = nullptr;
+    qint64 m_capacity = 0;
+    qint64 m_writePos = 0;
+};
@@ -18,8 +18,14 @@
 
 #include <VideoFilter.hpp>
 
+#include <QThreadPool>
+#include <QSemaphore>
 #include <QDebug>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 #ifdef USE_VULKAN
 #   include <QMPlay2Core.hpp>
 
@@ -32,6 +38,65 @@
 #   include <vulkan/VulkanHWInterop.hpp>
 #endif
 
+// Avoid splitting too small planes, the overhead would be higher than the gain
+constexpr int g_minRowsPerSlice = 16;
+
+static QThreadPool &slicesThreadPool()
+{
+    static QThreadPool threadPool;
+    static const bool initialized = [] {
+        threadPool.setObjectName("VideoFiltersSlices");
+        threadPool.setMaxThreadCount(std::min(QThread::idealThreadCount(), 18));
+        return true;
+    }();
+    Q_UNUSED(initialized)
+    return threadPool;
+}
+
+/**/
+
+int VideoFilter::sliceJobsCount(int rows)
+{
+    return std::clamp(rows / g_minRowsPerSlice, 1, slicesThreadPool().maxThreadCount());
+}
+void VideoFilter::processSlices(int jobsCount, const SliceFn &fn)
+{
+    if (jobsCount <= 1)
+    {
+        fn(0, 1);
+        return;
+    }
+
+    // Slices are taken from a shared counter, so the calling thread can process all of them
+    // when the pool is busy with other filters. The state outlives this function, because
+    // pool tasks can start after all slices are already done.
+    struct Jobs
+    {
+        SliceFn fn;
+        std::atomic_int next {0};
+        int count = 0;
+        QSemaphore done;
+    };
+    auto jobs = std::make_shared<Jobs>();
+    jobs->fn = fn;
+    jobs->count = jobsCount;
+
+    const auto work = [jobs] {
+        for (int jobId; (jobId = jobs->next.fetch_add(1)) < jobs->count;)
+        {
+            jobs->fn(jobId, jobs->count);
+            jobs->done.release();
+        }
+    };
+
+    auto &threadPool = slicesThreadPool();
+    for (int i = 1; i < jobsCount; ++i)
+        threadPool.start(work);
+    work();
+
+    jobs->done.acquire(jobsCount);
+}
+
 VideoFilter::VideoFilter(bool fillDefaultSupportedPixelFormats)
 {
 #ifdef USE_VULKAN
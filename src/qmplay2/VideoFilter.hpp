@@ -24,9 +24,10 @@
 
 #include <QQueue>
 
-#ifdef USE_VULKAN
 #include <functional>
 
+#ifdef USE_VULKAN
+
 namespace QmVk {
 class Device;
 class Queue;
@@ -45,6 +46,8 @@ protected:
 #endif
 
 public:
+    using SliceFn = std::function<void(int jobId, int jobsCount)>;
+
     enum DeintFlags
     {
         AutoDeinterlace = 0x1,
@@ -64,6 +67,11 @@ public:
     virtual bool filter(QQueue<Frame> &framesQueue) = 0;
 
 protected:
+    // Splits CPU work into row slices processed on the shared filters thread pool,
+    // "jobsCount" should be taken from "sliceJobsCount()" for the smallest plane.
+    static int sliceJobsCount(int rows);
+    static void processSlices(int jobsCount, const SliceFn &fn);
+
     void processParamsDeint();
 
     void addFramesToInternalQueue(QQueue<Frame> &framesQueue);
@@ -21,11 +21,24 @@
 #include <Frame.hpp>
 #include <Module.hpp>
 
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#   include <arm_neon.h>
+#endif
+
+/*
+ * Each filter runs in its own thread, so the next filter can process frame "k"
+ * while the previous one is already working on frame "k + 1". All stages share
+ * "VideoFilters::bufferMutex" which protects their input queues and the output.
+ */
 class VideoFiltersThr final : public QThread
 {
 public:
-    VideoFiltersThr(VideoFilters &videoFilters) :
-        videoFilters(videoFilters)
+    VideoFiltersThr(VideoFilters &videoFilters, const std::shared_ptr<VideoFilter> &filter, VideoFiltersThr *nextStage) :
+        videoFilters(videoFilters),
+        filter(filter),
+        nextStage(nextStage)
     {
         setObjectName("VideoFiltersThr");
     }
@@ -36,127 +49,144 @@ public:
 
     void start()
     {
-        br = filtering = false;
+        br = false;
         QThread::start();
     }
     void stop()
     {
         {
-            QMutexLocker locker(&mutex);
+            QMutexLocker locker(&videoFilters.bufferMutex);
             br = true;
             cond.wakeOne();
         }
         wait();
     }
 
-    void filterFrame(const Frame &frame)
+    // Must be called with "VideoFilters::bufferMutex" locked
+    void enqueue(QQueue<Frame> &queue)
     {
-        QMutexLocker locker(&mutex);
-        frameToFilter = frame;
-        filtering = true;
+        if (queue.isEmpty())
+            return;
+        inputQueue.append(queue);
+        queue.clear();
+        setBusy(true);
         cond.wakeOne();
     }
 
-    void waitForFinished(bool waitForAllFrames)
-    {
-        bufferMutex.lock();
-        while (filtering && !br)
-        {
-            if (!waitForAllFrames && !videoFilters.outputQueue.isEmpty())
-                break;
-            cond.wait(&bufferMutex);
-        }
-        if (waitForAllFrames)
-            bufferMutex.unlock();
-    }
-
-    QMutex bufferMutex;
 private:
     void run() override
     {
+        QMutexLocker locker(&videoFilters.bufferMutex);
         while (!br)
         {
-            QMutexLocker locker(&mutex);
-
-            if (frameToFilter.isEmpty() && !br)
-                cond.wait(&mutex);
-            if (frameToFilter.isEmpty() || br)
+            if (inputQueue.isEmpty())
+            {
+                setBusy(false);
+                cond.wait(&videoFilters.bufferMutex);
                 continue;
+            }
 
             QQueue<Frame> queue;
-            queue.enqueue(frameToFilter);
-            frameToFilter.clear();
+            queue.swap(inputQueue);
 
             bool pending = false;
             do
             {
-                for (const std::shared_ptr<VideoFilter> &vFilter : std::as_const(videoFilters.filters))
-                    pending |= vFilter->filter(queue);
-
+                locker.unlock();
+                pending = filter->filter(queue);
                 if (queue.isEmpty())
                     pending = false;
+                locker.relock();
 
+                if (nextStage)
                 {
-                    QMutexLocker locker(&bufferMutex);
-                    if (!queue.isEmpty())
-                    {
-                        videoFilters.outputQueue.append(queue);
-                        videoFilters.outputNotEmpty = true;
-                        queue.clear();
-                    }
-                    if (!pending)
-                        filtering = false;
+                    nextStage->enqueue(queue);
+                }
+                else if (!queue.isEmpty())
+                {
+                    videoFilters.outputQueue.append(queue);
+                    videoFilters.outputNotEmpty = true;
+                    queue.clear();
+                    videoFilters.bufferCond.wakeAll();
                 }
-
-                cond.wakeOne();
             } while (pending && !br);
         }
-        if (br)
+        inputQueue.clear();
+        setBusy(false);
+    }
+
+    void setBusy(bool b)
+    {
+        if (busy == b)
+            return;
+        busy = b;
+        if (busy)
+        {
+            ++videoFilters.busyStages;
+        }
+        else if (--videoFilters.busyStages == 0)
         {
-            QMutexLocker locker(&bufferMutex);
-            filtering = false;
-            cond.wakeOne();
+            videoFilters.bufferCond.wakeAll();
         }
     }
 
     VideoFilters &videoFilters;
+    const std::shared_ptr<VideoFilter> filter;
+    VideoFiltersThr *const nextStage;
 
-    bool br = false, filtering = false;
+    bool br = false, busy = false;
 
     QWaitCondition cond;
-    QMutex mutex;
 
-    Frame frameToFilter;
+    QQueue<Frame> inputQueue;
 };
 
 /**/
 
 void VideoFilters::averageTwoLines(quint8 *__restrict__ dest, const quint8 *__restrict__ src1, const quint8 *__restrict__ src2, int linesize)
 {
-    for (int i = 0; i < linesize; ++i)
-        dest[i] = (src1[i] + src2[i] + 1) >> 1; // This generates "pavgb" instruction on x86
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= linesize; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src1 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src2 + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_avg_epu8(a, b));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= linesize; i += 16)
+        vst1q_u8(dest + i, vrhaddq_u8(vld1q_u8(src1 + i), vld1q_u8(src2 + i)));
+#endif
+    for (; i < linesize; ++i)
+        dest[i] = (src1[i] + src2[i] + 1) >> 1;
 }
 
 VideoFilters::VideoFilters() :
-    filtersThr(*(new VideoFiltersThr(*this))),
     outputNotEmpty(false)
 {}
 VideoFilters::~VideoFilters()
 {
     clear();
-    delete &filtersThr;
 }
 
 void VideoFilters::start()
 {
-    if (!filters.isEmpty())
-        filtersThr.start();
+    filtersThrs.clear();
+    filtersThrs.resize(filters.count());
+    VideoFiltersThr *nextStage = nullptr;
+    for (int i = filters.count() - 1; i >= 0; --i)
+    {
+        filtersThrs[i] = std::make_unique<VideoFiltersThr>(*this, filters[i], nextStage);
+        nextStage = filtersThrs[i].get();
+    }
+    for (auto &&filtersThr : filtersThrs)
+        filtersThr->start();
 }
 void VideoFilters::clear()
 {
     if (!filters.isEmpty())
     {
-        filtersThr.stop();
+        filtersThrs.clear();
         filters.clear();
     }
     clearBuffers();
@@ -200,7 +230,7 @@ void VideoFilters::clearBuffers()
 {
     if (!filters.isEmpty())
     {
-        filtersThr.waitForFinished(true);
+        waitForFinished(true);
         for (auto &&vFilter : std::as_const(filters))
             vFilter->clearBuffer();
     }
@@ -211,7 +241,7 @@ void VideoFilters::removeLastFromInputBuffer()
 {
     if (!filters.isEmpty())
     {
-        filtersThr.waitForFinished(true);
+        waitForFinished(true);
         for (int i = filters.count() - 1; i >= 0; --i)
             if (filters[i]->removeLastFromInternalBuffer())
                 break;
@@ -220,9 +250,12 @@ void VideoFilters::removeLastFromInputBuffer()
 
 void VideoFilters::addFrame(const Frame &videoFrame)
 {
-    if (!filters.isEmpty())
+    if (!filtersThrs.empty())
     {
-        filtersThr.filterFrame(videoFrame);
+        QMutexLocker locker(&bufferMutex);
+        QQueue<Frame> queue;
+        queue.enqueue(videoFrame);
+        filtersThrs.front()->enqueue(queue);
     }
     else
     {
@@ -232,24 +265,35 @@ void VideoFilters::addFrame(const Frame &videoFrame)
 }
 bool VideoFilters::getFrame(Frame &videoFrame)
 {
-    bool locked, ret;
-    if ((locked = !filters.isEmpty()))
-        filtersThr.waitForFinished(false);
-    if ((ret = !outputQueue.isEmpty()))
+    waitForFinished(false);
+    const bool ret = !outputQueue.isEmpty();
+    if (ret)
     {
         videoFrame = outputQueue.at(0);
         outputQueue.removeFirst();
         outputNotEmpty = !outputQueue.isEmpty();
     }
-    if (locked)
-        filtersThr.bufferMutex.unlock();
+    bufferMutex.unlock();
     return ret;
 }
 
 bool VideoFilters::readyRead()
 {
-    filtersThr.waitForFinished(false);
+    waitForFinished(false);
     const bool ret = outputNotEmpty;
-    filtersThr.bufferMutex.unlock();
+    bufferMutex.unlock();
     return ret;
 }
+
+void VideoFilters::waitForFinished(bool waitForAllFrames)
+{
+    bufferMutex.lock();
+    while (busyStages > 0)
+    {
+        if (!waitForAllFrames && !outputQueue.isEmpty())
+            break;
+        bufferCond.wait(&bufferMutex);
+    }
+    if (waitForAllFrames)
+        bufferMutex.unlock();
+}
@@ -27,6 +27,7 @@
 #include <QQueue>
 
 #include <memory>
+#include <vector>
 
 class VideoFiltersThr;
 
@@ -55,8 +56,14 @@ public:
 
     bool readyRead();
 private:
+    void waitForFinished(bool waitForAllFrames);
+
     QQueue<Frame> outputQueue;
     QVector<std::shared_ptr<VideoFilter>> filters;
-    VideoFiltersThr &filtersThr;
+    std::vector<std::unique_ptr<VideoFiltersThr>> filtersThrs; // One pipeline stage per filter
+
+    QMutex bufferMutex;
+    QWaitCondition bufferCond;
+    int busyStages = 0;
     bool outputNotEmpty = false;
 };